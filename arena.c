@@ -0,0 +1,131 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+/* The strictest alignment of the basic types */
+union ArenaAlignment {
+   long l;
+   double d;
+   void* p;
+};
+
+#define ARENA_ALIGNMENT sizeof(union ArenaAlignment)
+#define ARENA_ALIGN(size) (((size) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+#define ARENA_HEADER_SIZE ARENA_ALIGN(sizeof(struct ArenaChunk))
+#define ARENA_MEMORY(chunk) ((char*)(chunk) + ARENA_HEADER_SIZE)
+
+
+/**
+ * @brief Starts a new chunk with room for at least the given size.
+ *
+ * @param arena The arena to add the chunk to.
+ * @param size The size of the allocation that did not fit in the current chunk.
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+static void add_chunk(struct Arena* arena, size_t size);
+
+
+
+static void add_chunk(struct Arena* arena, size_t size) {
+   struct ArenaChunk* chunk; /* The new chunk */
+
+   if (size < ARENA_CHUNK_SIZE)
+      size = ARENA_CHUNK_SIZE;
+
+   chunk = (struct ArenaChunk*)malloc(ARENA_HEADER_SIZE + size);
+   if (chunk == NULL) {
+      perror("Error allocating memory for arena");
+      exit(EXIT_FAILURE);
+   }
+   chunk->size = size;
+   chunk->used = 0;
+   chunk->next = arena->chunks;
+   arena->chunks = chunk;
+}
+
+
+
+void* arena_alloc(struct Arena* arena, size_t size) {
+   struct ArenaChunk* chunk; /* The chunk the memory is taken from */
+   void* memory; /* The allocated memory */
+
+   size = ARENA_ALIGN(size > 0 ? size : 1);
+   if (arena->chunks == NULL || arena->chunks->size - arena->chunks->used < size)
+      add_chunk(arena, size);
+
+   chunk = arena->chunks;
+   memory = ARENA_MEMORY(chunk) + chunk->used;
+   chunk->used += size;
+   memset(memory, 0, size);
+
+   arena->last = memory;
+   arena->last_size = size;
+   return memory;
+}
+
+
+
+void* arena_grow(struct Arena* arena, void* block, size_t old_size, size_t new_size) {
+   struct ArenaChunk* chunk = arena->chunks; /* The chunk of the last allocation */
+   size_t aligned = ARENA_ALIGN(new_size); /* The new size, as the arena allocates it */
+   void* memory; /* The grown block */
+
+   if (new_size <= old_size)
+      return block;
+
+   /* The last allocation grows in place if its chunk has room */
+   if (block != NULL && block == arena->last &&
+       (aligned <= arena->last_size || chunk->size - chunk->used >= aligned - arena->last_size)) {
+      if (aligned > arena->last_size) {
+         chunk->used += aligned - arena->last_size;
+         arena->last_size = aligned;
+      }
+      memset((char*)block + old_size, 0, new_size - old_size);
+      return block;
+   }
+
+   memory = arena_alloc(arena, new_size);
+   if (block != NULL)
+      memcpy(memory, block, old_size);
+   return memory;
+}
+
+
+
+char* arena_strdup(struct Arena* arena, const char* s) {
+   size_t length = strlen(s) + 1; /* Length of the string with its null terminator */
+   char* copy = (char*)arena_alloc(arena, length);
+
+   memcpy(copy, s, length);
+   return copy;
+}
+
+
+
+size_t arena_size(const struct Arena* arena) {
+   const struct ArenaChunk* chunk; /* The current chunk */
+   size_t size = 0; /* Total size of the chunks */
+
+   for (chunk = arena->chunks; chunk != NULL; chunk = chunk->next)
+      size += ARENA_HEADER_SIZE + chunk->size;
+   return size;
+}
+
+
+
+void free_arena(struct Arena* arena) {
+   struct ArenaChunk* chunk, * next; /* The current chunk and the one filled before it */
+
+   for (chunk = arena->chunks; chunk != NULL; chunk = next) {
+      next = chunk->next;
+      free(chunk);
+   }
+   arena->chunks = NULL;
+   arena->last = NULL;
+   arena->last_size = 0;
+}
@@ -0,0 +1,108 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_CHUNK_SIZE 65536
+
+
+
+/**
+ * @brief A block of memory that allocations are cut from, one after the other.
+ * @struct ArenaChunk
+ * @param next The chunk that was filled before this one (NULL for the first chunk).
+ * @param size The number of bytes that can be allocated from the chunk.
+ * @param used The number of bytes already allocated from the chunk.
+ *
+ * The memory of the chunk follows the structure, at ARENA_HEADER_SIZE bytes from its start.
+ */
+struct ArenaChunk {
+   struct ArenaChunk* next;
+   size_t size;
+   size_t used;
+};
+
+
+
+/**
+ * @brief A bump allocator: memory is taken from large chunks and released all at once.
+ * @struct Arena
+ *
+ * The tables and arrays of a file are allocated from the arena of its context, so nothing is
+ * freed one by one and the whole memory of the file is released with a single free_arena.
+ * A zeroed arena is empty and ready to use.
+ *
+ * @param chunks The chunk allocations are currently taken from, linked to the chunks filled before it.
+ * @param last The last allocation, which can grow in place while nothing was allocated after it.
+ * @param last_size The size of the last allocation.
+ */
+struct Arena {
+   struct ArenaChunk* chunks;
+   void* last;
+   size_t last_size;
+};
+
+
+
+/**
+ * @brief Allocates zeroed memory from an arena.
+ *
+ * @param arena The arena to allocate from.
+ * @param size The number of bytes to allocate.
+ * @return Pointer to the allocated memory, aligned for any type.
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+void* arena_alloc(struct Arena* arena, size_t size);
+
+
+
+/**
+ * @brief Grows a block allocated from an arena, keeping its content (like realloc).
+ *
+ * The last allocation of the arena grows in place when its chunk has room. Otherwise a new block
+ * is allocated and the content is copied; the old block is released with the rest of the arena.
+ *
+ * @param arena The arena the block was allocated from.
+ * @param block The block to grow (NULL to allocate a new one).
+ * @param old_size The current size of the block.
+ * @param new_size The new size of the block. The bytes added after the content are zeroed.
+ * @return Pointer to the grown block.
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+void* arena_grow(struct Arena* arena, void* block, size_t old_size, size_t new_size);
+
+
+
+/**
+ * @brief Duplicates a string into an arena.
+ *
+ * @param arena The arena to allocate from.
+ * @param s The string to duplicate.
+ * @return Pointer to the copy of the string.
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+char* arena_strdup(struct Arena* arena, const char* s);
+
+
+
+/**
+ * @brief Returns the number of bytes an arena took from the system.
+ *
+ * @param arena The arena to measure.
+ * @return The total size of its chunks, headers included.
+ */
+size_t arena_size(const struct Arena* arena);
+
+
+
+/**
+ * @brief Releases all the memory of an arena at once.
+ *
+ * @param arena The arena to release. It is left empty and can be used again.
+ */
+void free_arena(struct Arena* arena);
+
+#endif /* ARENA_H */
@@ -4,145 +4,888 @@
  * This function processes one or more assembly source files provided as command-line arguments.
  * It performs the following steps for each file:
  * 1. Reads the source file and processes macros using the pre-assembler.
- * 2. Allocates and initializes the symbols table, command code array, and data code array.
+ * 2. Allocates and initializes the context of the file: symbols table, command code array, and data code array.
  * 3. Executes the first path to analyze the source file and populate the symbols table and code arrays.
  * 4. Executes the second path to generate the final output files if no errors are encountered.
  * 5. Frees all allocated memory and handles errors appropriately.
  *
  * @param argc The number of command-line arguments.
- * @param argv An array of command-line arguments. Each argument after the program name is treated as a filename.
- * @return Returns 0 on successful execution, or 1 if no filename is provided.
+ * @param argv An array of command-line arguments. Each argument after the program name is treated as a filename,
+ *             except for `-t N` (or `-j N`) which assembles the files on N threads, and `--keep-am`
+ *             which also writes the source after macro expansion to a .am file, and `--one-pass` which
+ *             fills the label words from fixups recorded by the first path instead of running the second path,
+ *             and `--format=bin` which writes a single binary object file (.obj) instead of the .ob, .ent and .ext files,
+ *             and `--stats` which prints the timings and counters of every file (`--stats=json[:FILE]` writes
+ *             them as JSON lines to stderr or to FILE),
+ *             and `--cache-dir DIR` which copies the output files of sources assembled before from a cache directory.
+ *             `--watch DIR` assembles the sources of a directory and then every source that changes, until stopped.
+ *             `--serve PATH [-j N]` runs a server with N worker processes on a Unix domain socket instead, and
+ *             `--connect PATH` sends the rest of the command line to that server and prints its output.
+ * @return Returns 0 on successful execution, or 1 if no filename is provided or a source file cannot be read.
  */
 
 #ifdef _MSC_VER
 #define _CRT_SECURE_NO_WARNINGS
+#else
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
 #endif
 
 #include "auxiliary_functions_constants.h"
 #include "pre_assembler.h"
 #include "first_path.h"
 #include "second_path.h"
+#include "batch_scheduler.h"
+#include "assembly_cache.h"
+#include "hash_index.h"
+#include "assembler_server.h"
+#include "file_watcher.h"
+#include "language_server.h"
 
-#define INITIAL_MACRO_TABLE_SIZE 20
+#define STATS_NONE 0 /* No statistics */
+#define STATS_TEXT 1 /* Statistics as readable text (--stats) */
+#define STATS_JSON 2 /* Statistics as a JSON object on a single line (--stats=json or --stats=json:FILE) */
 
+static int keep_am = FALSE; /* TRUE to write the expanded source of every file to its .am file (--keep-am) */
+static int one_pass = FALSE; /* TRUE to resolve label operands with fixups instead of a second path (--one-pass) */
+static int object_format = OBJECT_FORMAT_TEXT; /* The format of the output files (--format=text or --format=bin) */
+static int stats_format = STATS_NONE; /* How to print the statistics of every file (--stats or --stats=json) */
+static const char* stats_path = NULL; /* The file the JSON statistics are appended to (--stats=json:FILE), or NULL for stderr */
+static FILE* stats_stream = NULL; /* The stream of the JSON statistics: stderr or the file of stats_path */
+static const char* cache_dir = NULL; /* The directory of the assembly cache (--cache-dir), or NULL without a cache */
+static const char* watch_dir = NULL; /* The directory to watch for changed sources (--watch), or NULL */
 
-int main(int argc, char* argv[]) {
-   int i, j;
 
-   /* Check if the user provided a filename */
-   if (argc < 2) {
-      printf("Usage: %s <filename>\n", argv[0]);
-      return 1;
-   }
 
-   for (i = 1; i < argc; i++)
-   {
-      char asFilename[256] = { 0 }; /* Source file name with .as extension */
-      char amFilename[256] = { 0 }; /* Destination file name with .am extension */
-      FILE* source, * dest; /* File pointers for source and destination files */
-      int macro_table_size = INITIAL_MACRO_TABLE_SIZE; /* Initial size of the macro table */
-      struct Macro* macro_table = (struct Macro*)calloc(macro_table_size, sizeof(struct Macro)); /* Macro table */
-      struct Symbol* symbols_table; /* Symbols table */
-      int symbols_table_size, cmd_capacity, data_capacity, ICF, DCF; /* Various capacities and counters */
-      int first_path_result, pre_assembler_result; /* Results of pre-assembler and first path */
-      int* cmd_code, * data_code; /* Arrays for command and data code */
-      char* filename = argv[i]; /* Current file name from command-line arguments */
-
-      /* Check memory allocation for macro table */
-      if (macro_table == NULL) {
-         perror("Error allocating memory for macro table");
-         exit(EXIT_FAILURE);
-      }
+/**
+ * @brief The content of a source file in memory.
+ * @struct SourceFile
+ * @param text The content of the file (not null-terminated).
+ * @param length The length of the content in bytes.
+ * @param mapped TRUE if the content is a memory mapping of the file, FALSE if it was read into a buffer.
+ */
+struct SourceFile {
+   char* text;
+   size_t length;
+   int mapped;
+};
+
+
+
+/**
+ * @brief The cache decision of a file of the command line, made before any file is assembled.
+ * @struct CachedFile
+ * @param filename The name of the file (without the .as extension).
+ * @param key The cache key of its source.
+ * @param hit TRUE if the cache has an entry for the key, FALSE if the file is assembled and stored.
+ */
+struct CachedFile {
+   const char* filename;
+   char key[CACHE_KEY_SIZE];
+   int hit;
+};
+
+static struct CachedFile* cached_files = NULL; /* The cache decision of every file, with --cache-dir */
+static int cached_file_count = 0; /* Number of entries in cached_files */
+static struct HashIndex cached_file_index; /* Index of cached_files by file name */
+
+
+/**
+ * @brief Assembles a single file: pre-assembler, first path, second path and output files.
+ *
+ * The expanded source stays in memory; it is written to the .am file only with `--keep-am`.
+ *
+ * @param filename The name of the file to assemble (without the .as extension).
+ * @return TRUE if the file was assembled, FALSE if its source cannot be read or an output file cannot be written
+ *         (the error is printed).
+ */
+static int assemble_file(char* filename);
+
+
+
+/**
+ * @brief Assembles a single file, collecting its console output instead of printing it.
+ *
+ * Nothing is printed, so several files can be assembled at the same time on different threads.
+ *
+ * @param filename The name of the file to assemble (without the .as extension).
+ * @param console The buffer to append the console output of the file to, or NULL to print it.
+ * @return TRUE if the file was assembled, FALSE if its source cannot be read or an output file cannot be written
+ *         (the error is in the console output).
+ */
+static int assemble_file_to(char* filename, struct TextBuffer* console);
+
+
+
+/**
+ * @brief Hands the collected console output of a file over to the caller (or prints it) and frees its context.
+ *
+ * @param ctx The context of the file.
+ * @param console The buffer to append the console output to, or NULL to print it.
+ */
+static void finish_file(struct AssemblerContext* ctx, struct TextBuffer* console);
+
+
+
+/**
+ * @brief Returns the size of the source file of a file name, for scheduling the largest files first.
+ *
+ * @param filename The name of the file (without the .as extension).
+ * @return The size of the .as file in bytes, or 0 if it cannot be found (the error is reported when it is assembled).
+ */
+static long source_size(const char* filename);
+
+
+
+/**
+ * @brief Prints how a batch was spread over the threads (`-t N` with `--stats`), in the format chosen with `--stats`.
+ *
+ * The JSON object goes to the statistics stream, like the statistics of the files.
+ *
+ * @param report The report of the batch.
+ */
+static void print_batch_report(const struct BatchReport* report);
+
+
+
+/**
+ * @brief Looks up every file of the command line in the cache, before any file is assembled.
+ *
+ * The decisions are made here, before any thread starts, so the hits and misses are counted once even
+ * when the files are assembled by threads (`-t N`). A file whose source
+ * cannot be opened gets no decision: it is assembled, and the error reported, as without a cache.
+ *
+ * @param files The file names (without extension).
+ * @param file_count Number of entries in `files`.
+ * @param hits Pointer to store the number of files found in the cache.
+ * @param misses Pointer to store the number of files not found in the cache.
+ */
+static void look_up_cache(char* files[], int file_count, int* hits, int* misses);
+
+
+
+/**
+ * @brief Returns the file name of a cache decision, for the index of the decisions.
+ *
+ * @param table The decisions (struct CachedFile).
+ * @param id The index of the decision.
+ * @return The file name of the decision.
+ */
+static const char* cached_file_name(const void* table, int id);
+
+
+
+/**
+ * @brief Finds the cache decision of a file.
+ *
+ * @param filename The name of the file (without the .as extension).
+ * @return The decision, or NULL if the file has none (no cache, or its source cannot be opened).
+ */
+static const struct CachedFile* find_cached_file(const char* filename);
+
+
+
+/**
+ * @brief Prints the number of files found and not found in the cache, in the format chosen with `--stats`.
+ *
+ * The JSON object goes to the statistics stream, like the statistics of the files.
+ *
+ * @param hits The number of files found in the cache.
+ * @param misses The number of files not found in the cache.
+ */
+static void print_cache_summary(int hits, int misses);
+
+
+
+/**
+ * @brief Opens a source file and makes its whole content available in memory.
+ *
+ * Regular files are memory-mapped, so the pre-assembler reads the lines straight from the page cache.
+ * Other files (and platforms without mmap) are read into a buffer.
+ *
+ * @param name The name of the source file.
+ * @param source The structure to fill with the content of the file.
+ * @return TRUE if the file was opened, FALSE if it cannot be opened (errno tells why).
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+static int open_source_file(const char* name, struct SourceFile* source);
+
+
+
+/**
+ * @brief Releases the content of a source file opened with open_source_file.
+ *
+ * @param source The content to release.
+ */
+static void close_source_file(struct SourceFile* source);
+
+
+
+/**
+ * @brief Reads the whole content of an open source file into memory.
+ *
+ * @param source The source file to read.
+ * @param length Pointer to store the number of bytes read.
+ * @return A newly allocated buffer with the content of the file (to be freed by the caller).
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+static char* read_source_file(FILE* source, size_t* length);
+
+
+
+/**
+ * @brief Prints the statistics of an assembled file, in the format chosen with `--stats`.
+ *
+ * The JSON format writes one object per line to the statistics stream (stderr, or the file of
+ * `--stats=json:FILE`), never to the console output, so the stream holds nothing but JSON lines:
+ * {"file":…, "result":"ok"|"errors", "lines":{…}, "time_ms":{…}, "macros":{…}, "symbols":{…},
+ *  "code_chunks":…, "bytes_written":…, "memory":{…}, "cache":"off"|"hit"|"miss"}
+ * Every line is written at once, as its file is finished, so the lines of files assembled on
+ * different threads never mix.
+ *
+ * @param ctx The context of the file, after all its phases (before it is freed). The text statistics
+ *            are reported like its other messages.
+ * @param result TRUE if no errors were found in the file, FALSE otherwise.
+ * @param cache "hit" or "miss" with `--cache-dir`, "off" without a cache.
+ */
+static void print_stats(struct AssemblerContext* ctx, int result, const char* cache);
+
+
+
+/**
+ * @brief Prints a string as a JSON string literal.
+ *
+ * @param stream The stream to print to.
+ * @param text The string to print.
+ */
+static void print_json_string(FILE* stream, const char* text);
+
+
+
+/**
+ * @brief Returns the peak resident memory of the process.
+ *
+ * @return The peak resident memory in kilobytes, or 0 if it is not available.
+ */
+static long peak_memory_kb(void);
+
+
+
+/**
+ * @brief Parses the command-line options and collects the file names.
+ *
+ * @param argc The number of command-line arguments.
+ * @param argv The command-line arguments.
+ * @param files Array to fill with the file names found in argv.
+ * @param file_count Pointer to store the number of file names found.
+ * @param threads Pointer to store the number of threads requested with `-t N` (or `-j N`).
+ * @return TRUE if the arguments are valid, FALSE otherwise.
+ */
+static int parse_arguments(int argc, char* argv[], char* files[], int* file_count, int* threads);
+
+
+
+/**
+ * @brief Runs a command line: assembles the files it names with the options it gives.
+ *
+ * This is the whole program without `--serve` and `--connect`; the server runs it for every request.
+ * Every option is reset before the arguments are parsed, so the requests of a server do not see the
+ * options of the requests before them.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments (argv[0] first).
+ * @return 0 on success, 1 if the arguments are invalid or a file could not be assembled.
+ */
+static int run_command(int argc, char* argv[]);
+
+
+
+/**
+ * @brief Runs the command line of a request to the server, in a server worker.
+ *
+ * `--watch`, `--serve`, `--connect` and `--lsp` are refused: they would keep the worker busy
+ * (a watcher or a server never returns) instead of answering the request.
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments (argv[0] first).
+ * @return The exit status of the command, or 1 if the request was refused.
+ */
+static int run_request(int argc, char* argv[]);
+
+
+
+/**
+ * @brief Runs the program as an assembler server (`--serve PATH [-j N]`).
+ *
+ * @param argc The number of arguments.
+ * @param argv The arguments, without `--serve PATH`.
+ * @param path The path of the socket.
+ * @return The exit status of the program.
+ */
+static int serve(int argc, char* argv[], const char* path);
 
-      /* Construct file names for source and destination */
-      sprintf(asFilename, "%s%s", filename, ".as");
-      sprintf(amFilename, "%s%s", filename, ".am");
 
-      /* Open source file for reading */
-      source = fopen(asFilename, "r");
-      if (source == NULL) {
-         perror("Error opening source file");
-         exit(EXIT_FAILURE);
-      }
 
-      /* Open destination file for writing */
+static int assemble_file(char* filename) {
+   return assemble_file_to(filename, NULL);
+}
+
+
+
+static int assemble_file_to(char* filename, struct TextBuffer* console) {
+   char asFilename[256] = { 0 }; /* Source file name with .as extension */
+   char amFilename[256] = { 0 }; /* Expanded source file name with .am extension */
+   FILE* dest; /* File pointer for the expanded source file */
+   struct AssemblerContext ctx; /* Tables, code arrays and counters of the file */
+   struct SourceFile source; /* Content of the source file */
+   const struct CachedFile* cached; /* The cache decision of the file, or NULL without a cache */
+   size_t start, end; /* The messages of the phases, in the collected messages */
+   int result, written = TRUE; /* TRUE if no errors were found in the file, FALSE if the .am file or an output file cannot be written */
+
+   /* Allocate the macro table, symbols table and code arrays of the file */
+   init_context(&ctx, filename);
+   ctx.one_pass = one_pass;
+   ctx.object_format = object_format;
+   cached = find_cached_file(filename);
+   ctx.capture_diagnostics = console != NULL || cached != NULL; /* The messages of the phases are cached too */
+
+   /* Construct file names for source and expanded source */
+   sprintf(asFilename, "%s%s", filename, ".as");
+   sprintf(amFilename, "%s%s", filename, ".am");
+
+   report_message(&ctx, "Processing file: %s\n", filename);
+   start = ctx.diagnostics.size;
+
+   if (cached != NULL && cached->hit &&
+       (result = cache_restore(cache_dir, cached->key, filename, keep_am, &ctx.diagnostics)) != NO) {
+      /* Found in the cache: its output files were copied, and its messages are replayed */
+      report_message(&ctx, result ? "No errors in the input file: %s, generating its output files.\n" :
+                     "Errors in the input file: %s, not generating its output files.\n", filename);
+      if (stats_format != STATS_NONE)
+         print_stats(&ctx, result, "hit");
+      finish_file(&ctx, console);
+      return TRUE;
+   }
+   ctx.diagnostics.size = start; /* Drop the messages of an entry that could not be read */
+
+   /* Map the source file into memory; a missing file is reported with the other files, not fatal */
+   if (!open_source_file(asFilename, &source)) {
+      report_message(&ctx, "Error opening source file %s: %s\n", asFilename, strerror(errno));
+      finish_file(&ctx, console);
+      return FALSE;
+   }
+
+   /* Pre-assembler, first path and second path, all in memory */
+   result = assemble_context(&ctx, source.text, source.length);
+   end = ctx.diagnostics.size;
+
+   if (keep_am) {
+      /* Write the source after macro expansion, for debugging */
       dest = fopen(amFilename, "w");
-      if (dest == NULL) {
-         perror("Error opening destination file");
-         fclose(source);
-         exit(EXIT_FAILURE);
+      if (dest != NULL) {
+         write_expanded(&ctx, dest);
+         fclose(dest);
       }
-      printf("Processing file: %s\n", filename);
-      /* Process macros using the pre-assembler */
-      pre_assembler_result = read_row_pre(amFilename, source, dest, &macro_table, &macro_table_size);
-
-      /* Close source and destination files */
-      fclose(source);
-      fclose(dest);
-   
-      /* Initialize symbols table */
-      symbols_table_size = INITIAL_SYMBOLS_TABLE_SIZE;
-      symbols_table = (struct Symbol*)calloc(symbols_table_size, sizeof(struct Symbol));
-      if (symbols_table == NULL) {
-         perror("Error allocating memory for symbols table");
-         exit(EXIT_FAILURE);
+      else {
+         report_message(&ctx, "Error opening expanded source file %s: %s\n", amFilename, strerror(errno));
+         written = FALSE;
       }
+   }
+
+   if (result) {
+      /* If no errors, generate output files */
+      report_message(&ctx, "No errors in the input file: %s, generating its output files.\n", filename);
+      if (!output(&ctx))
+         written = FALSE; /* Reported with the other messages of the file */
+   }
+   else
+      report_message(&ctx, "Errors in the input file: %s, not generating its output files.\n", filename);
+
+   if (cached != NULL && written) /* Store the output files for the next runs */
+      cache_store(cache_dir, cached->key, &ctx, result, ctx.diagnostics.text + start, end - start);
 
-      /* Clear symbols table entries */
-      for (j = 0; j < symbols_table_size; j++) {
-         memset(symbols_table[j].name, 0, sizeof(symbols_table[j].name));
-         memset(symbols_table[j].type, 0, sizeof(symbols_table[j].type));
-         symbols_table[j].extern_address = NULL;
+   if (stats_format != STATS_NONE)
+      print_stats(&ctx, result, cached != NULL ? "miss" : "off");
+
+   /* Free the source and the tables and code arrays of the file */
+   close_source_file(&source);
+   finish_file(&ctx, console);
+   return written;
+}
+
+
+
+static void finish_file(struct AssemblerContext* ctx, struct TextBuffer* console) {
+   if (console != NULL) /* Hand the collected output over to the caller */
+      append_text(console, ctx->diagnostics.text != NULL ? ctx->diagnostics.text : "", ctx->diagnostics.size);
+   else if (ctx->capture_diagnostics) /* Collected only for the cache: print it now */
+      fwrite(ctx->diagnostics.text, 1, ctx->diagnostics.size, stdout);
+   free_context(ctx);
+}
+
+
+
+static int open_source_file(const char* name, struct SourceFile* source) {
+   FILE* file; /* The source file, when it is read into a buffer */
+#ifndef _MSC_VER
+   struct stat info; /* Type and size of the file */
+   int fd; /* Descriptor of the file */
+
+   fd = open(name, O_RDONLY);
+   if (fd < 0)
+      return FALSE;
+   if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+      source->text = (char*)mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (source->text != MAP_FAILED) { /* Mapped: nothing else to read */
+         source->length = (size_t)info.st_size;
+         source->mapped = TRUE;
+         close(fd);
+         return TRUE;
       }
+   }
+   close(fd);
+#endif
 
-      /* Initialize command and data code arrays */
-      cmd_capacity = INITIAL_CMD_CODE_SIZE;
-      data_capacity = INITIAL_DATA_CODE_SIZE;
+   /* Empty, special or unmappable file: read it into a buffer */
+   file = fopen(name, "r");
+   if (file == NULL)
+      return FALSE;
+   source->text = read_source_file(file, &source->length);
+   source->mapped = FALSE;
+   fclose(file);
+   return TRUE;
+}
 
-      cmd_code = (int*)calloc(cmd_capacity, sizeof(int));
-      data_code = (int*)calloc(data_capacity, sizeof(int));
-      if (cmd_code == NULL || data_code == NULL) {
-         perror("Error allocating memory for cmd_code or data_code arrays");
-         exit(EXIT_FAILURE);
+
+
+static void close_source_file(struct SourceFile* source) {
+#ifndef _MSC_VER
+   if (source->mapped) {
+      munmap(source->text, source->length);
+      return;
+   }
+#endif
+   free(source->text);
+}
+
+
+
+static char* read_source_file(FILE* source, size_t* length) {
+   size_t capacity, n; /* Size of the buffer and number of bytes read */
+   char* text, * new_text; /* Buffer for the content of the file */
+
+   capacity = INITIAL_TEXT_BUFFER_SIZE, *length = 0;
+   text = (char*)malloc(capacity);
+   if (text == NULL) {
+      perror("Error allocating memory for source file");
+      exit(EXIT_FAILURE);
+   }
+
+   while ((n = fread(text + *length, 1, capacity - *length, source)) > 0) {
+      *length += n;
+      if (*length == capacity) { /* The buffer is full, double it */
+         capacity *= 2;
+         new_text = (char*)realloc(text, capacity);
+         if (new_text == NULL) {
+            perror("Error reallocating memory for source file");
+            exit(EXIT_FAILURE);
+         }
+         text = new_text;
       }
-      
-      /* Perform first and second paths if pre-assembler succeeded */
-      if(pre_assembler_result) {
-         first_path_result = first_path(filename, macro_table, macro_table_size, &symbols_table, &symbols_table_size,
-            &cmd_code, cmd_capacity, &ICF, &data_code, data_capacity, &DCF);
+   }
+   return text;
+}
+
+
+
+static void print_stats(struct AssemblerContext* ctx, int result, const char* cache) {
+   const struct AssemblerStats* stats = &ctx->stats; /* The statistics of the file */
+   double total = 0; /* Total time of the phases, in seconds */
+   int i; /* Phase index */
+
+   for (i = 0; i < STATS_PHASE_COUNT; i++)
+      total += stats->phase_time[i];
+
+   if (stats_format == STATS_JSON) {
+#ifndef _MSC_VER
+      flockfile(stats_stream); /* The whole line at once, also from the threads of -t */
+#endif
+      fprintf(stats_stream, "{\"file\":");
+      print_json_string(stats_stream, ctx->fileName);
+      fprintf(stats_stream, ",\"result\":\"%s\"", result ? "ok" : "errors");
+      fprintf(stats_stream, ",\"lines\":{\"source\":%ld,\"expanded\":%d}", stats->source_lines, ctx->line_count);
+      fprintf(stats_stream, ",\"time_ms\":{\"pre_assembler\":%.3f,\"first_path\":%.3f,\"second_path\":%.3f,\"output\":%.3f,\"total\":%.3f}",
+             stats->phase_time[STATS_PRE_ASSEMBLER] * 1000, stats->phase_time[STATS_FIRST_PATH] * 1000,
+             stats->phase_time[STATS_SECOND_PATH] * 1000, stats->phase_time[STATS_OUTPUT] * 1000, total * 1000);
+      fprintf(stats_stream, ",\"macros\":{\"count\":%d,\"table_size\":%d,\"lookups\":%ld}",
+             ctx->macro_count, ctx->macro_table_size, stats->macro_lookups);
+      fprintf(stats_stream, ",\"symbols\":{\"count\":%d,\"table_size\":%d,\"lookups\":%ld,\"table_grows\":%d}",
+             ctx->symbol_count, ctx->symbols_table_size, stats->symbol_lookups, stats->symbol_table_grows);
+      fprintf(stats_stream, ",\"code_chunks\":%d,\"bytes_written\":%lu", ctx->cmd_code.chunk_count + ctx->data_code.chunk_count,
+             (unsigned long)stats->bytes_written);
+      fprintf(stats_stream, ",\"memory\":{\"file_bytes\":%lu,\"peak_rss_kb\":%ld},\"cache\":\"%s\"}\n",
+             (unsigned long)context_memory(ctx), peak_memory_kb(), cache);
+      fflush(stats_stream);
+#ifndef _MSC_VER
+      funlockfile(stats_stream);
+#endif
+      return;
+   }
+
+   report_message(ctx, "Statistics of file: %s\n", ctx->fileName);
+   report_message(ctx, "   lines: %ld in the source, %d after macro expansion\n", stats->source_lines, ctx->line_count);
+   report_message(ctx, "   time (ms): pre-assembler %.3f, first path %.3f, second path %.3f, output %.3f, total %.3f\n",
+          stats->phase_time[STATS_PRE_ASSEMBLER] * 1000, stats->phase_time[STATS_FIRST_PATH] * 1000,
+          stats->phase_time[STATS_SECOND_PATH] * 1000, stats->phase_time[STATS_OUTPUT] * 1000, total * 1000);
+   report_message(ctx, "   macros: %d (table size %d), %ld lookups\n", ctx->macro_count, ctx->macro_table_size, stats->macro_lookups);
+   report_message(ctx, "   symbols: %d (table size %d), %ld lookups, %d table grows\n",
+          ctx->symbol_count, ctx->symbols_table_size, stats->symbol_lookups, stats->symbol_table_grows);
+   report_message(ctx, "   code chunks: %d instruction, %d data\n", ctx->cmd_code.chunk_count, ctx->data_code.chunk_count);
+   report_message(ctx, "   bytes written: %lu\n", (unsigned long)stats->bytes_written);
+   report_message(ctx, "   memory: %lu bytes for the file, %ld KB peak resident\n", (unsigned long)context_memory(ctx), peak_memory_kb());
+   report_message(ctx, "   cache: %s\n", cache);
+}
+
+
+
+static void print_json_string(FILE* stream, const char* text) {
+   fputc('"', stream);
+   for (; *text != '\0'; text++) {
+      if (*text == '"' || *text == '\\')
+         fprintf(stream, "\\%c", *text);
+      else if ((unsigned char)*text < 0x20)
+         fprintf(stream, "\\u%04x", (unsigned char)*text);
+      else
+         fputc(*text, stream);
+   }
+   fputc('"', stream);
+}
+
+
+
+static long source_size(const char* filename) {
+#ifndef _MSC_VER
+   char asFilename[256]; /* Source file name with .as extension */
+   struct stat info; /* Size of the file */
+
+   sprintf(asFilename, "%s%s", filename, ".as");
+   if (stat(asFilename, &info) == 0)
+      return (long)info.st_size;
+#endif
+   return 0;
+}
+
+
+
+static void print_batch_report(const struct BatchReport* report) {
+   double busy = 0; /* Total time the threads spent assembling files */
+   int i; /* Thread index */
+
+   for (i = 0; i < report->threads; i++)
+      busy += report->busy[i];
+
+   if (stats_format == STATS_JSON) {
+      fprintf(stats_stream, "{\"batch\":{\"threads\":%d,\"makespan_ms\":%.3f,\"utilization\":%.3f,\"workers\":[",
+             report->threads, report->makespan * 1000, report->makespan > 0 ? busy / (report->makespan * report->threads) : 0.0);
+      for (i = 0; i < report->threads; i++)
+         fprintf(stats_stream, "%s{\"files\":%d,\"steals\":%d,\"busy_ms\":%.3f,\"utilization\":%.3f}", i == 0 ? "" : ",",
+                report->files_done[i], report->steals[i], report->busy[i] * 1000,
+                report->makespan > 0 ? report->busy[i] / report->makespan : 0.0);
+      fprintf(stats_stream, "]}}\n");
+      fflush(stats_stream);
+      return;
+   }
+
+   printf("Batch on %d threads: makespan %.3f ms, utilization %.1f%%\n", report->threads, report->makespan * 1000,
+          report->makespan > 0 ? 100 * busy / (report->makespan * report->threads) : 0.0);
+   for (i = 0; i < report->threads; i++)
+      printf("   thread %d: %d files (%d stolen), busy %.3f ms, utilization %.1f%%\n", i, report->files_done[i],
+             report->steals[i], report->busy[i] * 1000, report->makespan > 0 ? 100 * report->busy[i] / report->makespan : 0.0);
+}
+
+
+
+static void look_up_cache(char* files[], int file_count, int* hits, int* misses) {
+   char asFilename[256]; /* Source file name with .as extension */
+   struct SourceFile source; /* Content of the source file */
+   struct CachedFile* cached; /* The decision of the current file */
+   int i;
+
+   *hits = 0, *misses = 0;
+   cached_files = (struct CachedFile*)calloc(file_count > 0 ? file_count : 1, sizeof(struct CachedFile));
+   if (cached_files == NULL) {
+      perror("Error allocating memory for the cache");
+      exit(EXIT_FAILURE);
+   }
 
-         if (first_path_result)
-            second_path(filename, symbols_table, symbols_table_size, cmd_code, data_code, ICF, DCF);
-         
-         else
-            printf("Errors in the input file: %s, not generating its output files.\n", filename);
-         
+   for (i = 0; i < file_count; i++) {
+      if (find_cached_file(files[i]) != NULL)
+         continue; /* The same file twice: one decision */
+      sprintf(asFilename, "%s%s", files[i], ".as");
+      if (!open_source_file(asFilename, &source))
+         continue;
+
+      cached = &cached_files[cached_file_count];
+      cached->filename = files[i];
+      cache_key(source.text, source.length, object_format, cached->key);
+      close_source_file(&source);
+
+      cached->hit = cache_lookup(cache_dir, cached->key);
+      if (cached->hit)
+         (*hits)++;
+      else
+         (*misses)++;
+      hash_index_insert(&cached_file_index, files[i], strlen(files[i]), cached_file_count++);
+   }
+}
+
+
+
+static const char* cached_file_name(const void* table, int id) {
+   return ((const struct CachedFile*)table)[id].filename;
+}
+
+
+
+static const struct CachedFile* find_cached_file(const char* filename) {
+   int id; /* Index of the decision */
+
+   if (cached_files == NULL)
+      return NULL;
+   id = hash_index_find(&cached_file_index, filename, strlen(filename), cached_file_name, cached_files);
+   return id != NO ? &cached_files[id] : NULL;
+}
+
+
+
+static void print_cache_summary(int hits, int misses) {
+   if (stats_format == STATS_JSON) {
+      fprintf(stats_stream, "{\"cache\":{\"hits\":%d,\"misses\":%d}}\n", hits, misses);
+      fflush(stats_stream);
+   }
+   else
+      printf("Cache: %d hits, %d misses\n", hits, misses);
+}
+
+
+
+static long peak_memory_kb(void) {
+#ifndef _MSC_VER
+   struct rusage usage; /* Resource usage of the process */
+
+   if (getrusage(RUSAGE_SELF, &usage) == 0)
+      return usage.ru_maxrss; /* Kilobytes on Linux */
+#endif
+   return 0;
+}
+
+
+
+static int parse_arguments(int argc, char* argv[], char* files[], int* file_count, int* threads) {
+   int i;
+
+   *file_count = 0, *threads = 1;
+   keep_am = FALSE, one_pass = FALSE, object_format = OBJECT_FORMAT_TEXT, stats_format = STATS_NONE, stats_path = NULL, cache_dir = NULL, watch_dir = NULL;
+   for (i = 1; i < argc; i++) {
+      if (strcmp(argv[i], "--keep-am") == 0) { /* Write the expanded sources to .am files */
+         keep_am = TRUE;
+      }
+      else if (strcmp(argv[i], "--one-pass") == 0) { /* Resolve label operands without a second path */
+         one_pass = TRUE;
+      }
+      else if (strncmp(argv[i], "--format=", 9) == 0) { /* Text output files or a binary object file */
+         if (strcmp(argv[i] + 9, "text") == 0)
+            object_format = OBJECT_FORMAT_TEXT;
+         else if (strcmp(argv[i] + 9, "bin") == 0)
+            object_format = OBJECT_FORMAT_BIN;
+         else {
+            printf("Error: unknown output format (%s), must be text or bin.\n", argv[i] + 9);
+            return FALSE;
+         }
+      }
+      else if (strcmp(argv[i], "--stats") == 0) { /* Print the statistics of every file */
+         stats_format = STATS_TEXT;
+      }
+      else if (strncmp(argv[i], "--stats=json", 12) == 0 && (argv[i][12] == '\0' || argv[i][12] == ':')) {
+         /* Write the statistics of every file as JSON lines: "--stats=json" (stderr) or "--stats=json:FILE" */
+         stats_format = STATS_JSON;
+         stats_path = argv[i][12] == ':' ? argv[i] + 13 : NULL;
+         if (stats_path != NULL && *stats_path == '\0') {
+            printf("Error: --stats=json: requires a file.\n");
+            return FALSE;
+         }
       }
-      else 
-         printf("Errors in the input file: %s, not generating its output files.\n", filename);
-      
-      /* Free allocated memory for symbols table */
-      free_symbols_table(symbols_table, symbols_table_size);
+      else if (strncmp(argv[i], "--cache-dir", 11) == 0) { /* Cache directory: "--cache-dir DIR" or "--cache-dir=DIR" */
+         cache_dir = argv[i][11] == '=' ? argv[i] + 12 : (argv[i][11] == '\0' && i + 1 < argc ? argv[++i] : NULL);
+         if (cache_dir == NULL || *cache_dir == '\0') {
+            printf("Error: --cache-dir requires a directory.\n");
+            return FALSE;
+         }
+      }
+      else if (strncmp(argv[i], "--watch", 7) == 0) { /* Watched directory: "--watch DIR" or "--watch=DIR" */
+         watch_dir = argv[i][7] == '=' ? argv[i] + 8 : (argv[i][7] == '\0' && i + 1 < argc ? argv[++i] : NULL);
+         if (watch_dir == NULL || *watch_dir == '\0') {
+            printf("Error: --watch requires a directory.\n");
+            return FALSE;
+         }
+      }
+      else if (strncmp(argv[i], "-t", 2) == 0 || strncmp(argv[i], "-j", 2) == 0) { /* Number of threads: "-t N" or "-tN" (-j alike) */
+         char option = argv[i][1]; /* t or j */
+         char* value = argv[i][2] != '\0' ? argv[i] + 2 : (i + 1 < argc ? argv[++i] : NULL);
+         if (value == NULL || !check_number(value) || (*threads = atoi(value)) < 1) {
+            printf("Error: -%c requires a positive number of threads.\n", option);
+            return FALSE;
+         }
+      }
+      else {
+         files[(*file_count)++] = argv[i]; /* Every other argument is a file name */
+      }
+   }
+   return watch_dir != NULL ? *file_count == 0 : *file_count > 0; /* Either a directory to watch or files */
+}
+
+
+
+static int run_command(int argc, char* argv[]) {
+   int i, file_count, threads; /* Loop index, number of files and number of threads */
+   int hits, misses, success; /* Number of files found and not found in the cache, FALSE if a file was not assembled */
+   char** files; /* File names given on the command line */
+   long* sizes; /* Size of the source of every file, for the thread scheduler */
+   struct BatchReport report; /* How the files were spread over the threads */
 
-      /* Free command code array */
-      if (cmd_code != NULL) {
-         free(cmd_code);
-         cmd_code = NULL;
+   files = (char**)calloc(argc, sizeof(char*));
+   if (files == NULL) {
+      perror("Error allocating memory for file names");
+      exit(EXIT_FAILURE);
+   }
+
+   /* Check if the user provided a filename */
+   if (!parse_arguments(argc, argv, files, &file_count, &threads)) {
+      printf("Usage: %s [-t N] [--keep-am] [--one-pass] [--format=text|bin] [--stats[=json[:FILE]]] [--cache-dir DIR] [--connect SOCKET] <filename> ...\n"
+             "       %s [--keep-am] [--one-pass] [--format=text|bin] [--stats[=json[:FILE]]] --watch DIR\n"
+             "       %s --serve SOCKET [-j N]\n"
+             "       %s --lsp\n", argv[0], argv[0], argv[0], argv[0]);
+      free(files);
+      return 1;
+   }
+
+   /* The JSON statistics have a stream of their own, apart from the console output */
+   stats_stream = stderr;
+   if (stats_path != NULL && (stats_stream = fopen(stats_path, "a")) == NULL) {
+      printf("Error: cannot open the statistics file %s.\n", stats_path);
+      free(files);
+      return 1;
+   }
+
+   if (watch_dir != NULL) {
+      /* Assemble the sources of the directory, then every source that changes */
+      success = run_watcher(watch_dir, assemble_file);
+      if (stats_stream != stderr)
+         fclose(stats_stream);
+      free(files);
+      return success ? FALSE : 1;
+   }
+
+   if (cache_dir != NULL)
+      look_up_cache(files, file_count, &hits, &misses);
+
+   if (threads > 1 && file_count > 1) {
+      /* Spread the files across threads, largest first */
+      sizes = (long*)calloc(file_count, sizeof(long));
+      if (sizes == NULL) {
+         perror("Error allocating memory for file sizes");
+         exit(EXIT_FAILURE);
       }
+      for (i = 0; i < file_count; i++)
+         sizes[i] = source_size(files[i]);
 
-      /* Free data code array */
-      if (data_code != NULL) {
-         free(data_code);
-         data_code = NULL;
+      success = run_batch_scheduler(files, sizes, file_count, threads, assemble_file_to, &report);
+      if (stats_format != STATS_NONE)
+         print_batch_report(&report);
+      free_batch_report(&report);
+      free(sizes);
+   }
+   else {
+      for (success = TRUE, i = 0; i < file_count; i++) {
+         if (!assemble_file(files[i]))
+            success = FALSE; /* Go on with the other files, as the threads do */
+         fflush(stdout); /* Stream the messages file by file, also to a client of the server */
       }
+   }
+
+   if (cache_dir != NULL) {
+      print_cache_summary(hits, misses);
+      free_hash_index(&cached_file_index);
+      free(cached_files);
+      cached_files = NULL, cached_file_count = 0;
+   }
+   if (stats_stream != stderr)
+      fclose(stats_stream);
+   free(files);
+   return success ? FALSE : 1; /* 1 if a file could not be assembled */
+}
+
 
-      /* Free macro table */
-      if (macro_table != NULL) {
-         free(macro_table);
-         macro_table = NULL;
+
+static int run_request(int argc, char* argv[]) {
+   int i;
+
+   for (i = 1; i < argc; i++) {
+      if (strncmp(argv[i], "--watch", 7) == 0 || strcmp(argv[i], "--serve") == 0 ||
+          strcmp(argv[i], "--connect") == 0 || strcmp(argv[i], "--lsp") == 0) {
+         printf("Error: %s cannot be used in a request to the assembler server.\n", argv[i]);
+         return 1;
       }
+   }
+   return run_command(argc, argv);
+}
+
+
 
+static int serve(int argc, char* argv[], const char* path) {
+   long workers; /* Number of worker processes */
+   char* value; /* The value of -j */
+
+   workers = sysconf(_SC_NPROCESSORS_ONLN); /* One worker per processor by default */
+   if (workers < 1)
+      workers = 1;
+
+   value = argc == 2 && strncmp(argv[1], "-j", 2) == 0 && argv[1][2] != '\0' ? argv[1] + 2 :
+           (argc == 3 && strcmp(argv[1], "-j") == 0 ? argv[2] : NULL);
+   if (argc > 1 && (value == NULL || !check_number(value) || (workers = atoi(value)) < 1)) {
+      printf("Usage: %s --serve SOCKET [-j N]\n", argv[0]);
+      return 1;
+   }
+   return run_server(path, (int)workers, run_request);
+}
+
+
+
+int main(int argc, char* argv[]) {
+   int i, j; /* Loop indexes */
+
+   if (argc == 2 && strcmp(argv[1], "--lsp") == 0) /* Language server on the standard input and output */
+      return run_language_server(stdin, stdout) ? 0 : 1;
+
+   /* Server and client modes: "--serve PATH" or "--connect PATH" anywhere on the command line */
+   for (i = 1; i + 1 < argc; i++) {
+      if (strcmp(argv[i], "--serve") == 0 || strcmp(argv[i], "--connect") == 0) {
+         const char* path = argv[i + 1]; /* The socket */
+         int serving = argv[i][2] == 's'; /* TRUE for --serve */
+
+         for (j = i; j + 2 < argc; j++) /* Remove the option and its path */
+            argv[j] = argv[j + 2];
+         argc -= 2;
+         argv[argc] = NULL;
+         return serving ? serve(argc, argv, path) : run_client(path, argc, argv);
+      }
    }
-  
-   return FALSE; /* Return FALSE if no filename is provided */
-}
\ No newline at end of file
+   return run_command(argc, argv);
+}
@@ -0,0 +1,208 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#else
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <stdarg.h>
+#include <time.h>
+#include "assembler_context.h"
+#include "first_path.h"
+#include "second_path.h"
+
+
+/**
+ * @brief Makes sure a text buffer has room for more characters and a null terminator.
+ *
+ * @param buffer The buffer to grow.
+ * @param extra The number of characters about to be appended.
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+static void reserve_text(struct TextBuffer* buffer, size_t extra);
+
+
+
+void init_context(struct AssemblerContext* ctx, const char* fileName) {
+   memset(ctx, 0, sizeof(*ctx));
+   ctx->fileName = fileName;
+   ctx->input_validation = TRUE; /* No errors found yet */
+
+   /* Initialize macro table */
+   ctx->macro_table_size = INITIAL_MACRO_TABLE_SIZE;
+   ctx->macro_table = (struct Macro*)arena_alloc(&ctx->arena, ctx->macro_table_size * sizeof(struct Macro));
+
+   /* Initialize symbols table */
+   ctx->symbols_table_size = INITIAL_SYMBOLS_TABLE_SIZE;
+   ctx->symbols_table = (struct Symbol*)arena_alloc(&ctx->arena, ctx->symbols_table_size * sizeof(struct Symbol));
+
+   /* The command and data code start empty (zeroed) and get their chunks as words are stored */
+}
+
+
+
+void free_context(struct AssemblerContext* ctx) {
+   /* Release the tables, code arrays, macro bodies, lines, fixups, decoded commands and external uses at once */
+   free_arena(&ctx->arena);
+   ctx->macro_table = NULL, ctx->symbols_table = NULL;
+   memset(&ctx->cmd_code, 0, sizeof(ctx->cmd_code));
+   memset(&ctx->data_code, 0, sizeof(ctx->data_code));
+   ctx->lines = NULL, ctx->fixups = NULL, ctx->instructions = NULL, ctx->external_uses = NULL;
+   ctx->macro_count = 0, ctx->symbol_count = 0;
+   ctx->line_count = 0, ctx->fixup_count = 0, ctx->instruction_count = 0, ctx->external_use_count = 0;
+   ctx->line_capacity = 0, ctx->fixup_capacity = 0, ctx->instruction_capacity = 0, ctx->external_use_capacity = 0;
+
+   /* Free the indexes of the tables */
+   free_hash_index(&ctx->symbol_index);
+   free_hash_index(&ctx->macro_index);
+
+   /* Free the names of the operands and the collected messages */
+   free(ctx->operand_names.text);
+   free(ctx->diagnostics.text);
+   memset(&ctx->operand_names, 0, sizeof(ctx->operand_names));
+   memset(&ctx->diagnostics, 0, sizeof(ctx->diagnostics));
+}
+
+
+
+int assemble_context(struct AssemblerContext* ctx, const char* source, size_t length) {
+   double start; /* Time at the start of the current phase */
+   int result; /* TRUE if the current phase found no errors */
+
+   /* Process macros using the pre-assembler */
+   start = stats_clock();
+   result = read_row_pre(ctx, source, length);
+   ctx->stats.phase_time[STATS_PRE_ASSEMBLER] = stats_clock() - start;
+   if (!result)
+      return FALSE;
+
+   /* Perform first and second paths if pre-assembler succeeded */
+   start = stats_clock();
+   result = first_path(ctx);
+   ctx->stats.phase_time[STATS_FIRST_PATH] = stats_clock() - start;
+   if (!result)
+      return FALSE;
+
+   start = stats_clock();
+   result = ctx->one_pass ? resolve_fixups(ctx) : second_path(ctx);
+   ctx->stats.phase_time[STATS_SECOND_PATH] = stats_clock() - start;
+   return result;
+}
+
+
+
+double stats_clock(void) {
+#ifndef _MSC_VER
+   struct timespec now; /* The current time */
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#else
+   return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+
+
+size_t context_memory(const struct AssemblerContext* ctx) {
+   return arena_size(&ctx->arena) +
+          (size_t)(ctx->macro_index.capacity + ctx->symbol_index.capacity) * sizeof(struct HashEntry) +
+          ctx->operand_names.capacity + ctx->diagnostics.capacity;
+}
+
+
+
+void append_lines(struct Arena* arena, struct LineView** lines, int* count, int* capacity, const struct LineView* added, int added_count) {
+   int old_capacity = *capacity; /* Capacity before growing */
+
+   if (*count + added_count > *capacity) { /* The list is full, double it */
+      if (*capacity == 0)
+         *capacity = INITIAL_LINE_LIST_SIZE;
+      while (*count + added_count > *capacity)
+         *capacity *= 2;
+      *lines = (struct LineView*)arena_grow(arena, *lines, old_capacity * sizeof(struct LineView), (*capacity) * sizeof(struct LineView));
+   }
+
+   memcpy(*lines + *count, added, added_count * sizeof(struct LineView));
+   *count += added_count;
+}
+
+
+
+void write_expanded(const struct AssemblerContext* ctx, FILE* dest) {
+   int n; /* Index of the line */
+
+   for (n = 0; n < ctx->line_count; n++) {
+      fwrite(ctx->lines[n].text, 1, ctx->lines[n].length, dest);
+      if (ctx->lines[n].newline)
+         fputc('\n', dest);
+   }
+}
+
+
+
+void copy_line(const struct AssemblerContext* ctx, int n, char* row) {
+   int length = ctx->lines[n].length; /* Length of the line without its newline */
+
+   memcpy(row, ctx->lines[n].text, length);
+   if (ctx->lines[n].newline)
+      row[length++] = '\n';
+   row[length] = '\0';
+}
+
+
+
+void report_message(struct AssemblerContext* ctx, const char* format, ...) {
+   va_list args; /* Arguments of the message */
+   int length; /* Length of the formatted message */
+
+   if (!ctx->capture_diagnostics) { /* Print the message directly */
+      va_start(args, format);
+      vprintf(format, args);
+      va_end(args);
+      return;
+   }
+
+   /* Measure the message */
+   va_start(args, format);
+   length = vsnprintf(NULL, 0, format, args);
+   va_end(args);
+   if (length < 0)
+      return;
+
+   /* Format it at the end of the collected messages */
+   reserve_text(&ctx->diagnostics, length);
+   va_start(args, format);
+   vsnprintf(ctx->diagnostics.text + ctx->diagnostics.size, length + 1, format, args);
+   va_end(args);
+   ctx->diagnostics.size += length;
+}
+
+
+
+static void reserve_text(struct TextBuffer* buffer, size_t extra) {
+   char* new_text; /* Pointer for reallocating the text */
+
+   if (buffer->size + extra + 1 <= buffer->capacity)
+      return;
+
+   if (buffer->capacity == 0)
+      buffer->capacity = INITIAL_TEXT_BUFFER_SIZE;
+   while (buffer->size + extra + 1 > buffer->capacity)
+      buffer->capacity *= 2; /* Double the capacity */
+
+   new_text = realloc(buffer->text, buffer->capacity);
+   if (new_text == NULL) {
+      perror("Error reallocating memory for text buffer");
+      exit(EXIT_FAILURE);
+   }
+   buffer->text = new_text;
+}
+
+
+
+void append_text(struct TextBuffer* buffer, const char* text, size_t length) {
+   reserve_text(buffer, length);
+   memcpy(buffer->text + buffer->size, text, length);
+   buffer->size += length;
+   buffer->text[buffer->size] = '\0';
+}
@@ -0,0 +1,340 @@
+#ifndef ASSEMBLER_CONTEXT_H
+#define ASSEMBLER_CONTEXT_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include "hash_index.h"
+#include "arena.h"
+#include "word_store.h"
+
+#define INITIAL_MACRO_TABLE_SIZE 20
+#define INITIAL_TEXT_BUFFER_SIZE 1024
+#define INITIAL_LINE_LIST_SIZE 16
+#define INITIAL_FIXUP_LIST_SIZE 64
+#define INITIAL_INSTRUCTION_LIST_SIZE 64
+#define INITIAL_EXTERNAL_USE_LIST_SIZE 64
+
+#define STATS_PRE_ASSEMBLER 0 /* Phases timed in the statistics of a file */
+#define STATS_FIRST_PATH 1
+#define STATS_SECOND_PATH 2 /* The second path, or resolving the fixups in one-pass mode */
+#define STATS_OUTPUT 3
+#define STATS_PHASE_COUNT 4
+
+struct Macro;
+struct Symbol;
+
+
+
+/**
+ * @brief A growable in-memory text.
+ * @struct TextBuffer
+ * @param text The characters of the text (null-terminated once something was appended).
+ * @param size The length of the text, without the null terminator.
+ * @param capacity The allocated size of `text`.
+ */
+struct TextBuffer {
+   char* text;
+   size_t size;
+   size_t capacity;
+};
+
+
+
+/**
+ * @brief A line of the expanded source, as a view into the source it came from.
+ * @struct LineView
+ *
+ * The newline is not taken from the source, so a line ending with a CRLF, or a row that was
+ * truncated, is still seen with a plain newline.
+ *
+ * @param text The first character of the line in the source.
+ * @param length The number of characters of the line, without its newline.
+ * @param newline TRUE if the line ends with a newline, FALSE otherwise.
+ */
+struct LineView {
+   const char* text;
+   int length;
+   int newline;
+};
+
+
+
+/**
+ * @brief A label operand whose word is filled once all the symbols are known (one-pass mode).
+ * @struct Fixup
+ * @param slot The index of the operand word in the command code array, or NO if the operand has no word.
+ * @param line The line of the operand in the expanded source (used for error reporting).
+ * @param relative TRUE for relative addressing (`&label`), FALSE for direct addressing.
+ * @param name The position of the symbol name (null-terminated) in the operand names of the context.
+ */
+struct Fixup {
+   int slot;
+   int line;
+   int relative;
+   size_t name;
+};
+
+
+
+/**
+ * @brief A use of an external symbol: a word that the linker fills with the address of the symbol.
+ * @struct ExternalUse
+ * @param symbol The index of the symbol in the symbols table.
+ * @param address The address of the word.
+ */
+struct ExternalUse {
+   int symbol;
+   int address;
+};
+
+
+
+/**
+ * @brief A command as decoded by the first path, the input of the second path.
+ * @struct Instruction
+ * @param command The index of the command in the command table.
+ * @param modes The addressing method of the source and destination operands, or NO if the command does not
+ *              have the operand. An operand that is not immediate, a register or relative is kept as direct.
+ * @param ic The index of the first word of the command in the command code array.
+ * @param line The line of the command in the expanded source (used for error reporting).
+ * @param operands For direct and relative operands, the position of the symbol name (null-terminated) in
+ *                 the operand names of the context.
+ */
+struct Instruction {
+   unsigned char command;
+   signed char modes[2];
+   int ic;
+   int line;
+   size_t operands[2];
+};
+
+
+
+/**
+ * @brief Counters and timings of assembling a single file, reported with `--stats`.
+ * @struct AssemblerStats
+ * @param phase_time The wall time of every phase in seconds, indexed by STATS_PRE_ASSEMBLER to STATS_OUTPUT
+ *                   (0 for the phases that did not run).
+ * @param source_lines The number of lines in the source file, including empty lines and comments.
+ * @param macro_lookups The number of searches in the macro table.
+ * @param symbol_lookups The number of searches in the symbols table.
+ * @param symbol_table_grows The number of times expand_symbols_table grew the symbols table.
+ * @param bytes_written The number of bytes written to the output files.
+ */
+struct AssemblerStats {
+   double phase_time[STATS_PHASE_COUNT];
+   long source_lines;
+   long macro_lookups;
+   long symbol_lookups;
+   int symbol_table_grows;
+   size_t bytes_written;
+};
+
+
+
+/**
+ * @brief Holds all the state of assembling a single file.
+ * @struct AssemblerContext
+ *
+ * Every phase (pre-assembler, first path, second path and output) receives the context of the
+ * file it works on instead of using global variables, so several files can be assembled at the
+ * same time in one process.
+ *
+ * @param fileName The name of the file being assembled (without extension).
+ * @param arena The memory of the tables and arrays of the file, released at once by free_context.
+ * @param macro_table The macro table filled by the pre-assembler.
+ * @param macro_table_size The size of the macro table.
+ * @param macro_count The number of macros in the macro table (they fill its first entries, in order of definition).
+ * @param macro_index The index of the macro table by macro name.
+ * @param symbols_table The symbols table filled by the first path.
+ * @param symbols_table_size The size of the symbols table.
+ * @param symbol_count The number of symbols in the symbols table (they fill its first entries, in order of definition).
+ * @param symbol_index The index of the symbols table by symbol name.
+ * @param cmd_code The command code: the instruction words, by their index from the first instruction.
+ * @param data_code The data code: the data words, by their index from the first data word.
+ * @param IC Instruction Counter: the current address in the instruction section.
+ * @param DC Data Counter: the current address in the data section.
+ * @param ICF The final value of the instruction counter after the first path.
+ * @param DCF The final value of the data counter after the first path.
+ * @param isExternal TRUE if the second path found a use of an external symbol.
+ * @param isEntry TRUE if the second path found an entry symbol.
+ * @param input_validation TRUE as long as no error was found in the input file.
+ * @param lines The lines of the source after macro expansion (the content of the .am file), read by the first
+ *              path. They point into the source, so it must stay in memory until the file is done.
+ * @param line_count The number of lines.
+ * @param line_capacity The allocated size of `lines`.
+ * @param one_pass TRUE to fill the label words from the fixups recorded by the first path, instead of a second path.
+ * @param object_format The format of the output files: OBJECT_FORMAT_TEXT or OBJECT_FORMAT_BIN (see object_format.h).
+ * @param fixups The label operands recorded by the first path in one-pass mode, in source order.
+ * @param fixup_count The number of recorded fixups.
+ * @param fixup_capacity The allocated size of `fixups`.
+ * @param instructions The commands decoded by the first path in two-pass mode, in source order.
+ * @param instruction_count The number of decoded commands.
+ * @param instruction_capacity The allocated size of `instructions`.
+ * @param operand_names The symbol names used by the fixups and instructions, one after the other.
+ * @param external_uses The uses of external symbols, in address order (the operands are completed in that order).
+ * @param external_use_count The number of uses of external symbols.
+ * @param external_use_capacity The allocated size of `external_uses`.
+ * @param capture_diagnostics TRUE to collect the error messages in `diagnostics` instead of printing them.
+ * @param diagnostics The collected error messages, when `capture_diagnostics` is set.
+ * @param stats The counters and timings of the file, kept up to date by every phase.
+ */
+struct AssemblerContext {
+   const char* fileName;
+   struct Arena arena;
+   struct Macro* macro_table;
+   int macro_table_size;
+   int macro_count;
+   struct HashIndex macro_index;
+   struct Symbol* symbols_table;
+   int symbols_table_size;
+   int symbol_count;
+   struct HashIndex symbol_index;
+   struct WordStore cmd_code;
+   struct WordStore data_code;
+   int IC, DC;
+   int ICF, DCF;
+   int isExternal, isEntry;
+   int input_validation;
+   struct LineView* lines;
+   int line_count, line_capacity;
+   int one_pass;
+   int object_format;
+   struct Fixup* fixups;
+   int fixup_count, fixup_capacity;
+   struct Instruction* instructions;
+   int instruction_count, instruction_capacity;
+   struct TextBuffer operand_names;
+   struct ExternalUse* external_uses;
+   int external_use_count, external_use_capacity;
+   int capture_diagnostics;
+   struct TextBuffer diagnostics;
+   struct AssemblerStats stats;
+};
+
+
+
+/**
+ * @brief Allocates the tables and code arrays of a file and resets its counters.
+ *
+ * @param ctx The context to initialize.
+ * @param fileName The name of the file (without extension) the context belongs to.
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+void init_context(struct AssemblerContext* ctx, const char* fileName);
+
+
+
+/**
+ * @brief Frees all the memory owned by the context of a file.
+ *
+ * @param ctx The context to free.
+ */
+void free_context(struct AssemblerContext* ctx);
+
+
+
+/**
+ * @brief Appends lines to a list of lines, growing it if needed.
+ *
+ * @param arena The arena the list is allocated from.
+ * @param lines Pointer to the list of lines.
+ * @param count Pointer to the number of lines in the list.
+ * @param capacity Pointer to the allocated size of the list.
+ * @param added The lines to append.
+ * @param added_count The number of lines to append.
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+void append_lines(struct Arena* arena, struct LineView** lines, int* count, int* capacity, const struct LineView* added, int added_count);
+
+
+
+/**
+ * @brief Writes the expanded source of a file (the content of its .am file).
+ *
+ * @param ctx The context of the file, after the pre-assembler.
+ * @param dest The file to write to.
+ */
+void write_expanded(const struct AssemblerContext* ctx, FILE* dest);
+
+
+
+/**
+ * @brief Copies a line of the expanded source into a row buffer.
+ *
+ * @param ctx The context of the file, after the pre-assembler.
+ * @param n The index of the line.
+ * @param row The buffer to fill (at least MAX characters). The row keeps its newline and is null-terminated.
+ */
+void copy_line(const struct AssemblerContext* ctx, int n, char* row);
+
+
+
+/**
+ * @brief Runs the pre-assembler, the first path and the second path of a file held in memory.
+ *
+ * In one-pass mode the second path is replaced by resolving the fixups recorded by the first path.
+ *
+ * The expanded source is kept in the context as lines that point into the source, the first path
+ * reads its rows from them and the second path works from the commands decoded by the first path,
+ * so nothing is read from or written to the filesystem. Writing the output files is left to the caller.
+ *
+ * @param ctx An initialized context for the file.
+ * @param source The content of the source (.as) file. It must stay in memory until the context is freed.
+ *
+ * @param length The length of the source in bytes.
+ * @return TRUE if no errors were found in the file, FALSE otherwise.
+ */
+int assemble_context(struct AssemblerContext* ctx, const char* source, size_t length);
+
+
+
+/**
+ * @brief Reads a monotonic clock, for timing the phases of a file.
+ *
+ * @return The current time in seconds, from an arbitrary starting point.
+ */
+double stats_clock(void);
+
+
+
+/**
+ * @brief Returns the number of bytes of memory owned by the context of a file.
+ *
+ * Counts the chunks of the arena, the slots of the hash indexes and the text buffers. Nothing
+ * is released before free_context, so after the last phase this is the peak for the file.
+ *
+ * @param ctx The context of the file.
+ * @return The number of bytes allocated for the file.
+ */
+size_t context_memory(const struct AssemblerContext* ctx);
+
+
+
+/**
+ * @brief Reports a message (error or attention) about the input file.
+ *
+ * The message is printed to the standard output, or appended to the diagnostics of the
+ * context when it captures them.
+ *
+ * @param ctx The context of the file the message is about.
+ * @param format A printf-style format string, followed by its arguments.
+ */
+void report_message(struct AssemblerContext* ctx, const char* format, ...);
+
+
+
+/**
+ * @brief Appends text to a text buffer, growing it if needed.
+ *
+ * @param buffer The buffer to append to.
+ * @param text The text to append.
+ * @param length The number of characters to append.
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+void append_text(struct TextBuffer* buffer, const char* text, size_t length);
+
+#endif /* ASSEMBLER_CONTEXT_H */
@@ -0,0 +1,484 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "assembler_server.h"
+
+#define SOCKET_CHUNK_SIZE 4096
+#define STATUS_SIZE 32 /* Room for the exit status in decimal */
+
+
+static volatile sig_atomic_t stopping = FALSE; /* Set by SIGINT or SIGTERM: the server stops its workers and exits */
+
+
+/**
+ * @brief Fills the address of a Unix domain socket.
+ *
+ * @param address The address to fill.
+ * @param path The path of the socket.
+ * @return TRUE if the path fits in the address, FALSE otherwise (an error message is printed).
+ */
+static int fill_address(struct sockaddr_un* address, const char* path);
+
+
+
+/**
+ * @brief Connects to the socket of a server.
+ *
+ * @param path The path of the socket.
+ * @return The connected socket, or NO if no server is listening on it (errno is set).
+ */
+static int connect_socket(const char* path);
+
+
+
+/**
+ * @brief Creates the socket of the server and listens on it.
+ *
+ * @param path The path of the socket. A socket left there by a server that is no longer running is replaced.
+ * @return The listening socket.
+ *
+ * @note The function exits the program with an error message if the socket cannot be created.
+ */
+static int open_listener(const char* path);
+
+
+
+/**
+ * @brief Starts a worker process of the server.
+ *
+ * @param listener The listening socket, shared by all the workers.
+ * @param run The function that runs a command line.
+ * @return The process id of the worker.
+ *
+ * @note The function exits the program with an error message if the process cannot be created.
+ */
+static pid_t start_server_worker(int listener, int (*run)(int argc, char* argv[]));
+
+
+
+/**
+ * @brief Reads a whole request from a client.
+ *
+ * @param connection The connection of the client.
+ * @param request The buffer to read the request into (emptied first).
+ * @param argc Pointer to store the number of arguments of the request.
+ * @return TRUE if a well-formed request was read, FALSE if the client left or sent something else.
+ */
+static int read_request(int connection, struct TextBuffer* request, int* argc);
+
+
+
+/**
+ * @brief Serves one connection: reads the request, runs it with the console connected to the client
+ *        and sends the exit status.
+ *
+ * @param connection The connection of the client.
+ * @param request The buffer for the request, reused by all the requests of the worker.
+ * @param run The function that runs a command line.
+ * @param console_out The stdout of the worker, restored after the request.
+ * @param console_err The stderr of the worker, restored after the request.
+ */
+static void serve_request(int connection, struct TextBuffer* request, int (*run)(int argc, char* argv[]),
+                          int console_out, int console_err);
+
+
+
+/**
+ * @brief Writes a whole buffer to a file descriptor.
+ *
+ * @param fd The file descriptor.
+ * @param data The bytes to write.
+ * @param length The number of bytes.
+ * @return TRUE if all the bytes were written, FALSE otherwise.
+ */
+static int write_all(int fd, const char* data, size_t length);
+
+
+
+/**
+ * @brief Returns the working directory of the process.
+ *
+ * @return A newly allocated string with the path (to be freed by the caller).
+ *
+ * @note The function exits the program with an error message if the directory cannot be read.
+ */
+static char* current_directory(void);
+
+
+
+/**
+ * @brief Signal handler of SIGINT and SIGTERM in the server: asks it to stop.
+ *
+ * @param signal_number The signal received.
+ */
+static void handle_stop(int signal_number);
+
+
+
+
+static int fill_address(struct sockaddr_un* address, const char* path) {
+   memset(address, 0, sizeof(*address));
+   if (strlen(path) >= sizeof(address->sun_path)) {
+      printf("Error: the socket path is too long (%s).\n", path);
+      return FALSE;
+   }
+   address->sun_family = AF_UNIX;
+   strcpy(address->sun_path, path);
+   return TRUE;
+}
+
+
+
+
+static int connect_socket(const char* path) {
+   struct sockaddr_un address; /* Address of the server */
+   int fd, error; /* The socket, and the error of connecting it */
+
+   if (!fill_address(&address, path))
+      return NO;
+   fd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (fd < 0)
+      return NO;
+   if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+      error = errno;
+      close(fd);
+      errno = error;
+      return NO;
+   }
+   return fd;
+}
+
+
+
+
+static int open_listener(const char* path) {
+   struct sockaddr_un address; /* Address to listen on */
+   int listener, probe; /* The listening socket, and a connection to a server already on the path */
+
+   if (!fill_address(&address, path))
+      exit(EXIT_FAILURE);
+   listener = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (listener < 0) {
+      perror("Error creating the server socket");
+      exit(EXIT_FAILURE);
+   }
+
+   if (bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0) {
+      if (errno != EADDRINUSE) {
+         perror("Error binding the server socket");
+         exit(EXIT_FAILURE);
+      }
+      /* The path exists: replace it only if no server answers on it */
+      if ((probe = connect_socket(path)) != NO) {
+         close(probe);
+         printf("Error: a server is already running on %s.\n", path);
+         exit(EXIT_FAILURE);
+      }
+      if (unlink(path) != 0 || bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0) {
+         perror("Error binding the server socket");
+         exit(EXIT_FAILURE);
+      }
+   }
+
+   if (listen(listener, SOMAXCONN) != 0) {
+      perror("Error listening on the server socket");
+      exit(EXIT_FAILURE);
+   }
+   return listener;
+}
+
+
+
+
+static pid_t start_server_worker(int listener, int (*run)(int argc, char* argv[])) {
+   struct TextBuffer request; /* The buffer of the requests, reused by all the requests of the worker */
+   int connection, console_out, console_err; /* The connection of a client, and the console of the worker */
+   pid_t pid;
+
+   fflush(stdout); /* Do not let the worker inherit unwritten output of the server */
+   fflush(stderr);
+
+   pid = fork();
+   if (pid < 0) {
+      perror("Error creating a server worker process");
+      exit(EXIT_FAILURE);
+   }
+   if (pid > 0)
+      return pid;
+
+   /* Worker process: serve connections until the server stops it */
+   signal(SIGINT, SIG_DFL);
+   signal(SIGTERM, SIG_DFL);
+   signal(SIGPIPE, SIG_IGN); /* A client that leaves early only fails the writes of its request */
+   memset(&request, 0, sizeof(request));
+   console_out = dup(STDOUT_FILENO);
+   console_err = dup(STDERR_FILENO);
+
+   for (;;) {
+      connection = accept(listener, NULL, NULL);
+      if (connection < 0) {
+         if (errno == EINTR || errno == ECONNABORTED)
+            continue;
+         perror("Error accepting a connection");
+         _exit(EXIT_FAILURE);
+      }
+      serve_request(connection, &request, run, console_out, console_err);
+      close(connection);
+   }
+}
+
+
+
+
+static int read_request(int connection, struct TextBuffer* request, int* argc) {
+   char chunk[SOCKET_CHUNK_SIZE]; /* Bytes read from the client */
+   ssize_t n, i; /* Number of bytes read, and loop index */
+   int strings = 0; /* Number of null-terminated strings received */
+
+   request->size = 0, *argc = NO;
+   for (;;) {
+      n = read(connection, chunk, sizeof(chunk));
+      if (n < 0 && errno == EINTR)
+         continue;
+      if (n <= 0 || request->size + n > MAX_REQUEST_SIZE)
+         return FALSE;
+
+      for (i = 0; i < n; i++)
+         strings += chunk[i] == '\0';
+      append_text(request, chunk, n);
+
+      if (*argc == NO && strings > 0) { /* The number of arguments is the first string */
+         if (!check_number(request->text) || (*argc = atoi(request->text)) < 1)
+            return FALSE;
+      }
+      if (*argc != NO && strings >= *argc + 2) /* The number, the directory and the arguments */
+         return strings == *argc + 2 && request->text[request->size - 1] == '\0';
+   }
+}
+
+
+
+
+static void serve_request(int connection, struct TextBuffer* request, int (*run)(int argc, char* argv[]),
+                          int console_out, int console_err) {
+   char status[STATUS_SIZE]; /* The end of the response: a null character and the exit status */
+   char** argv; /* The arguments of the request */
+   char* directory, * next; /* The working directory of the client, and the next string of the request */
+   int argc, result, i;
+
+   if (!read_request(connection, request, &argc))
+      return; /* Nothing to answer */
+
+   argv = (char**)calloc(argc + 1, sizeof(char*));
+   if (argv == NULL) {
+      perror("Error allocating memory for a request");
+      exit(EXIT_FAILURE);
+   }
+   directory = request->text + strlen(request->text) + 1;
+   next = directory + strlen(directory) + 1;
+   for (i = 0; i < argc; i++, next += strlen(next) + 1)
+      argv[i] = next;
+
+   /* Run the command with the console connected to the client */
+   fflush(stdout);
+   fflush(stderr);
+   dup2(connection, STDOUT_FILENO);
+   dup2(connection, STDERR_FILENO);
+   if (chdir(directory) != 0) {
+      perror("Error entering the working directory of the client");
+      result = 1;
+   }
+   else
+      result = run(argc, argv);
+   fflush(stdout);
+   fflush(stderr);
+
+   sprintf(status, "%c%d", '\0', result);
+   write_all(connection, status, 1 + strlen(status + 1));
+
+   /* Back to the console of the worker */
+   dup2(console_out, STDOUT_FILENO);
+   dup2(console_err, STDERR_FILENO);
+   clearerr(stdout); /* Writes to a client that left failed */
+   clearerr(stderr);
+   free(argv);
+}
+
+
+
+
+static int write_all(int fd, const char* data, size_t length) {
+   ssize_t n; /* Number of bytes written by one call */
+
+   while (length > 0) {
+      n = write(fd, data, length);
+      if (n < 0 && errno == EINTR)
+         continue;
+      if (n <= 0)
+         return FALSE;
+      data += n, length -= n;
+   }
+   return TRUE;
+}
+
+
+
+
+static char* current_directory(void) {
+   size_t size = 256; /* Size of the buffer */
+   char* buffer = NULL, * new_buffer;
+
+   for (;;) {
+      new_buffer = (char*)realloc(buffer, size);
+      if (new_buffer == NULL) {
+         perror("Error allocating memory for the working directory");
+         exit(EXIT_FAILURE);
+      }
+      buffer = new_buffer;
+      if (getcwd(buffer, size) != NULL)
+         return buffer;
+      if (errno != ERANGE) {
+         perror("Error reading the working directory");
+         exit(EXIT_FAILURE);
+      }
+      size *= 2; /* The path is longer than the buffer */
+   }
+}
+
+
+
+
+static void handle_stop(int signal_number) {
+   (void)signal_number;
+   stopping = TRUE;
+}
+
+
+
+
+int run_server(const char* path, int workers, int (*run)(int argc, char* argv[])) {
+   struct sigaction action; /* The handler of SIGINT and SIGTERM */
+   pid_t* pids; /* The process id of every worker */
+   pid_t pid; /* A worker that stopped */
+   int listener, status, i;
+
+   listener = open_listener(path);
+   pids = (pid_t*)calloc(workers, sizeof(pid_t));
+   if (pids == NULL) {
+      perror("Error allocating memory for the server workers");
+      exit(EXIT_FAILURE);
+   }
+
+   /* No SA_RESTART: the signal interrupts wait() so the server notices it */
+   memset(&action, 0, sizeof(action));
+   action.sa_handler = handle_stop;
+   sigemptyset(&action.sa_mask);
+   sigaction(SIGINT, &action, NULL);
+   sigaction(SIGTERM, &action, NULL);
+
+   printf("Serving on %s with %d workers.\n", path, workers);
+   for (i = 0; i < workers; i++)
+      pids[i] = start_server_worker(listener, run);
+
+   /* Replace the workers that die, until the server is asked to stop */
+   while (!stopping) {
+      pid = wait(&status);
+      if (pid < 0) {
+         if (errno == EINTR)
+            continue;
+         perror("Error waiting for the server workers");
+         break;
+      }
+      for (i = 0; i < workers && !stopping; i++) {
+         if (pids[i] == pid) {
+            printf("A server worker stopped, starting another one.\n");
+            pids[i] = start_server_worker(listener, run);
+         }
+      }
+   }
+
+   for (i = 0; i < workers; i++)
+      kill(pids[i], SIGTERM);
+   while (wait(&status) > 0 || errno == EINTR)
+      ; /* Reap all the workers */
+
+   close(listener);
+   unlink(path);
+   free(pids);
+   printf("Server stopped.\n");
+   return 0;
+}
+
+
+
+
+int run_client(const char* path, int argc, char* argv[]) {
+   struct TextBuffer request; /* The request sent to the server */
+   char chunk[SOCKET_CHUNK_SIZE]; /* Bytes received from the server */
+   char status[STATUS_SIZE]; /* The exit status sent by the server */
+   char number[STATUS_SIZE]; /* The number of arguments, in decimal */
+   char* directory, * end; /* The working directory, and the end of the console output in a chunk */
+   size_t status_length = 0; /* Number of characters of the exit status received */
+   ssize_t n; /* Number of bytes received */
+   int fd, i, got_status = FALSE; /* The connection, loop index and TRUE once the console output ended */
+
+   fd = connect_socket(path);
+   if (fd == NO) {
+      perror("Error connecting to the assembler server");
+      return 1;
+   }
+   signal(SIGPIPE, SIG_IGN); /* A server that goes away is reported, not fatal */
+
+   /* The request: the number of arguments, the working directory and the arguments */
+   memset(&request, 0, sizeof(request));
+   sprintf(number, "%d", argc);
+   append_text(&request, number, strlen(number) + 1);
+   directory = current_directory();
+   append_text(&request, directory, strlen(directory) + 1);
+   free(directory);
+   for (i = 0; i < argc; i++)
+      append_text(&request, argv[i], strlen(argv[i]) + 1);
+
+   if (!write_all(fd, request.text, request.size)) {
+      perror("Error sending the request to the assembler server");
+      close(fd);
+      free(request.text);
+      return 1;
+   }
+   free(request.text);
+
+   /* Print the console output as it arrives, up to the null character before the exit status */
+   while ((n = read(fd, chunk, sizeof(chunk))) != 0) {
+      if (n < 0) {
+         if (errno == EINTR)
+            continue;
+         break;
+      }
+      if (!got_status) {
+         end = (char*)memchr(chunk, '\0', n);
+         fwrite(chunk, 1, end != NULL ? (size_t)(end - chunk) : (size_t)n, stdout);
+         fflush(stdout);
+         if (end == NULL)
+            continue;
+         got_status = TRUE;
+         n -= end + 1 - chunk;
+         memmove(chunk, end + 1, n);
+      }
+      for (i = 0; i < n && status_length < STATUS_SIZE - 1; i++)
+         status[status_length++] = chunk[i];
+   }
+   close(fd);
+
+   if (!got_status) {
+      printf("Error: the connection to the assembler server was lost.\n");
+      return 1;
+   }
+   status[status_length] = '\0';
+   return atoi(status);
+}
@@ -0,0 +1,58 @@
+/**
+ * @file assembler_server.h
+ * @brief A long-running assembler server on a local (Unix domain) socket, and its client.
+ *
+ * The server (`--serve PATH`) starts a pool of worker processes once and keeps them running. Every
+ * worker accepts connections on the socket and runs the requests it gets in-process, so a request
+ * pays neither the start of a process nor the loading of the program, and the memory of the worker
+ * is reused from one request to the next. A source that cannot be read or an output file that cannot
+ * be written is an error of its request, reported in the response with exit status 1; only a fatal
+ * error (memory exhausted) ends a worker, and a worker that dies is replaced.
+ *
+ * The client (`--connect PATH`) sends its command line and its working directory, and prints what
+ * the server streams back, so `myassem --connect PATH <arguments>` prints the same and exits with the
+ * same status as `myassem <arguments>`.
+ *
+ * The protocol is a request and a response on one connection:
+ * - Request: the number of arguments in decimal, the working directory of the client and the arguments
+ *   (argv[0] first), each terminated by a null character.
+ * - Response: the console output of the command (stdout and stderr, as it is printed, file by file),
+ *   a null character (never part of the console output) and the exit status in decimal.
+ */
+
+#ifndef ASSEMBLER_SERVER_H
+#define ASSEMBLER_SERVER_H
+#include "auxiliary_functions_constants.h"
+
+#define MAX_REQUEST_SIZE (1 << 20) /* A request is a command line: refuse anything larger */
+
+
+
+/**
+ * @brief Runs the assembler server until it receives SIGINT or SIGTERM.
+ *
+ * @param path The path of the socket to listen on. A socket left there by a server that is no
+ *             longer running is replaced.
+ * @param workers The number of worker processes (requests served at the same time).
+ * @param run The function that runs a command line, like main; it is called in the workers, with
+ *            its stdout and stderr connected to the client. It reports the errors of the command
+ *            and returns its status rather than exiting, which would end the worker mid-request.
+ * @return 0 once the server stopped.
+ *
+ * @note The function exits the program with an error message if the socket cannot be created.
+ */
+int run_server(const char* path, int workers, int (*run)(int argc, char* argv[]));
+
+
+
+/**
+ * @brief Runs a command line on an assembler server and prints its output.
+ *
+ * @param path The path of the socket of the server.
+ * @param argc The number of arguments.
+ * @param argv The arguments (argv[0] first), without the `--connect PATH` option.
+ * @return The exit status of the command, or 1 if the server cannot be reached or the connection was lost.
+ */
+int run_client(const char* path, int argc, char* argv[]);
+
+#endif /* ASSEMBLER_SERVER_H */
@@ -0,0 +1,244 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "assembly_cache.h"
+#include "object_format.h"
+#include "sha256.h"
+
+#define COPY_BUFFER_SIZE 65536
+#define CACHE_MESSAGES "messages"
+#define CACHE_EXPANDED "am"
+
+
+/* The output files an entry may hold, by the extension of the file next to the source */
+static const char* const cached_outputs[] = { "ob", "ent", "ext", "obj" };
+#define CACHED_OUTPUT_COUNT (sizeof(cached_outputs) / sizeof(cached_outputs[0]))
+
+
+/**
+ * @brief Builds the path of a file of a cache entry.
+ *
+ * @param path The buffer to fill (CACHE_PATH_SIZE characters).
+ * @param entry The directory of the entry.
+ * @param name The name of the file in the entry.
+ * @return TRUE if the path fits in the buffer, FALSE otherwise.
+ */
+static int entry_path(char* path, const char* entry, const char* name);
+
+
+
+/**
+ * @brief Copies a file.
+ *
+ * @param from The file to copy.
+ * @param to The copy to create (replaced if it exists).
+ * @return TRUE if the file was copied, FALSE otherwise.
+ */
+static int copy_file(const char* from, const char* to);
+
+
+
+/**
+ * @brief Removes a cache entry that could not be completed, with all its files.
+ *
+ * @param entry The directory of the entry.
+ */
+static void remove_entry(const char* entry);
+
+
+
+
+void cache_key(const char* text, size_t length, int object_format, char* key) {
+   char prefix[64]; /* The version and the format, hashed before the source */
+   size_t prefix_length; /* Length of the prefix, with its null terminators */
+   unsigned char digest[SHA256_DIGEST_SIZE]; /* The digest of the prefix and the source */
+   struct Sha256 sha; /* The digest being computed */
+   int i;
+
+   prefix_length = (size_t)sprintf(prefix, "%s%c%d", ASSEMBLER_VERSION, '\0', object_format) + 1;
+
+   /* A collision-resistant digest: a hit must never copy the results of another source */
+   sha256_init(&sha);
+   sha256_update(&sha, prefix, prefix_length);
+   sha256_update(&sha, text, length);
+   sha256_final(&sha, digest);
+
+   for (i = 0; i < SHA256_DIGEST_SIZE; i++)
+      sprintf(key + 2 * i, "%02x", digest[i]);
+}
+
+
+
+
+static int entry_path(char* path, const char* entry, const char* name) {
+   if (strlen(entry) + strlen(name) + 2 > CACHE_PATH_SIZE)
+      return FALSE;
+   sprintf(path, "%s/%s", entry, name);
+   return TRUE;
+}
+
+
+
+
+static int copy_file(const char* from, const char* to) {
+   char buffer[COPY_BUFFER_SIZE]; /* Block of the file */
+   size_t n; /* Size of the block */
+   FILE* source, * dest;
+   int success = TRUE; /* FALSE once a block could not be copied */
+
+   source = fopen(from, "rb");
+   if (source == NULL)
+      return FALSE;
+   dest = fopen(to, "wb");
+   if (dest == NULL) {
+      fclose(source);
+      return FALSE;
+   }
+
+   while (success && (n = fread(buffer, 1, sizeof(buffer), source)) > 0)
+      success = fwrite(buffer, 1, n, dest) == n;
+   if (ferror(source))
+      success = FALSE;
+
+   fclose(source);
+   if (fclose(dest) != 0)
+      success = FALSE;
+   return success;
+}
+
+
+
+
+static void remove_entry(const char* entry) {
+   char path[CACHE_PATH_SIZE]; /* Path of a file of the entry */
+   size_t i; /* Loop index */
+
+   if (entry_path(path, entry, CACHE_MESSAGES))
+      remove(path);
+   if (entry_path(path, entry, CACHE_EXPANDED))
+      remove(path);
+   for (i = 0; i < CACHED_OUTPUT_COUNT; i++) {
+      if (entry_path(path, entry, cached_outputs[i]))
+         remove(path);
+   }
+   rmdir(entry);
+}
+
+
+
+
+int cache_lookup(const char* dir, const char* key) {
+   char entry[CACHE_PATH_SIZE], path[CACHE_PATH_SIZE]; /* The directory of the entry and its messages file */
+   struct stat info; /* Unused: only the existence of the file matters */
+
+   return entry_path(entry, dir, key) && entry_path(path, entry, CACHE_MESSAGES) && stat(path, &info) == 0;
+}
+
+
+
+
+int cache_restore(const char* dir, const char* key, const char* filename, int keep_am, struct TextBuffer* messages) {
+   char entry[CACHE_PATH_SIZE], path[CACHE_PATH_SIZE], dest[CACHE_PATH_SIZE]; /* The entry, a file in it and its copy */
+   char buffer[COPY_BUFFER_SIZE]; /* Block of the messages */
+   size_t n; /* Size of the block */
+   int result = NO, c; /* The cached result, and its character */
+   FILE* source;
+   size_t i; /* Loop index */
+
+   if (!entry_path(entry, dir, key) || !entry_path(path, entry, CACHE_MESSAGES))
+      return NO;
+
+   /* The result and the messages */
+   source = fopen(path, "rb");
+   if (source == NULL)
+      return NO;
+   if ((c = fgetc(source)) == '0' || c == '1') {
+      result = c == '1' ? TRUE : FALSE;
+      while ((n = fread(buffer, 1, sizeof(buffer), source)) > 0)
+         append_text(messages, buffer, n);
+   }
+   fclose(source);
+   if (result == NO)
+      return NO;
+
+   /* The output files, named after the file */
+   for (i = 0; i < CACHED_OUTPUT_COUNT; i++) {
+      if (!entry_path(path, entry, cached_outputs[i]) || strlen(filename) + strlen(cached_outputs[i]) + 2 > CACHE_PATH_SIZE)
+         return NO;
+      if (access(path, F_OK) != 0)
+         continue; /* The file did not produce this output */
+      sprintf(dest, "%s.%s", filename, cached_outputs[i]);
+      if (!copy_file(path, dest))
+         return NO;
+   }
+
+   if (keep_am) {
+      if (!entry_path(path, entry, CACHE_EXPANDED) || strlen(filename) + 4 > CACHE_PATH_SIZE)
+         return NO;
+      sprintf(dest, "%s.am", filename);
+      if (!copy_file(path, dest))
+         return NO;
+   }
+
+   return result;
+}
+
+
+
+
+void cache_store(const char* dir, const char* key, const struct AssemblerContext* ctx, int result, const char* messages, size_t length) {
+   char temporary[CACHE_PATH_SIZE], entry[CACHE_PATH_SIZE]; /* The entry while it is written, and its final name */
+   char path[CACHE_PATH_SIZE], source[CACHE_PATH_SIZE]; /* A file of the entry, and the output file it is copied from */
+   FILE* dest; /* The file being written */
+   int success; /* FALSE once a file of the entry could not be written */
+   size_t i; /* Loop index */
+
+   if (strlen(dir) + 12 > CACHE_PATH_SIZE || !entry_path(entry, dir, key))
+      return;
+   if (mkdir(dir, 0777) != 0 && errno != EEXIST)
+      return;
+
+   /* Write the entry in a directory of its own, invisible to lookups */
+   sprintf(temporary, "%s/tmp-XXXXXX", dir);
+   if (mkdtemp(temporary) == NULL)
+      return;
+
+   /* The result and the messages */
+   success = entry_path(path, temporary, CACHE_MESSAGES) && (dest = fopen(path, "wb")) != NULL;
+   if (success) {
+      fputc(result ? '1' : '0', dest);
+      fwrite(messages, 1, length, dest);
+      success = fclose(dest) == 0;
+   }
+
+   /* The expanded source */
+   if (success) {
+      success = entry_path(path, temporary, CACHE_EXPANDED) && (dest = fopen(path, "w")) != NULL;
+      if (success) {
+         write_expanded(ctx, dest);
+         success = fclose(dest) == 0;
+      }
+   }
+
+   /* The output files this run wrote */
+   for (i = 0; success && result && i < CACHED_OUTPUT_COUNT; i++) {
+      if (ctx->object_format == OBJECT_FORMAT_BIN ? strcmp(cached_outputs[i], "obj") != 0 :
+          (strcmp(cached_outputs[i], "obj") == 0 ||
+           (strcmp(cached_outputs[i], "ext") == 0 && !ctx->isExternal) ||
+           (strcmp(cached_outputs[i], "ent") == 0 && !ctx->isEntry)))
+         continue;
+      if (strlen(ctx->fileName) + strlen(cached_outputs[i]) + 2 > CACHE_PATH_SIZE || !entry_path(path, temporary, cached_outputs[i])) {
+         success = FALSE;
+         break;
+      }
+      sprintf(source, "%s.%s", ctx->fileName, cached_outputs[i]);
+      success = copy_file(source, path);
+   }
+
+   /* Publish the entry; if another run published the same key first, its entry is kept */
+   if (!success || rename(temporary, entry) != 0)
+      remove_entry(temporary);
+}
@@ -0,0 +1,79 @@
+/**
+ * @file assembly_cache.h
+ * @brief A persistent cache of assembled files, addressed by the content of their source.
+ *
+ * The cache is a directory with an entry (a subdirectory) per key. The key is the SHA-256 digest
+ * of the source bytes together with ASSEMBLER_VERSION and the output format, so a source that did not
+ * change is assembled once and every later run copies its results from the entry. An entry holds:
+ *
+ * - `messages`: the result of the file ('1' if no errors were found, '0' otherwise) followed by the
+ *   messages the pre-assembler, first path and second path reported, replayed on a hit.
+ * - `am`: the expanded source (copied to the .am file on a hit with `--keep-am`).
+ * - `ob`, `ent`, `ext` or `obj`: the output files the file produced, if any.
+ *
+ * An entry is written in a temporary directory and renamed into place, so runs that share the
+ * cache never see a partial entry.
+ */
+
+#ifndef ASSEMBLY_CACHE_H
+#define ASSEMBLY_CACHE_H
+#include "auxiliary_functions_constants.h"
+
+#define CACHE_KEY_SIZE 65 /* Room for a cache key (a SHA-256 digest in hexadecimal) and its null terminator */
+#define CACHE_PATH_SIZE 1024
+
+
+
+/**
+ * @brief Computes the cache key of a source.
+ *
+ * @param text The content of the source file.
+ * @param length The length of the content in bytes.
+ * @param object_format The output format (OBJECT_FORMAT_TEXT or OBJECT_FORMAT_BIN).
+ * @param key The buffer to fill with the key (at least CACHE_KEY_SIZE characters).
+ */
+void cache_key(const char* text, size_t length, int object_format, char* key);
+
+
+
+/**
+ * @brief Checks if the cache has an entry for a key.
+ *
+ * @param dir The cache directory.
+ * @param key The cache key of the source.
+ * @return TRUE if the entry exists, FALSE otherwise.
+ */
+int cache_lookup(const char* dir, const char* key);
+
+
+
+/**
+ * @brief Copies the output files of a cache entry next to the source, and reads its messages.
+ *
+ * @param dir The cache directory.
+ * @param key The cache key of the source.
+ * @param filename The name of the file (without extension) the output files are named after.
+ * @param keep_am TRUE to also copy the expanded source to the .am file.
+ * @param messages The buffer to append the cached messages to.
+ * @return TRUE if the cached file had no errors, FALSE if it had errors, or NO if the entry cannot be read.
+ */
+int cache_restore(const char* dir, const char* key, const char* filename, int keep_am, struct TextBuffer* messages);
+
+
+
+/**
+ * @brief Adds an assembled file to the cache.
+ *
+ * Failing to write to the cache is not an error: the file was assembled, and it is only assembled
+ * again on the next run.
+ *
+ * @param dir The cache directory.
+ * @param key The cache key of the source.
+ * @param ctx The context of the file, after its output files were written (if it had no errors).
+ * @param result TRUE if no errors were found in the file, FALSE otherwise.
+ * @param messages The messages reported by the pre-assembler, the first path and the second path.
+ * @param length The length of the messages.
+ */
+void cache_store(const char* dir, const char* key, const struct AssemblerContext* ctx, int result, const char* messages, size_t length);
+
+#endif /* ASSEMBLY_CACHE_H */
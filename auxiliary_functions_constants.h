@@ -8,8 +8,11 @@
 #include <ctype.h>
 #include <stdint.h>
 #include "pre_assembler.h"
+#include "assembler_context.h"
  
 
+#define ASSEMBLER_VERSION "1.1" /* Part of the cache key: change it whenever the output of a source can change */
+
 #define TRUE 1
 #define FALSE 0
 #define NO -1
@@ -22,8 +25,6 @@
 #define MAX 81
 #define INITIAL_SYMBOLS_TABLE_SIZE 20
 #define MEM_WORD_SIZE 25
-#define INITIAL_CMD_CODE_SIZE 20
-#define INITIAL_DATA_CODE_SIZE 20
 
 #define ADD_NAME 1
 #define FIND_NAME 2
@@ -57,26 +58,21 @@
 #ifndef SYMBOL_STRUCT_DEFINED
 #define SYMBOL_STRUCT_DEFINED
 
+/* The kinds of a symbol, combined in its kind mask */
+#define SYMBOL_CODE 1
+#define SYMBOL_DATA 2
+#define SYMBOL_ENTRY 4
+#define SYMBOL_EXTERNAL 8
+
 struct Symbol {
-    char name[MAX];
+    const char* name; /* The name, stored once in the arena of the file */
     int address;
-    char type[MAX];
-    int* extern_address;
-    int extern_address_size;
+    int kind; /* SYMBOL_CODE, SYMBOL_DATA, SYMBOL_ENTRY and SYMBOL_EXTERNAL bits */
 };
 
 #endif /* SYMBOL_STRUCT_DEFINED */
 
 
-/**
- * @brief Duplicates a string by allocating memory and copying the input string.
- * @param s Pointer to the input string to duplicate.
- * @return Pointer to the duplicated string, or NULL if memory allocation fails.
- */
-char* myStrdup(const char* s);
-
-
-
 /**
  * @brief Copies a word from a row into a buffer until a delimiter is encountered.
  * @param row Pointer to the input string.
@@ -102,6 +98,7 @@ int copy_word_jump_space(char* row, char* word, int i);
 
 /**
  * @brief Copies a word from a row, skips spaces, and validates commas before and after.
+ * @param ctx The context of the file being processed (used for error reporting).
  * @param row Pointer to the input string.
  * @param word Buffer to store the copied word.
  * @param i Pointer to the current index in the string.
@@ -110,7 +107,10 @@ int copy_word_jump_space(char* row, char* word, int i);
  * @param r Line number for error reporting.
  * @return TRUE if the operation and validations pass, FALSE otherwise.
  */
-int copy_word_jump_space_count_coma(char* row, char* word, int* i, int comaValidationBefor, int comaValidationAfter, int r);
+int copy_word_jump_space_count_coma(struct AssemblerContext* ctx, char* row, char* word, int* i, int comaValidationBefor, int comaValidationAfter, int r);
+
+
+
 
 
 
@@ -122,42 +122,24 @@ int copy_word_jump_space_count_coma(char* row, char* word, int* i, int comaValid
 int check_number(char* word);
 
 
-/**
- * @brief Ensures the capacity of a dynamic integer array is sufficient, resizing if needed.
- * @param code Pointer to the pointer of the integer array.
- * @param code_capacity Pointer to the current capacity of the array.
- * @param num Required capacity.
- * @return TRUE if the operation is successful.
- */
-int ensure_capacity(int** code, int* code_capacity, int num);
-
-
-/**
- * @brief Frees the memory allocated for a symbols table and its external addresses.
- * @param symbols_table Pointer to the symbols table to free.
- * @param size Number of entries in the table.
- */
-void free_symbols_table(struct Symbol* symbols_table, int size);
-
-
 /**
  * @brief Checks for illegal extra words or characters after a specified point in a row.
+ * @param ctx The context of the file being processed (used for error reporting).
  * @param row Pointer to the input string.
  * @param i Current index in the string.
  * @param r Line number for error reporting.
  * @param after Description of the context (what comes before the checked part).
  * @return TRUE if no extra words are found, FALSE otherwise.
  */
-int check_extra_word(char* row, int i, int r, char* after);
+int check_extra_word(struct AssemblerContext* ctx, char* row, int i, int r, char* after);
 
 
 /**
  * @brief Expands the size of the symbols table by doubling its capacity and initializing new entries.
- * @param symbols_table Pointer to the pointer of the symbols table.
- * @param symbols_table_size Pointer to the current size of the table.
+ * @param ctx The context of the file (holds the symbols table, its arena and the statistics that count the expansions).
  * @return TRUE if the operation is successful.
  */
-int expand_symbols_table(struct Symbol** symbols_table, int* symbols_table_size);
+int expand_symbols_table(struct AssemblerContext* ctx);
 
 
 #endif /* AUXILIARY_FUNCTIONS_H */
\ No newline at end of file
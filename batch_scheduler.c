@@ -0,0 +1,375 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <pthread.h>
+#include "batch_scheduler.h"
+
+
+/**
+ * @brief A file of the batch, for sorting the batch by size.
+ * @struct BatchFile
+ * @param size The size of the source of the file in bytes.
+ * @param index The index of the file in the batch.
+ */
+struct BatchFile {
+   long size;
+   int index;
+};
+
+
+
+/**
+ * @brief The files waiting to be assembled by one thread, largest first.
+ * @struct WorkQueue
+ * @param lock Protects the queue: its owner and the threads stealing from it take files under it.
+ * @param files The indexes of the files in the batch, from the largest to the smallest.
+ * @param head The position of the next file to take.
+ * @param tail The number of files in `files`.
+ * @param queued_bytes The total size of the files still waiting in the queue.
+ */
+struct WorkQueue {
+   pthread_mutex_t lock;
+   int* files;
+   int head, tail;
+   long queued_bytes;
+};
+
+
+
+/**
+ * @brief The state shared by the threads of a batch.
+ * @struct Scheduler
+ * @param files The file names of the batch.
+ * @param sizes The size of the source of every file.
+ * @param threads The number of worker threads.
+ * @param assemble The function that assembles a single file.
+ * @param queues The queue of every thread.
+ * @param outputs The console output of every file.
+ * @param done For every file, TRUE once it was assembled (protected by `lock`).
+ * @param failed TRUE once a file could not be assembled (protected by `lock`).
+ * @param lock Protects `done`, `failed` and `end`.
+ * @param finished Signaled every time a file is done.
+ * @param start The time the threads were started.
+ * @param end The time the last file was done (protected by `lock`).
+ * @param busy For every thread, the time it spent assembling files.
+ * @param files_done For every thread, the number of files it assembled.
+ * @param steals For every thread, the number of files it took from other queues.
+ */
+struct Scheduler {
+   char** files;
+   const long* sizes;
+   int threads;
+   int (*assemble)(char* filename, struct TextBuffer* console);
+   struct WorkQueue* queues;
+   struct TextBuffer* outputs;
+   int* done;
+   int failed;
+   pthread_mutex_t lock;
+   pthread_cond_t finished;
+   double start, end;
+   double* busy;
+   int* files_done;
+   int* steals;
+};
+
+
+
+/**
+ * @brief The argument of a worker thread.
+ * @struct Worker
+ * @param scheduler The state shared by the threads.
+ * @param id The index of the thread (and of its queue).
+ */
+struct Worker {
+   struct Scheduler* scheduler;
+   int id;
+};
+
+
+
+/**
+ * @brief Orders files by size, largest first, and by their order in the batch when the sizes are equal.
+ *
+ * @param a The first file (struct BatchFile).
+ * @param b The second file (struct BatchFile).
+ * @return A negative number if `a` comes first, a positive number if `b` comes first.
+ */
+static int compare_files(const void* a, const void* b);
+
+
+
+/**
+ * @brief Takes the next file from a queue.
+ *
+ * @param scheduler The state shared by the threads.
+ * @param queue The queue to take the file from.
+ * @return The index of the file, or NO if the queue is empty.
+ */
+static int take_file(struct Scheduler* scheduler, struct WorkQueue* queue);
+
+
+
+/**
+ * @brief Finds the next file for a thread: the largest of its own queue, or else a file stolen from another queue.
+ *
+ * The thread steals the largest waiting file of the queue with the most work left. Files are never
+ * added to the queues once the batch started, so when all the queues are empty the thread is done.
+ *
+ * @param scheduler The state shared by the threads.
+ * @param id The index of the thread.
+ * @return The index of the file, or NO if no file is waiting.
+ */
+static int next_file(struct Scheduler* scheduler, int id);
+
+
+
+/**
+ * @brief The body of a worker thread: assembles files until no file is waiting.
+ *
+ * @param argument The worker (struct Worker).
+ * @return NULL.
+ */
+static void* run_worker(void* argument);
+
+
+
+/**
+ * @brief Exits the program with an error message if a threads function failed.
+ *
+ * @param error The value returned by the function (0 on success).
+ * @param message The message to print.
+ */
+static void check_thread_error(int error, const char* message);
+
+
+
+/**
+ * @brief Allocates zeroed memory, exiting the program on failure.
+ *
+ * @param count The number of elements.
+ * @param size The size of a single element.
+ * @return Pointer to the allocated memory.
+ */
+static void* allocate_zeroed(size_t count, size_t size);
+
+
+
+
+static int compare_files(const void* a, const void* b) {
+   const struct BatchFile* first = (const struct BatchFile*)a, * second = (const struct BatchFile*)b;
+
+   if (first->size != second->size)
+      return first->size > second->size ? -1 : 1;
+   return first->index - second->index;
+}
+
+
+
+
+static int take_file(struct Scheduler* scheduler, struct WorkQueue* queue) {
+   int file = NO; /* The file taken */
+
+   pthread_mutex_lock(&queue->lock);
+   if (queue->head < queue->tail) {
+      file = queue->files[queue->head++];
+      queue->queued_bytes -= scheduler->sizes[file];
+   }
+   pthread_mutex_unlock(&queue->lock);
+   return file;
+}
+
+
+
+
+static int next_file(struct Scheduler* scheduler, int id) {
+   int file, victim, i; /* The file found, the queue to steal from and a queue index */
+   long most, queued; /* The most work left in a queue, and the work left in the current one */
+
+   if ((file = take_file(scheduler, &scheduler->queues[id])) != NO)
+      return file;
+
+   /* Steal: the queue with the most work left may have been emptied meanwhile, so look again until all are empty */
+   for (;;) {
+      victim = NO, most = NO;
+      for (i = 0; i < scheduler->threads; i++) {
+         pthread_mutex_lock(&scheduler->queues[i].lock);
+         queued = scheduler->queues[i].head < scheduler->queues[i].tail ? scheduler->queues[i].queued_bytes : NO;
+         pthread_mutex_unlock(&scheduler->queues[i].lock);
+         if (queued > most)
+            most = queued, victim = i;
+      }
+      if (victim == NO)
+         return NO; /* Nothing is waiting anywhere */
+
+      if ((file = take_file(scheduler, &scheduler->queues[victim])) != NO) {
+         scheduler->steals[id]++;
+         return file;
+      }
+   }
+}
+
+
+
+
+static void* run_worker(void* argument) {
+   struct Worker* worker = (struct Worker*)argument;
+   struct Scheduler* scheduler = worker->scheduler;
+   double start, end; /* Time before and after assembling a file */
+   int file, assembled; /* Index of the current file, and FALSE if it could not be assembled */
+
+   while ((file = next_file(scheduler, worker->id)) != NO) {
+      start = stats_clock();
+      assembled = scheduler->assemble(scheduler->files[file], &scheduler->outputs[file]);
+      end = stats_clock();
+
+      scheduler->busy[worker->id] += end - start;
+      scheduler->files_done[worker->id]++;
+
+      /* Let the calling thread print the file */
+      pthread_mutex_lock(&scheduler->lock);
+      scheduler->done[file] = TRUE;
+      if (!assembled)
+         scheduler->failed = TRUE;
+      if (end > scheduler->end)
+         scheduler->end = end;
+      pthread_cond_broadcast(&scheduler->finished);
+      pthread_mutex_unlock(&scheduler->lock);
+   }
+   return NULL;
+}
+
+
+
+
+static void check_thread_error(int error, const char* message) {
+   if (error != 0) {
+      errno = error;
+      perror(message);
+      exit(EXIT_FAILURE);
+   }
+}
+
+
+
+
+static void* allocate_zeroed(size_t count, size_t size) {
+   void* memory = calloc(count > 0 ? count : 1, size); /* Never ask for zero bytes */
+   if (memory == NULL) {
+      perror("Error allocating memory for the batch scheduler");
+      exit(EXIT_FAILURE);
+   }
+   return memory;
+}
+
+
+
+
+int run_batch_scheduler(char* files[], const long* sizes, int file_count, int threads,
+                        int (*assemble)(char* filename, struct TextBuffer* console), struct BatchReport* report) {
+   struct Scheduler scheduler; /* State shared by the threads */
+   struct BatchFile* order; /* The files, largest first */
+   struct Worker* workers; /* The argument of every thread */
+   pthread_t* handles; /* The threads */
+   struct WorkQueue* queue; /* The queue a file is dealt to */
+   int i, printed; /* Loop index and the next file to print */
+
+   if (threads > file_count)
+      threads = file_count; /* A thread without a file would only steal */
+   if (threads < 1)
+      threads = 1;
+
+   memset(&scheduler, 0, sizeof(scheduler));
+   scheduler.files = files;
+   scheduler.sizes = sizes;
+   scheduler.threads = threads;
+   scheduler.assemble = assemble;
+   scheduler.queues = (struct WorkQueue*)allocate_zeroed(threads, sizeof(struct WorkQueue));
+   scheduler.outputs = (struct TextBuffer*)allocate_zeroed(file_count, sizeof(struct TextBuffer));
+   scheduler.done = (int*)allocate_zeroed(file_count, sizeof(int));
+   scheduler.busy = (double*)allocate_zeroed(threads, sizeof(double));
+   scheduler.files_done = (int*)allocate_zeroed(threads, sizeof(int));
+   scheduler.steals = (int*)allocate_zeroed(threads, sizeof(int));
+   workers = (struct Worker*)allocate_zeroed(threads, sizeof(struct Worker));
+   handles = (pthread_t*)allocate_zeroed(threads, sizeof(pthread_t));
+   check_thread_error(pthread_mutex_init(&scheduler.lock, NULL), "Error creating the batch lock");
+   check_thread_error(pthread_cond_init(&scheduler.finished, NULL), "Error creating the batch condition");
+
+   /* Sort the files by size and deal them round-robin, so every thread starts with one of the largest */
+   order = (struct BatchFile*)allocate_zeroed(file_count, sizeof(struct BatchFile));
+   for (i = 0; i < file_count; i++)
+      order[i].size = sizes[i], order[i].index = i;
+   qsort(order, file_count, sizeof(struct BatchFile), compare_files);
+
+   for (i = 0; i < threads; i++) {
+      scheduler.queues[i].files = (int*)allocate_zeroed(file_count / threads + 1, sizeof(int));
+      check_thread_error(pthread_mutex_init(&scheduler.queues[i].lock, NULL), "Error creating a queue lock");
+   }
+   for (i = 0; i < file_count; i++) {
+      queue = &scheduler.queues[i % threads];
+      queue->files[queue->tail++] = order[i].index;
+      queue->queued_bytes += order[i].size;
+   }
+   free(order);
+
+   /* Start the threads */
+   fflush(stdout);
+   scheduler.start = stats_clock();
+   scheduler.end = scheduler.start;
+   for (i = 0; i < threads; i++) {
+      workers[i].scheduler = &scheduler;
+      workers[i].id = i;
+      check_thread_error(pthread_create(&handles[i], NULL, run_worker, &workers[i]), "Error creating a worker thread");
+   }
+
+   /* Print the output of the finished files, keeping the argv order */
+   for (printed = 0; printed < file_count; printed++) {
+      pthread_mutex_lock(&scheduler.lock);
+      while (!scheduler.done[printed])
+         pthread_cond_wait(&scheduler.finished, &scheduler.lock);
+      pthread_mutex_unlock(&scheduler.lock);
+
+      fwrite(scheduler.outputs[printed].text, 1, scheduler.outputs[printed].size, stdout);
+      fflush(stdout);
+      free(scheduler.outputs[printed].text);
+   }
+
+   for (i = 0; i < threads; i++)
+      pthread_join(handles[i], NULL);
+
+   if (report != NULL) {
+      /* Hand the per-thread counters over to the report */
+      report->threads = threads;
+      report->makespan = scheduler.end - scheduler.start;
+      report->busy = scheduler.busy;
+      report->files_done = scheduler.files_done;
+      report->steals = scheduler.steals;
+   }
+   else {
+      free(scheduler.busy);
+      free(scheduler.files_done);
+      free(scheduler.steals);
+   }
+
+   for (i = 0; i < threads; i++) {
+      pthread_mutex_destroy(&scheduler.queues[i].lock);
+      free(scheduler.queues[i].files);
+   }
+   pthread_mutex_destroy(&scheduler.lock);
+   pthread_cond_destroy(&scheduler.finished);
+   free(scheduler.queues);
+   free(scheduler.outputs);
+   free(scheduler.done);
+   free(workers);
+   free(handles);
+   return !scheduler.failed;
+}
+
+
+
+
+void free_batch_report(struct BatchReport* report) {
+   free(report->busy);
+   free(report->files_done);
+   free(report->steals);
+   memset(report, 0, sizeof(*report));
+}
@@ -0,0 +1,63 @@
+#ifndef BATCH_SCHEDULER_H
+#define BATCH_SCHEDULER_H
+#include "auxiliary_functions_constants.h"
+
+
+
+/**
+ * @brief How a batch was spread over the threads, for tuning the number of threads.
+ * @struct BatchReport
+ * @param threads The number of worker threads.
+ * @param makespan The wall time of the whole batch in seconds, from starting the threads to the last file done.
+ * @param busy For every thread, the time it spent assembling files, in seconds.
+ * @param files_done For every thread, the number of files it assembled.
+ * @param steals For every thread, the number of files it took from the queues of other threads.
+ */
+struct BatchReport {
+   int threads;
+   double makespan;
+   double* busy;
+   int* files_done;
+   int* steals;
+};
+
+
+
+/**
+ * @brief Assembles a batch of files on a pool of threads, largest files first, with work stealing.
+ *
+ * The files are sorted by size, largest first, and dealt round-robin to a queue per thread, so
+ * every thread starts with one of the largest files. A thread assembles the files of its own queue
+ * from the largest one down; once its queue is empty it steals the largest queued file of the thread
+ * with the most work left, so no thread stays idle while files are waiting and the big files do not
+ * end up last.
+ *
+ * Every file is assembled with its own context, and its console output is collected in a buffer.
+ * The calling thread prints the buffers in the original argv order, each as soon as the files
+ * before it were printed, so the output is the same as assembling the files one after the other.
+ *
+ * @param files Array of file names (without extension) to assemble.
+ * @param sizes The size of the source of every file, in bytes (the order of the schedule).
+ * @param file_count Number of entries in `files`.
+ * @param threads Number of worker threads.
+ * @param assemble The function that assembles a single file, appending its console output to a buffer.
+ *                 It returns FALSE if the file could not be assembled (its source cannot be read), and
+ *                 is called from several threads at the same time.
+ * @param report The report to fill (freed with free_batch_report), or NULL if it is not needed.
+ * @return TRUE if every file was assembled, FALSE if the source of a file could not be read.
+ *
+ * @note The function exits the program with an error message if a thread cannot be created or memory allocation fails.
+ */
+int run_batch_scheduler(char* files[], const long* sizes, int file_count, int threads,
+                        int (*assemble)(char* filename, struct TextBuffer* console), struct BatchReport* report);
+
+
+
+/**
+ * @brief Frees the arrays of a batch report.
+ *
+ * @param report The report to free.
+ */
+void free_batch_report(struct BatchReport* report);
+
+#endif /* BATCH_SCHEDULER_H */
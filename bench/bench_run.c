@@ -0,0 +1,172 @@
+/**
+ * @file bench_run.c
+ * @brief Runs the assembler on a list of sources and reports the throughput and peak memory of each run.
+ *
+ * Every source is assembled by a separate process of the assembler (with its output discarded),
+ * so the measurement covers the whole run: reading the source, the macro expansion, both passes
+ * and writing the output files. For each source the harness prints its number of lines, the
+ * best wall time over the repetitions, the lines assembled per second and the peak resident
+ * memory of the assembler process.
+ *
+ * Usage: bench_run [-r repetitions] <assembler> <name>...
+ * where every <name>.as is a source (without the extension, as given to the assembler).
+ */
+
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#else
+#define _DEFAULT_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define DEFAULT_REPETITIONS 3
+#define NAME_SIZE 256
+#define READ_BUFFER_SIZE 65536
+
+
+/**
+ * @brief Counts the lines of a source file.
+ *
+ * @param name The name of the source, without the .as extension.
+ * @return The number of lines, or -1 if the file cannot be read.
+ */
+static long count_lines(const char* name);
+
+
+
+/**
+ * @brief Assembles a source once in a child process.
+ *
+ * @param assembler The path of the assembler executable.
+ * @param name The name of the source, as given to the assembler.
+ * @param seconds Pointer to store the wall time of the run.
+ * @param peak_kb Pointer to store the peak resident memory of the run, in kilobytes.
+ * @return 0 if the assembler ran and exited successfully, -1 otherwise.
+ */
+static int run_once(const char* assembler, const char* name, double* seconds, long* peak_kb);
+
+
+
+
+static long count_lines(const char* name) {
+   char filename[NAME_SIZE]; /* Name of the .as file */
+   char buffer[READ_BUFFER_SIZE]; /* Block of the file */
+   size_t read, i; /* Size of the block and position in it */
+   long lines = 0; /* Number of newlines */
+   FILE* source;
+
+   if (strlen(name) + 4 > NAME_SIZE)
+      return -1;
+   sprintf(filename, "%s.as", name);
+   source = fopen(filename, "rb");
+   if (source == NULL)
+      return -1;
+
+   while ((read = fread(buffer, 1, sizeof(buffer), source)) > 0) {
+      for (i = 0; i < read; i++)
+         if (buffer[i] == '\n')
+            lines++;
+   }
+   fclose(source);
+   return lines;
+}
+
+
+
+
+static int run_once(const char* assembler, const char* name, double* seconds, long* peak_kb) {
+   struct timespec start, end; /* Wall clock before and after the run */
+   struct rusage usage; /* Resource usage of the child */
+   int status, null_fd; /* Exit status of the child and the descriptor of /dev/null */
+   pid_t pid;
+
+   clock_gettime(CLOCK_MONOTONIC, &start);
+   pid = fork();
+   if (pid < 0) {
+      perror("Error creating process");
+      return -1;
+   }
+   if (pid == 0) {
+      /* The messages of the assembler are not part of the measurement */
+      null_fd = open("/dev/null", O_WRONLY);
+      if (null_fd >= 0) {
+         dup2(null_fd, STDOUT_FILENO);
+         close(null_fd);
+      }
+      execl(assembler, assembler, name, (char*)NULL);
+      perror("Error running the assembler");
+      _exit(127);
+   }
+
+   if (wait4(pid, &status, 0, &usage) < 0) {
+      perror("Error waiting for the assembler");
+      return -1;
+   }
+   clock_gettime(CLOCK_MONOTONIC, &end);
+
+   *seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+   *peak_kb = usage.ru_maxrss; /* Kilobytes on Linux */
+   return WIFEXITED(status) && WEXITSTATUS(status) == 0 ? 0 : -1;
+}
+
+
+
+
+int main(int argc, char* argv[]) {
+   int repetitions = DEFAULT_REPETITIONS; /* Runs of every source; the best one is reported */
+   const char* assembler; /* Path of the assembler executable */
+   double seconds, best; /* Wall time of a run and the best one of a source */
+   long peak_kb, best_peak_kb; /* Peak resident memory of a run and the largest one of a source */
+   long lines; /* Lines of the current source */
+   int first, i, r; /* Index of the first source, argument index and repetition */
+
+   first = 1;
+   if (argc > 2 && strcmp(argv[1], "-r") == 0) {
+      repetitions = atoi(argv[2]);
+      first = 3;
+   }
+   if (argc < first + 2 || repetitions <= 0) {
+      printf("Usage: %s [-r repetitions] <assembler> <name>...\n", argv[0]);
+      return 1;
+   }
+   assembler = argv[first++];
+
+   printf("%-24s %10s %10s %14s %12s\n", "source", "lines", "ms", "lines/sec", "peak RSS KB");
+   for (i = first; i < argc; i++) {
+      lines = count_lines(argv[i]);
+      if (lines < 0) {
+         printf("%-24s cannot read %s.as\n", argv[i], argv[i]);
+         continue;
+      }
+
+      best = -1, best_peak_kb = 0;
+      for (r = 0; r < repetitions; r++) {
+         if (run_once(assembler, argv[i], &seconds, &peak_kb) != 0) {
+            best = -1;
+            break;
+         }
+         if (best < 0 || seconds < best)
+            best = seconds;
+         if (peak_kb > best_peak_kb)
+            best_peak_kb = peak_kb;
+      }
+      if (best < 0) {
+         printf("%-24s assembler failed\n", argv[i]);
+         continue;
+      }
+
+      printf("%-24s %10ld %10.2f %14.0f %12ld\n", argv[i], lines, best * 1000,
+             best > 0 ? lines / best : 0.0, best_peak_kb);
+   }
+   return 0;
+}
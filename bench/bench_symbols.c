@@ -0,0 +1,90 @@
+/**
+ * @file bench_symbols.c
+ * @brief Measures how assembling scales with the number of labels in a source.
+ *
+ * For growing numbers of labels N, generates a source in memory that defines N code labels,
+ * jumps to every one of them and declares every eighth one as an entry, assembles it with
+ * libmyassem, and prints the time per label. With a hash-indexed symbols table the time per
+ * label stays flat as N grows; with a linearly scanned table it grows with N.
+ *
+ * Usage: bench_symbols [max_labels]
+ */
+
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "myassem.h"
+
+#define FIRST_LABEL_COUNT 1000
+#define DEFAULT_MAX_LABELS 128000
+#define LINE_SIZE 32
+
+
+/**
+ * @brief Generates a source with a number of labels, references to them and entries.
+ *
+ * @param labels The number of labels to define.
+ * @param length Pointer to store the length of the source.
+ * @return A newly allocated source (to be freed by the caller).
+ */
+static char* generate_source(int labels, size_t* length);
+
+
+
+
+static char* generate_source(int labels, size_t* length) {
+   char* source; /* The generated source */
+   int i; /* Label number */
+
+   source = (char*)malloc((size_t)labels * 3 * LINE_SIZE + LINE_SIZE);
+   if (source == NULL) {
+      perror("Error allocating memory for source");
+      exit(EXIT_FAILURE);
+   }
+
+   *length = 0;
+   for (i = 0; i < labels; i++) /* Definitions */
+      *length += sprintf(source + *length, "L%d: inc r1\n", i);
+   for (i = labels - 1; i >= 0; i--) /* References, last label first */
+      *length += sprintf(source + *length, " jmp L%d\n", i);
+   for (i = 0; i < labels; i += 8) /* Entries */
+      *length += sprintf(source + *length, ".entry L%d\n", i);
+   *length += sprintf(source + *length, " stop\n");
+   return source;
+}
+
+
+
+
+int main(int argc, char* argv[]) {
+   struct AssemblyResult result; /* The result of assembling a source */
+   int labels, max_labels; /* Number of labels in the current and the last source */
+   char* source; /* The current source */
+   size_t length; /* Length of the current source */
+   clock_t start; /* Processor time before assembling */
+   double seconds; /* Processor time of assembling */
+
+   max_labels = argc > 1 ? atoi(argv[1]) : DEFAULT_MAX_LABELS;
+
+   printf("%10s %12s %16s\n", "labels", "time (ms)", "per label (us)");
+   for (labels = FIRST_LABEL_COUNT; labels <= max_labels; labels *= 2) {
+      source = generate_source(labels, &length);
+
+      start = clock();
+      if (!assemble_source(source, length, &result)) {
+         printf("Errors in the generated source:\n%s", result.diagnostics);
+         return 1;
+      }
+      seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+      printf("%10d %12.1f %16.3f\n", labels, seconds * 1000, seconds * 1e6 / labels);
+      free_assembly_result(&result);
+      free(source);
+   }
+   return 0;
+}
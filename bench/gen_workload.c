@@ -0,0 +1,220 @@
+/**
+ * @file gen_workload.c
+ * @brief Generates a large assembly source (.as) with a chosen shape, for benchmarking the assembler.
+ *
+ * The generated program is valid: it assembles without errors. Its shape is set by the options:
+ *
+ * - `-l N` N code labels, each one jumped to from another instruction (every eighth one is an entry).
+ * - `-m M` M macros, defined at the start of the source.
+ * - `-k K` K lines in the body of every macro.
+ * - `-c C` C invocations of every macro, spread over the code.
+ * - `-d D` D data lines, alternating `.data` lists and `.string` literals.
+ * - `-x X` X uses of external symbols, spread over the code.
+ *
+ * Usage: gen_workload [-l N] [-m M] [-k K] [-c C] [-d D] [-x X] <name>
+ * writes <name>.as and prints its number of lines.
+ */
+
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EXTERNAL_SYMBOLS 16 /* Number of external symbols the uses are spread over */
+#define DATA_VALUES 8 /* Numbers on every .data line */
+#define NAME_SIZE 256
+
+
+/**
+ * @brief The shape of the generated source.
+ * @struct Workload
+ * @param labels Number of code labels.
+ * @param macros Number of macros.
+ * @param body_lines Number of lines in the body of every macro.
+ * @param calls Number of invocations of every macro.
+ * @param data_lines Number of data lines.
+ * @param externals Number of uses of external symbols.
+ */
+struct Workload {
+   long labels;
+   long macros;
+   long body_lines;
+   long calls;
+   long data_lines;
+   long externals;
+};
+
+
+
+/**
+ * @brief Writes the source of a workload.
+ *
+ * @param dest The file to write to.
+ * @param workload The shape of the source.
+ * @return The number of lines written.
+ */
+static long write_workload(FILE* dest, const struct Workload* workload);
+
+
+
+/**
+ * @brief Writes a line of the code section that is not a label definition.
+ *
+ * Cycles through instructions that use a register, an immediate and a relative jump, so the
+ * first and second paths see a mix of addressing methods.
+ *
+ * @param dest The file to write to.
+ * @param n A running number that selects the instruction.
+ * @param labels Number of code labels (the jump targets).
+ */
+static void write_filler(FILE* dest, long n, long labels);
+
+
+
+
+static void write_filler(FILE* dest, long n, long labels) {
+   switch (n % 4) {
+   case 0:
+      fprintf(dest, " add r%ld, r%ld\n", 1 + n % 7, 1 + (n + 3) % 7);
+      break;
+   case 1:
+      fprintf(dest, " prn #%ld\n", n % 1000 - 500);
+      break;
+   case 2:
+      if (labels > 0) {
+         fprintf(dest, " jmp &L%ld\n", (n * 7) % labels);
+         break;
+      }
+      /* No label to jump to */
+      fprintf(dest, " inc r%ld\n", 1 + n % 7);
+      break;
+   default:
+      fprintf(dest, " cmp r%ld, #%ld\n", 1 + n % 7, n % 100);
+      break;
+   }
+}
+
+
+
+
+static long write_workload(FILE* dest, const struct Workload* workload) {
+   long i, j, lines; /* Loop counters and the number of lines written */
+   long code_lines, slot; /* Lines of the code section and the current one */
+   long next_call, next_external; /* Counters of the macro invocations and external uses written */
+   long calls, externals; /* Total macro invocations and external uses to spread */
+
+   lines = 0;
+
+   /* External symbols */
+   if (workload->externals > 0) {
+      for (i = 0; i < EXTERNAL_SYMBOLS; i++, lines++)
+         fprintf(dest, ".extern EXT%ld\n", i);
+   }
+
+   /* Macro definitions */
+   for (i = 0; i < workload->macros; i++) {
+      fprintf(dest, "mcro M%ld\n", i);
+      for (j = 0; j < workload->body_lines; j++)
+         write_filler(dest, i + j, workload->labels);
+      fprintf(dest, "mcroend\n");
+      lines += workload->body_lines + 2;
+   }
+
+   /* Code section: the labels, with the macro invocations and external uses spread between them */
+   calls = workload->macros * workload->calls;
+   externals = workload->externals;
+   code_lines = workload->labels + calls + externals;
+   next_call = 0, next_external = 0;
+   for (slot = 0, i = 0; slot < code_lines; slot++, lines++) {
+      if (next_call < calls && next_call * code_lines <= slot * calls) {
+         fprintf(dest, "M%ld\n", next_call % workload->macros);
+         next_call++;
+      }
+      else if (next_external < externals && next_external * code_lines <= slot * externals) {
+         fprintf(dest, " mov EXT%ld, r%ld\n", next_external % EXTERNAL_SYMBOLS, 1 + next_external % 7);
+         next_external++;
+      }
+      else if (i < workload->labels) {
+         fprintf(dest, "L%ld: jmp L%ld\n", i, (i * 31 + 17) % workload->labels);
+         i++;
+      }
+      else
+         write_filler(dest, slot, workload->labels);
+   }
+   fprintf(dest, " stop\n");
+   lines++;
+
+   /* Entries */
+   for (i = 0; i < workload->labels; i += 8, lines++)
+      fprintf(dest, ".entry L%ld\n", i);
+
+   /* Data section */
+   for (i = 0; i < workload->data_lines; i++, lines++) {
+      if (i % 2 == 0) {
+         fprintf(dest, "D%ld: .data", i);
+         for (j = 0; j < DATA_VALUES; j++)
+            fprintf(dest, "%s%ld", j == 0 ? " " : ", ", (i * 13 + j * 101) % 4000 - 2000);
+         fprintf(dest, "\n");
+      }
+      else
+         fprintf(dest, "S%ld: .string \"workload string %ld\"\n", i, i);
+   }
+
+   return lines;
+}
+
+
+
+
+int main(int argc, char* argv[]) {
+   struct Workload workload = { 1000, 0, 0, 0, 0, 0 }; /* The shape of the source */
+   char filename[NAME_SIZE]; /* Name of the .as file */
+   const char* name = NULL; /* Name of the workload */
+   long* option; /* The value of the current option */
+   FILE* dest; /* The generated file */
+   long lines; /* Number of lines written */
+   int i; /* Argument index */
+
+   for (i = 1; i < argc; i++) {
+      option = NULL;
+      if (strcmp(argv[i], "-l") == 0) option = &workload.labels;
+      else if (strcmp(argv[i], "-m") == 0) option = &workload.macros;
+      else if (strcmp(argv[i], "-k") == 0) option = &workload.body_lines;
+      else if (strcmp(argv[i], "-c") == 0) option = &workload.calls;
+      else if (strcmp(argv[i], "-d") == 0) option = &workload.data_lines;
+      else if (strcmp(argv[i], "-x") == 0) option = &workload.externals;
+      else if (argv[i][0] == '-' || name != NULL) {
+         name = NULL; /* An unknown option or a second name: print the usage */
+         break;
+      }
+      else name = argv[i];
+
+      if (option != NULL) {
+         if (i + 1 >= argc || (*option = atol(argv[i + 1])) < 0) {
+            printf("Error: %s requires a number.\n", argv[i]);
+            return 1;
+         }
+         i++;
+      }
+   }
+
+   if (name == NULL || strlen(name) + 4 > NAME_SIZE) {
+      printf("Usage: %s [-l labels] [-m macros] [-k body_lines] [-c calls] [-d data_lines] [-x external_uses] <name>\n", argv[0]);
+      return 1;
+   }
+
+   sprintf(filename, "%s.as", name);
+   dest = fopen(filename, "w");
+   if (dest == NULL) {
+      perror("Error opening workload file");
+      return 1;
+   }
+   lines = write_workload(dest, &workload);
+   fclose(dest);
+
+   printf("%s: %ld lines\n", filename, lines);
+   return 0;
+}
@@ -0,0 +1,342 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/inotify.h>
+#include "file_watcher.h"
+
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO) /* A source was saved, in place or renamed into the directory */
+#define EVENT_BUFFER_SIZE 65536
+#define INITIAL_WATCHED_FILES 16
+
+
+/**
+ * @brief A source of the watched directory.
+ * @struct WatchedFile
+ * @param filename The path of the source without the .as extension (the directory, a slash and the name).
+ * @param content The content of the source when it was last assembled.
+ * @param assembled TRUE once the source was assembled (its content is set).
+ * @param pending TRUE if the source changed since it was last assembled.
+ */
+struct WatchedFile {
+   char* filename;
+   struct TextBuffer content;
+   int assembled;
+   int pending;
+};
+
+
+
+/**
+ * @brief The state of the watcher, kept for as long as the directory is watched.
+ * @struct Watcher
+ * @param dir The watched directory.
+ * @param files The sources seen so far.
+ * @param file_count The number of sources in `files`.
+ * @param capacity The allocated size of `files`.
+ * @param index Index of `files` by file name.
+ * @param content The buffer the sources are read into, reused for every source.
+ */
+struct Watcher {
+   const char* dir;
+   struct WatchedFile* files;
+   int file_count, capacity;
+   struct HashIndex index;
+   struct TextBuffer content;
+};
+
+
+
+/**
+ * @brief Returns the file name of a source, for the index of the sources.
+ *
+ * @param table The sources (struct WatchedFile).
+ * @param id The index of the source.
+ * @return The file name of the source.
+ */
+static const char* watched_file_name(const void* table, int id);
+
+
+
+/**
+ * @brief Marks a source of the directory as changed, adding it to the table the first time it is seen.
+ *
+ * @param watcher The state of the watcher.
+ * @param name The name of the file in the directory.
+ * @return TRUE if the file is a source (a .as file), FALSE if it was ignored.
+ */
+static int mark_changed(struct Watcher* watcher, const char* name);
+
+
+
+/**
+ * @brief Marks all the sources of the directory as changed.
+ *
+ * @param watcher The state of the watcher.
+ * @return TRUE if the directory was read, FALSE otherwise (an error message is printed).
+ */
+static int scan_directory(struct Watcher* watcher);
+
+
+
+/**
+ * @brief Checks if the content of a source differs from the content it was last assembled with.
+ *
+ * @param watcher The state of the watcher.
+ * @param file The source; its content is replaced when it changed.
+ * @return TRUE if the source changed (or was never assembled), FALSE if it did not or cannot be read.
+ */
+static int source_changed(struct Watcher* watcher, struct WatchedFile* file);
+
+
+
+/**
+ * @brief Assembles the changed sources.
+ *
+ * @param watcher The state of the watcher.
+ * @param assemble The function that assembles a single file.
+ */
+static void assemble_changed(struct Watcher* watcher, int (*assemble)(char* filename));
+
+
+
+/**
+ * @brief Frees the state of the watcher.
+ *
+ * @param watcher The state to free.
+ */
+static void free_watcher(struct Watcher* watcher);
+
+
+
+
+static const char* watched_file_name(const void* table, int id) {
+   return ((const struct WatchedFile*)table)[id].filename;
+}
+
+
+
+
+static int mark_changed(struct Watcher* watcher, const char* name) {
+   size_t length = strlen(name), dir_length = strlen(watcher->dir); /* Lengths of the name and the directory */
+   struct WatchedFile* file, * new_files; /* The source, and the table when it grows */
+   char* filename; /* The path of the source without the extension */
+   int id; /* Index of the source in the table */
+
+   if (length <= 3 || strcmp(name + length - 3, ".as") != 0)
+      return FALSE;
+
+   filename = (char*)malloc(dir_length + length - 1); /* The slash replaces the ".as", and the null terminator */
+   if (filename == NULL) {
+      perror("Error allocating memory for a watched file");
+      exit(EXIT_FAILURE);
+   }
+   sprintf(filename, "%s/%.*s", watcher->dir, (int)(length - 3), name);
+
+   id = hash_index_find(&watcher->index, filename, strlen(filename), watched_file_name, watcher->files);
+   if (id != NO) { /* Already known */
+      free(filename);
+      watcher->files[id].pending = TRUE;
+      return TRUE;
+   }
+
+   if (watcher->file_count == watcher->capacity) { /* Double the table */
+      watcher->capacity = watcher->capacity > 0 ? watcher->capacity * 2 : INITIAL_WATCHED_FILES;
+      new_files = (struct WatchedFile*)realloc(watcher->files, watcher->capacity * sizeof(struct WatchedFile));
+      if (new_files == NULL) {
+         perror("Error reallocating memory for the watched files");
+         exit(EXIT_FAILURE);
+      }
+      watcher->files = new_files;
+   }
+   file = &watcher->files[watcher->file_count];
+   memset(file, 0, sizeof(*file));
+   file->filename = filename;
+   file->pending = TRUE;
+   hash_index_insert(&watcher->index, filename, strlen(filename), watcher->file_count++);
+   return TRUE;
+}
+
+
+
+
+static int scan_directory(struct Watcher* watcher) {
+   DIR* directory; /* The watched directory */
+   struct dirent* entry; /* A file of the directory */
+
+   directory = opendir(watcher->dir);
+   if (directory == NULL) {
+      perror("Error reading the watched directory");
+      return FALSE;
+   }
+   while ((entry = readdir(directory)) != NULL)
+      mark_changed(watcher, entry->d_name);
+   closedir(directory);
+   return TRUE;
+}
+
+
+
+
+static int source_changed(struct Watcher* watcher, struct WatchedFile* file) {
+   char asFilename[1024]; /* Source file name with .as extension */
+   char chunk[4096]; /* Block of the source */
+   size_t n; /* Size of the block */
+   struct TextBuffer last; /* The content the source was last assembled with */
+   FILE* source;
+
+   if (strlen(file->filename) + 4 > sizeof(asFilename))
+      return FALSE;
+   sprintf(asFilename, "%s%s", file->filename, ".as");
+   source = fopen(asFilename, "r");
+   if (source == NULL)
+      return FALSE; /* Removed since the event */
+
+   watcher->content.size = 0;
+   while ((n = fread(chunk, 1, sizeof(chunk), source)) > 0)
+      append_text(&watcher->content, chunk, n);
+   fclose(source);
+
+   /* Compare the bytes themselves: a hash collision must never skip a rebuild */
+   if (file->assembled && file->content.size == watcher->content.size &&
+       (file->content.size == 0 || memcmp(file->content.text, watcher->content.text, file->content.size) == 0))
+      return FALSE; /* Saved without a change */
+
+   /* Keep the new content for the next save, and reuse the buffer of the old one for reading */
+   last = file->content;
+   file->content = watcher->content;
+   watcher->content = last;
+   file->assembled = TRUE;
+   return TRUE;
+}
+
+
+
+
+static void assemble_changed(struct Watcher* watcher, int (*assemble)(char* filename)) {
+   int i;
+
+   for (i = 0; i < watcher->file_count; i++) {
+      if (!watcher->files[i].pending)
+         continue;
+      watcher->files[i].pending = FALSE;
+      if (source_changed(watcher, &watcher->files[i])) {
+         assemble(watcher->files[i].filename);
+         fflush(stdout); /* Show the result as soon as it is ready */
+      }
+   }
+}
+
+
+
+
+static void free_watcher(struct Watcher* watcher) {
+   int i;
+
+   for (i = 0; i < watcher->file_count; i++) {
+      free(watcher->files[i].filename);
+      free(watcher->files[i].content.text);
+   }
+   free(watcher->files);
+   free_hash_index(&watcher->index);
+   free(watcher->content.text);
+}
+
+
+
+
+int run_watcher(const char* dir, int (*assemble)(char* filename)) {
+   union {
+      struct inotify_event event; /* For the alignment of the events */
+      char bytes[EVENT_BUFFER_SIZE];
+   } buffer; /* Events read from inotify */
+   const struct inotify_event* event; /* The current event */
+   struct Watcher watcher; /* The sources and their contents */
+   struct pollfd watch; /* The inotify descriptor, for waiting with a timeout */
+   double deadline = 0; /* When the changed sources are assembled, if no other change comes first */
+   int pending = FALSE, changed, timeout, success = TRUE; /* TRUE while changes wait for the quiet time, TRUE if the events changed a source */
+   ssize_t n, offset; /* Bytes of events read, and the position of the current event */
+
+   memset(&watcher, 0, sizeof(watcher));
+   watcher.dir = dir;
+
+   watch.fd = inotify_init();
+   if (watch.fd < 0) {
+      perror("Error starting to watch the directory");
+      return FALSE;
+   }
+   if (inotify_add_watch(watch.fd, dir, WATCH_EVENTS) < 0) {
+      perror("Error watching the directory");
+      close(watch.fd);
+      return FALSE;
+   }
+   watch.events = POLLIN;
+
+   /* Watch first, then assemble everything: a change made meanwhile is not missed */
+   if (!scan_directory(&watcher)) {
+      close(watch.fd);
+      free_watcher(&watcher);
+      return FALSE;
+   }
+   assemble_changed(&watcher, assemble);
+   printf("Watching %s for changes to .as files.\n", dir);
+   fflush(stdout);
+
+   for (;;) {
+      timeout = -1; /* Nothing changed: wait for the next event */
+      if (pending) {
+         timeout = (int)((deadline - stats_clock()) * 1000 + 0.999);
+         if (timeout < 0)
+            timeout = 0;
+      }
+
+      watch.revents = 0;
+      if (poll(&watch, 1, timeout) < 0) {
+         if (errno == EINTR)
+            continue;
+         perror("Error waiting for changes");
+         success = FALSE;
+         break;
+      }
+
+      if (!(watch.revents & POLLIN)) { /* Quiet for WATCH_DEBOUNCE_MS: assemble the changes */
+         assemble_changed(&watcher, assemble);
+         pending = FALSE;
+         continue;
+      }
+
+      n = read(watch.fd, buffer.bytes, sizeof(buffer.bytes));
+      if (n <= 0) {
+         if (n < 0 && errno == EINTR)
+            continue;
+         perror("Error reading the changes");
+         success = FALSE;
+         break;
+      }
+
+      changed = FALSE;
+      for (offset = 0; offset < n; offset += sizeof(struct inotify_event) + event->len) {
+         event = (const struct inotify_event*)(buffer.bytes + offset);
+         if (event->mask & IN_Q_OVERFLOW) /* Events were lost: look at every source */
+            changed |= scan_directory(&watcher);
+         else if (event->len > 0 && mark_changed(&watcher, event->name))
+            changed = TRUE; /* The output files written by the assembler are ignored here */
+         if (event->mask & IN_IGNORED) { /* The directory was removed */
+            printf("Error: the watched directory %s is gone.\n", dir);
+            success = FALSE;
+         }
+      }
+      if (!success)
+         break;
+      if (changed) { /* Wait until the changes stop */
+         pending = TRUE;
+         deadline = stats_clock() + WATCH_DEBOUNCE_MS / 1000.0;
+      }
+   }
+
+   close(watch.fd);
+   free_watcher(&watcher);
+   return success;
+}
@@ -0,0 +1,26 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+#include "auxiliary_functions_constants.h"
+
+#define WATCH_DEBOUNCE_MS 5 /* Quiet time after the last change before assembling (editors save in several writes) */
+
+
+
+/**
+ * @brief Assembles the sources of a directory, then again every source that changes, until the program is stopped.
+ *
+ * All the .as files of the directory are assembled first. The directory is then watched with
+ * inotify: a source that is written (closed after writing, or renamed into the directory, as editors
+ * save) is assembled again once no change was seen for WATCH_DEBOUNCE_MS milliseconds, so a save made
+ * of several writes is assembled once. Only the changed sources are assembled. The watcher keeps a
+ * table of the sources with the content each was last assembled with, so a save that did not change
+ * the bytes of a source (or an event for another file) assembles nothing.
+ *
+ * @param dir The directory to watch.
+ * @param assemble The function that assembles a single file (its name without the .as extension). A source
+ *                 that cannot be read is reported by it, and the watcher goes on.
+ * @return FALSE if the directory cannot be watched or the watch fails (an error message is printed).
+ */
+int run_watcher(const char* dir, int (*assemble)(char* filename));
+
+#endif /* FILE_WATCHER_H */
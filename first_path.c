@@ -6,22 +6,12 @@
 #include "first_path.h"
 
 /**
- * Reads and processes each row of the source file during the first pass.
+ * Reads and processes each row of the expanded source during the first pass.
  * 
- * @param file The name of the source file.
- * @param source The file pointer to the opened source file.
- * @param cmd_code Pointer to the command code array.
- * @param data_code Pointer to the data code array.
- * @param symbols_table Pointer to the symbols table.
- * @param symbols_table_size Pointer to the size of the symbols table.
- * @param macro_table The macro table.
- * @param macro_table_size The size of the macro table.
- * @param cmd_capacity The initial capacity of the command code array.
- * @param data_capacity The initial capacity of the data code array.
+ * @param ctx The context of the file being processed (holds the expanded source).
  * @return TRUE if all rows are valid, FALSE otherwise.
  */
-static int read_row_first(const char *file, FILE *source, int **cmd_code, int **data_code, struct Symbol **symbols_table,
-   int *symbols_table_size, struct Macro *macro_table, int macro_table_size, int cmd_capacity, int data_capacity);
+static int read_row_first(struct AssemblerContext* ctx);
 
 
 
@@ -32,22 +22,14 @@ static int read_row_first(const char *file, FILE *source, int **cmd_code, int **
  * It identifies the type of the row (e.g., command, data, or symbol declaration) and
  * updates the relevant tables and arrays accordingly.
  *
+ * @param ctx The context of the file being processed (symbols table, code arrays and counters).
  * @param row The input row to be analyzed (as a null-terminated string).
  * @param r The current row number in the source file (used for error reporting).
- * @param symbols_table Pointer to the symbol table, which stores symbol definitions.
- * @param symbols_table_size Pointer to the size of the symbol table.
- * @param cmd_code Pointer to the array storing command code instructions.
- * @param data_code Pointer to the array storing data code instructions.
- * @param macro_table Array of macros defined in the source file.
- * @param macro_table_size The number of macros in the macro table.
- * @param cmd_capacity Pointer to the current capacity of the command code array.
- * @param data_capacity Pointer to the current capacity of the data code array.
  *
  * @return An integer indicating the success or failure of the operation:
  *         0 for success, or a non-zero error code for failure or errors in the input file.
  */
-static int row_type_first(char* row, int r, struct Symbol** symbols_table, int* symbols_table_size,
-   int** cmd_code, int** data_code, struct Macro* macro_table, int macro_table_size, int* cmd_capacity, int* data_capacity);
+static int row_type_first(struct AssemblerContext* ctx, char* row, int r);
 
    
 /**
@@ -55,17 +37,17 @@ static int row_type_first(char* row, int r, struct Symbol** symbols_table, int*
  *
  * This function handles the parsing and validation of `.data` and `.string` directives
  * in assembly code. It ensures that the data is correctly formatted, within valid ranges,
- * and properly stored in the `data_code` array. Errors are reported with descriptive messages.
+ * and properly stored in the data code. Errors are reported with descriptive messages.
  *
+ * @param ctx The context of the file being processed (data code array and data counter).
  * @param row The current line of assembly code being processed.
- * @param data_code Pointer to the array where data code is stored.
- * @param data_capacity Pointer to the current capacity of the `data_code` array.
  * @param r The current line number in the source file (used for error reporting).
  * @param i The current index in the `row` string being processed.
  * @param tmp The first word of the line, expected to be a directive like `.data` or `.string`.
+ * @param directive The index of `tmp` as classified by classify_word (DIRECTIVE_DATA or DIRECTIVE_STRING), or NO if it is not a directive.
  * @return int Returns TRUE (1) if the operation is successful, or FALSE (0) if an error occurs or found at the input row.
  */
-static int write_data_code(char* row, int** data_code, int* data_capacity, int r, int i, char* tmp);
+static int write_data_code(struct AssemblerContext* ctx, char* row, int r, int i, char* tmp, int directive);
 
 
 
@@ -77,17 +59,16 @@ static int write_data_code(char* row, int** data_code, int* data_capacity, int r
  * the instruction counter (IC) accordingly. The function also validates the syntax of the command
  * and handles source and target labels if present.
  *
+ * @param ctx           The context of the file being processed (command code array and IC).
  * @param row           The current line of code being processed.
  * @param i             Pointer to the current index in the row being processed.
  * @param c             The index of the command in the command table.
- * @param cmd_code      Pointer to the array holding the generated machine code.
- * @param cmd_capacity  Pointer to the capacity of the cmd_code array.
  * @param r             The current line number in the source file (used for error reporting).
  * 
  * @return int          Returns TRUE (1) if the command was successfully processed and written,
  *                      or FALSE (0) if an error occurred or found in the line.
  */
-static int write_command_code(char* row, int* i, int c, int** cmd_code, int* cmd_capacity, int r);
+static int write_command_code(struct AssemblerContext* ctx, char* row, int* i, int c, int r);
 
 
 
@@ -98,6 +79,7 @@ static int write_command_code(char* row, int* i, int c, int** cmd_code, int* cmd
  * against the command's supported addressing methods and writes the appropriate data into the provided
  * word pointers. It also handles errors such as missing operands, invalid formats, or unsupported addressing methods.
  *
+ * @param ctx The context of the file being processed (used for error reporting).
  * @param operand A pointer to the operand string to be processed.
  * @param c The index of the command in the command array.
  * @param word1 A pointer to the first word to be updated with operand data.
@@ -114,7 +96,86 @@ static int write_command_code(char* row, int* i, int c, int** cmd_code, int* cmd
  * @note The function modifies the `operand` string in-place for certain addressing methods (e.g., immediate and register).
  * @note Error messages are printed to `stdout` for invalid operands or unsupported addressing methods.
  */
-static int write_operand(char* operand, int c, int* word1, int* word2, int* word3, int r, int* operandLabel, int operandNum);
+static int write_operand(struct AssemblerContext* ctx, char* operand, int c, int* word1, int* word2, int* word3, int r, int* operandLabel, int operandNum);
+
+
+
+
+
+/**
+ * @brief Returns the addressing method the second path gives an operand, from its first character.
+ *
+ * @param operand The operand as written in the row (before write_operand changes it).
+ * @return The addressing method. Operands that are not immediate, registers or relative count as direct.
+ */
+static int operand_mode(char* operand);
+
+
+
+/**
+ * @brief Keeps the symbol name of a direct or relative operand in the operand names of the context.
+ *
+ * @param ctx The context of the file being processed (holds the operand names).
+ * @param operand The operand as written in the row (with the `&` of relative addressing).
+ * @return The position of the name in the operand names.
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+static size_t add_operand_name(struct AssemblerContext* ctx, char* operand);
+
+
+
+/**
+ * @brief Returns the name of a symbol, for looking symbols up in the symbols table index.
+ *
+ * @param table The symbols table.
+ * @param id The index of the symbol in the table.
+ * @return The name of the symbol.
+ */
+static const char* symbol_name(const void* table, int id);
+
+
+
+/**
+ * @brief Finds a symbol by its name through the index of the symbols table, counting the lookup.
+ *
+ * @param ctx The context of the file being processed (holds the symbols table and its index).
+ * @param name The name to find.
+ * @return The index of the symbol in the symbols table, or NO if there is no symbol with that name.
+ */
+static int find_symbol(struct AssemblerContext* ctx, const char* name);
+
+
+
+/**
+ * @brief Records a fixup for an operand that the second path would look up in the symbols table (one-pass mode).
+ *
+ * Operands that are empty, immediate (`#`) or registers (`r`) are ignored, like in the second path.
+ *
+ * @param ctx The context of the file being processed (holds the fixups).
+ * @param operand The operand as written in the row (before write_operand changes it).
+ * @param slot The index of the operand word in the command code array, or NO if the operand has no word.
+ * @param r The current line number in the source file (used for error reporting when resolving).
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+static void add_fixup(struct AssemblerContext* ctx, char* operand, int slot, int r);
+
+
+
+/**
+ * @brief Records a decoded command for the second path (two-pass mode).
+ *
+ * @param ctx The context of the file being processed (holds the decoded commands).
+ * @param c The index of the command in the command table.
+ * @param ic The index of the first word of the command in the command code array.
+ * @param source The source operand as written in the row (empty if the command has none).
+ * @param target The destination operand as written in the row (empty if the command has none).
+ * @param r The current line number in the source file (used for error reporting in the second path).
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+static void add_instruction(struct AssemblerContext* ctx, int c, int ic, char* source, char* target, int r);
 
 
 
@@ -134,95 +195,74 @@ static int write_operand(char* operand, int c, int* word1, int* word2, int* word
  * If any of these rules are violated, an appropriate error message is printed
  * to the standard output, indicating the line number and the specific issue.
  *
+ * @param ctx The context of the file being processed (holds the macro table for checking macro conflicts).
  * @param name The symbol name to validate.
  * @param r The line number where the symbol is defined (used for error reporting).
- * @param macro_table A pointer to the macro table for checking macro conflicts.
- * @param macro_table_size The size of the macro table.
  * @return TRUE if the symbol name is valid, FALSE otherwise.
  */
 
-static int check_symbol(char* name, int r, struct Macro* macro_table, int macro_table_size);
+static int check_symbol(struct AssemblerContext* ctx, char* name, int r);
 
 
 
 /**
  * Checks if a given name matches any macro name in the macro table.
  *
- * This function iterates through the macro table and compares the provided
- * name with the names of the macros stored in the table. If a match is found,
- * it returns TRUE; otherwise, it returns FALSE.
+ * This function looks the provided name up in the index of the macro table.
+ * If a match is found, it returns TRUE; otherwise, it returns FALSE.
  *
+ * @param ctx The context of the file being processed (holds the macro table).
  * @param name The name to check against the macro table.
- * @param macro_table A pointer to the array of Macro structures.
- * @param macro_table_size The number of elements in the macro table.
  * @return TRUE if the name matches a macro in the table, FALSE otherwise.
  */
-static int is_macro(char* name, struct Macro* macro_table, int macro_table_size);
-
-
-
-
-/*
- * DC - Data Counter: This variable is used to keep track of the current address
- *      in the data section of the program. It is incremented as new data is added.
- *
- * IC - Instruction Counter: This variable is used to keep track of the current address
- *      in the instruction section of the program. It is incremented as new instructions are added.
- */
-int DC, IC;
+static int is_macro(struct AssemblerContext* ctx, char* name);
 
 
-static int is_macro(char* name, struct Macro* macro_table, int macro_table_size) {
-   int i;
-   for (i = 0; i < macro_table_size; i++) {
-      if (macro_table[i].name != NULL && strcmp(macro_table[i].name, name) == 0) {
-         return TRUE;/*Found macro name*/
-      }
-   }
-   return FALSE;/*Not found macro name*/
+static int is_macro(struct AssemblerContext* ctx, char* name) {
+   return find_macro(ctx, name, strlen(name)) != NO; /* Found macro name, or not */
 }
 
 
 
 
 
-static int check_symbol(char* name, int r, struct Macro* macro_table, int macro_table_size) {
+static int check_symbol(struct AssemblerContext* ctx, char* name, int r) {
    int i; /* Loop index for iterating through the symbol name */
 
    /* Check if the symbol name exceeds the maximum allowed length */
    if (strlen(name) > MAX_SYMBOL_NAME) {
-      printf("Error - line %d: the symbol (%s) is too long.\n", r, name);
+      report_message(ctx, "Error - line %d: the symbol (%s) is too long.\n", r, name);
       return FALSE;
    }
 
    /* Check if the symbol name is empty */
    if (name[0] == '\0') {
-      printf("Error - line %d: missing a label name.\n", r);
+      report_message(ctx, "Error - line %d: missing a label name.\n", r);
       return FALSE;
    }
 
    /* Check if the symbol name is a reserved word */
    if (reserved_word(name)) {
-      printf("Error - line %d: the symbol (%s) is a reserved word.\n", r, name);
+      report_message(ctx, "Error - line %d: the symbol (%s) is a reserved word.\n", r, name);
       return FALSE;
    }
 
    /* Check if the symbol name conflicts with an existing macro */
-   if (is_macro(name, macro_table, macro_table_size)) {
-      printf("Error - line %d: the symbol (%s) is a macro.\n", r, name);
+   if (is_macro(ctx, name)) {
+      report_message(ctx, "Error - line %d: the symbol (%s) is a macro.\n", r, name);
       return FALSE;
    }
 
    /* Ensure the symbol name starts with a letter */
    if (!isalpha(name[0])) {
-      printf("Error - line %d: the symbol (%s) must start with a letter.\n", r, name);
+      report_message(ctx, "Error - line %d: the symbol (%s) must start with a letter.\n", r, name);
       return FALSE;
    }
 
    /* Validate that the symbol name contains only alphanumeric characters */
    for (i = 1; i < strlen(name); i++) {
       if (!isalnum(name[i])) {
-         printf("Error - line %d: the symbol (%s) must contain only letters and numbers.\n", r, name);
+         report_message(ctx, "Error - line %d: the symbol (%s) must contain only letters and numbers.\n", r, name);
          return FALSE;
       }
    }
@@ -234,98 +274,92 @@ static int check_symbol(char* name, int r, struct Macro* macro_table, int macro_
 
 
 
-int symbols_table_management(char* name, char* type, struct Symbol** symbols_table, int* symbols_table_size,
-   int action, int address, int r, struct Macro* macro_table, int macro_table_size, int index) {
-   int i; /* Loop index */
-   int* new_address; /* Pointer for reallocating external addresses */
-   char tmp[MAX] = { 0 }; /* Temporary buffer for address formatting */
+static const char* symbol_name(const void* table, int id) {
+   return ((const struct Symbol*)table)[id].name;
+}
+
+
+
+
+static int find_symbol(struct AssemblerContext* ctx, const char* name) {
+   ctx->stats.symbol_lookups++;
+   return hash_index_find(&ctx->symbol_index, name, strlen(name), symbol_name, ctx->symbols_table);
+}
+
+
 
-   new_address = NULL;
+int symbols_table_management(struct AssemblerContext* ctx, char* name, int kind, int action, int address, int r, int index) {
+   int i; /* Index of the symbol */
+   int old_capacity; /* Capacity of the external uses before growing */
 
    /* Handle adding a new symbol name */
    if (action == ADD_NAME) {
-      if(!check_symbol(name, r, macro_table, macro_table_size)) /* Validate symbol name */
+      if(!check_symbol(ctx, name, r)) /* Validate symbol name */
          return FALSE;
-      for (i = 0; i < *symbols_table_size; i++) {
-         if (strcmp((*symbols_table)[i].name, name) == 0) { /* Check if symbol already exists */
-            /* Check for conflicting entry and external definitions */
-            if((strcmp(type, "external") == 0 && strstr((*symbols_table)[i].type, "entry") != NULL) ||
-               (strcmp(type, "entry") == 0 && strstr((*symbols_table)[i].type, "external") != NULL)) {
-               printf("Error - line %d: the symbol (%s) has been defined both as entry and external.\n", r, name);
-               return FALSE;
-            }
-            if ((*symbols_table)[i].address != NO){ /* Symbol already defined */
-               printf("Error - line %d: the symbol (%s) is already defined.\n", r, name);
-               return FALSE;
-            }
-            if ((*symbols_table)[i].address == NO) { /* Update address if undefined */
-               (*symbols_table)[i].address = address;
-               return symbols_table_management(name, type, symbols_table, symbols_table_size, ADD_TYPE, NO, r, macro_table, macro_table_size, NO);
-            }
+      if ((i = find_symbol(ctx, name)) != NO) { /* Check if symbol already exists */
+         /* Check for conflicting entry and external definitions */
+         if((kind == SYMBOL_EXTERNAL && (ctx->symbols_table[i].kind & SYMBOL_ENTRY)) ||
+            (kind == SYMBOL_ENTRY && (ctx->symbols_table[i].kind & SYMBOL_EXTERNAL))) {
+            report_message(ctx, "Error - line %d: the symbol (%s) has been defined both as entry and external.\n", r, name);
+            return FALSE;
          }
-         if ((*symbols_table)[i].name[0] == 0) { /* Empty slot in symbols table */
-            strcat((*symbols_table)[i].name, name); /* Add name */
-            (*symbols_table)[i].address = address; /* Set address */
-            strcat((*symbols_table)[i].type, type); /* Set type */
-            return TRUE;
+         if (ctx->symbols_table[i].address != NO){ /* Symbol already defined */
+            report_message(ctx, "Error - line %d: the symbol (%s) is already defined.\n", r, name);
+            return FALSE;
          }
+         /* Update address if undefined */
+         ctx->symbols_table[i].address = address;
+         return symbols_table_management(ctx, name, kind, ADD_TYPE, NO, r, NO);
       }
 
-      /* Expand symbols table if no empty slot found */
-      i = *symbols_table_size - 1;
-      if (!expand_symbols_table(symbols_table, symbols_table_size))
+      /* Expand symbols table if there is no empty entry after the last symbol */
+      if (ctx->symbol_count == ctx->symbols_table_size && !expand_symbols_table(ctx))
          return FALSE;
 
-      /* Use the last index in the expanded table */
-      strcpy((*symbols_table)[i].name, name);
-      (*symbols_table)[i].address = address;
-      strcpy((*symbols_table)[i].type, type);
+      /* Add the symbol after the last one, and index it */
+      i = ctx->symbol_count++;
+      ctx->symbols_table[i].name = arena_strdup(&ctx->arena, name);
+      ctx->symbols_table[i].address = address;
+      ctx->symbols_table[i].kind = kind;
+      hash_index_insert(&ctx->symbol_index, name, strlen(name), i);
       return TRUE;
    }
 
    /* Handle adding a type to an existing symbol */
    if (action == ADD_TYPE) {
-      for (i = 0; i < *symbols_table_size; i++) {
-         if ((*symbols_table)[i].name != NULL && strcmp((*symbols_table)[i].name, name) == 0) {
-            /* Check for conflicting entry and external definitions */
-            if(strcmp(type, "entry") == 0 && strstr((*symbols_table)[i].type, "external") != NULL) {
-               printf("Error - line %d: the symbol (%s) has been defined both as entry and external.\n", r, name);
-               return FALSE;
-            }
-            strcat((*symbols_table)[i].type, type); /* Append type */
-            return TRUE;
+      if ((i = find_symbol(ctx, name)) != NO) {
+         /* Check for conflicting entry and external definitions */
+         if(kind == SYMBOL_ENTRY && (ctx->symbols_table[i].kind & SYMBOL_EXTERNAL)) {
+            report_message(ctx, "Error - line %d: the symbol (%s) has been defined both as entry and external.\n", r, name);
+            return FALSE;
          }
+         ctx->symbols_table[i].kind |= kind; /* Add the kind */
+         return TRUE;
       }
       /* If symbol not found, add it as a new symbol */
-      return symbols_table_management(name, type, symbols_table, symbols_table_size, ADD_NAME, NO, r, macro_table, macro_table_size, NO);
+      return symbols_table_management(ctx, name, kind, ADD_NAME, NO, r, NO);
    }
 
    /* Handle finding a symbol by name */
    else if (action == FIND_NAME) {
-      for (i = 0; i < *symbols_table_size; i++) {
-         if ((*symbols_table)[i].name != NULL && strcmp((*symbols_table)[i].name, name) == 0) {
-            return i; /* Return index of the symbol */
-         }
-      }
-      return NO; /* Symbol not found */
+      return find_symbol(ctx, name); /* Index of the symbol, or NO */
    }
 
    /* Handle retrieving the address of a symbol by index */
    else if (action == GET_ADDRESS) {
-      return (*symbols_table)[index].address; /* Return address */
+      return ctx->symbols_table[index].address; /* Return address */
    }
 
-   /* Handle adding an external address to a symbol */
+   /* Handle recording a use of an external symbol */
    else if (action == ADD_EXTERNAL_ADDRESS) {
-      sprintf(tmp, "%07d, ", address); /* Format address as a string */
-      new_address = realloc((*symbols_table)[index].extern_address, ((*symbols_table)[index].extern_address_size + 1) * sizeof(int));
-      if (new_address == NULL) { /* Check for memory allocation failure */
-         perror("Error allocating memory for new address string");
-         exit(EXIT_FAILURE);
+      if (ctx->external_use_count == ctx->external_use_capacity) { /* The list is full, double it */
+         old_capacity = ctx->external_use_capacity;
+         ctx->external_use_capacity = old_capacity == 0 ? INITIAL_EXTERNAL_USE_LIST_SIZE : old_capacity * 2;
+         ctx->external_uses = (struct ExternalUse*)arena_grow(&ctx->arena, ctx->external_uses,
+            old_capacity * sizeof(struct ExternalUse), ctx->external_use_capacity * sizeof(struct ExternalUse));
       }
-      (*symbols_table)[index].extern_address = new_address; /* Update pointer */
-      (*symbols_table)[index].extern_address[(*symbols_table)[index].extern_address_size] = address; /* Add address */
-      (*symbols_table)[index].extern_address_size++; /* Increment size */
+      ctx->external_uses[ctx->external_use_count].symbol = index; /* Add the use */
+      ctx->external_uses[ctx->external_use_count++].address = address;
       return TRUE;
    }
 
@@ -334,7 +368,7 @@ int symbols_table_management(char* name, char* type, struct Symbol** symbols_tab
 
 
 
-static int write_operand(char* operand, int c, int* word1, int* word2, int* word3, int r, int* operandLabel, int operandNum) {
+static int write_operand(struct AssemblerContext* ctx, char* operand, int c, int* word1, int* word2, int* word3, int r, int* operandLabel, int operandNum) {
    int bits, num; /* Variables for bit manipulation and numeric conversion */
    char* endptr = NULL; /* Pointer for strtol to detect invalid characters */
    char operandNumString[MAX] = { 0 }; /* Buffer for operand number string */
@@ -351,7 +385,7 @@ static int write_operand(char* operand, int c, int* word1, int* word2, int* word
        
        /* Validate that the operand is not empty */
        if(operand[0] == '\0'){
-         printf("Error - line %d: missing operand.\n", r);
+         report_message(ctx, "Error - line %d: missing operand.\n", r);
             return FALSE;
        }
 
@@ -361,7 +395,7 @@ static int write_operand(char* operand, int c, int* word1, int* word2, int* word
          /* Validate that the command supports immediate addressing for the operand */
          if ((operandNum == 1 && strpbrk(cmd[c].source, "0") == NULL) ||
             (operandNum == 2 && strpbrk(cmd[c].dest, "0") == NULL) ) {
-            printf("Error - line %d: the command does not support immediate addressing for %s operand.\n", r, operandNumString);
+            report_message(ctx, "Error - line %d: the command does not support immediate addressing for %s operand.\n", r, operandNumString);
             return FALSE;
          }
  
@@ -373,19 +407,19 @@ static int write_operand(char* operand, int c, int* word1, int* word2, int* word
 
          /* Check if the operand is not a valid integer */
          if (*endptr != '\0'){
-            printf("Error - line %d: operand in the immediate addressing method (%s) is not an integer.\n", r, operand);
+            report_message(ctx, "Error - line %d: operand in the immediate addressing method (%s) is not an integer.\n", r, operand);
             return FALSE;
          }
 
          /* Validate the range of the immediate value */
          if(num < -(1 << 20) || num > (1 << 20) - 1){
-            printf("Error - line %d: the immediate addressing method (%s) is not a valid number (out of range).\n", r, operand);
+            report_message(ctx, "Error - line %d: the immediate addressing method (%s) is not a valid number (out of range).\n", r, operand);
             return FALSE;
          }
 
          /* Check for missing number after '#' */
          if(num == 0 && strcmp(operand, "0") != 0){
-            printf("Error - line %d: missing number after '#' for immediate addressing.\n", r);
+            report_message(ctx, "Error - line %d: missing number after '#' for immediate addressing.\n", r);
             return FALSE;
          }
  
@@ -399,7 +433,7 @@ static int write_operand(char* operand, int c, int* word1, int* word2, int* word
           /* Validate that the command supports direct addressing for the operand */
           if((operandNum == 1 && strpbrk(cmd[c].source, "1") == NULL) ||
           (operandNum == 2 && strpbrk(cmd[c].dest, "1") == NULL)){
-             printf("Error - line %d: the command does not support direct addressing  for %s operand.\n", r, operandNumString);
+             report_message(ctx, "Error - line %d: the command does not support direct addressing  for %s operand.\n", r, operandNumString);
              return FALSE;
           }
 
@@ -420,7 +454,7 @@ static int write_operand(char* operand, int c, int* word1, int* word2, int* word
           /* Validate that the command supports relative addressing for the operand */
           if((operandNum == 1 && strpbrk(cmd[c].source, "2") == NULL) ||
           (operandNum == 2 && strpbrk(cmd[c].dest, "2") == NULL)){
-             printf("Error - line %d: this command does not support relative addressing  for %s operand.\n", r, operandNumString);
+             report_message(ctx, "Error - line %d: this command does not support relative addressing  for %s operand.\n", r, operandNumString);
              return FALSE;
           }
 
@@ -441,7 +475,7 @@ static int write_operand(char* operand, int c, int* word1, int* word2, int* word
           /* Validate that the command supports register addressing for the operand */
           if((operandNum == 1 && strpbrk(cmd[c].source, "3") == NULL) ||
           (operandNum == 2 && strpbrk(cmd[c].dest, "3") == NULL)){
-             printf("Error - line %d: the command does not support register addressing for %s operand.\n", r, operandNumString);
+             report_message(ctx, "Error - line %d: the command does not support register addressing for %s operand.\n", r, operandNumString);
              return FALSE;
           }
 
@@ -458,7 +492,7 @@ static int write_operand(char* operand, int c, int* word1, int* word2, int* word
 
           /* Validate the register number */
           if ((!(isdigit(operand[0]))) || operand[0] < '1' || operand[0] > '7') {
-             printf("Error - line %d: the register number (%c) is not valid.\n", r, operand[0]);
+             report_message(ctx, "Error - line %d: the register number (%c) is not valid.\n", r, operand[0]);
              return FALSE;
           }
 
@@ -477,10 +511,78 @@ static int write_operand(char* operand, int c, int* word1, int* word2, int* word
     
 
 
-static int write_command_code(char* row, int* i, int c, int** cmd_code, int* cmd_capacity, int r) {
+static int operand_mode(char* operand) {
+   if (operand[0] == '#')
+      return IMMEDIATE_ADDRESSING;
+   if (operand[0] == 'r')
+      return REGISTER_ADDRESSING;
+   if (operand[0] == '&')
+      return RELATIVE_ADDRESSING;
+   return DIRECT_ADDRESSING;
+}
+
+
+
+static size_t add_operand_name(struct AssemblerContext* ctx, char* operand) {
+   size_t name; /* Position of the name in the operand names */
+
+   if (operand[0] == '&') /* Keep the name without the relative addressing mark */
+      operand++;
+   name = ctx->operand_names.size;
+   append_text(&ctx->operand_names, operand, strlen(operand) + 1); /* Keep the null terminator */
+   return name;
+}
+
+
+
+static void add_fixup(struct AssemblerContext* ctx, char* operand, int slot, int r) {
+   if (operand[0] == '\0' || operand[0] == '#' || operand[0] == 'r') /* Not a symbol */
+      return;
+
+   if (ctx->fixup_count == ctx->fixup_capacity) { /* The list is full, double it */
+      ctx->fixup_capacity = ctx->fixup_capacity == 0 ? INITIAL_FIXUP_LIST_SIZE : ctx->fixup_capacity * 2;
+      ctx->fixups = (struct Fixup*)arena_grow(&ctx->arena, ctx->fixups, ctx->fixup_count * sizeof(struct Fixup), ctx->fixup_capacity * sizeof(struct Fixup));
+   }
+
+   ctx->fixups[ctx->fixup_count].slot = slot;
+   ctx->fixups[ctx->fixup_count].line = r;
+   ctx->fixups[ctx->fixup_count].relative = operand[0] == '&';
+   ctx->fixups[ctx->fixup_count++].name = add_operand_name(ctx, operand);
+}
+
+
+
+static void add_instruction(struct AssemblerContext* ctx, int c, int ic, char* source, char* target, int r) {
+   struct Instruction* instruction; /* The new record */
+   char* operands[2]; /* The source and destination operands */
+   int k; /* Operand index */
+
+   if (ctx->instruction_count == ctx->instruction_capacity) { /* The list is full, double it */
+      ctx->instruction_capacity = ctx->instruction_capacity == 0 ? INITIAL_INSTRUCTION_LIST_SIZE : ctx->instruction_capacity * 2;
+      ctx->instructions = (struct Instruction*)arena_grow(&ctx->arena, ctx->instructions, ctx->instruction_count * sizeof(struct Instruction), ctx->instruction_capacity * sizeof(struct Instruction));
+   }
+
+   instruction = &ctx->instructions[ctx->instruction_count++];
+   instruction->command = (unsigned char)c;
+   instruction->ic = ic;
+   instruction->line = r;
+
+   operands[0] = source, operands[1] = target;
+   for (k = 0; k < 2; k++) {
+      instruction->modes[k] = operands[k][0] == '\0' ? NO : (signed char)operand_mode(operands[k]);
+      instruction->operands[k] = 0;
+      if (instruction->modes[k] == DIRECT_ADDRESSING || instruction->modes[k] == RELATIVE_ADDRESSING)
+         instruction->operands[k] = add_operand_name(ctx, operands[k]);
+   }
+}
+
+
+
+static int write_command_code(struct AssemblerContext* ctx, char* row, int* i, int c, int r) {
    int word1 = 0, word2 = 0, word3 = 0; /* Machine code words for the command */
    int sourceLabel, targetLabel; /* Flags to indicate if source/target operands are labels */
    char operand[MAX] = { 0 }; /* Buffer to store the current operand */
+   char sourceOperand[MAX] = { 0 }, targetOperand[MAX] = { 0 }; /* The operands as written, for the second path or the fixups */
    int comaValidation; /* Flag to validate comma placement between operands */
 
    sourceLabel = FALSE;
@@ -496,10 +598,11 @@ static int write_command_code(char* row, int* i, int c, int** cmd_code, int* cmd
       comaValidation = (cmd[c].source == NULL || cmd[c].dest == NULL) ? 0 : 1;
       
       /* Extract and validate the source operand */
-      if (!(copy_word_jump_space_count_coma(row, operand, i, 0, comaValidation, r))) {
+      if (!(copy_word_jump_space_count_coma(ctx, row, operand, i, 0, comaValidation, r))) {
          return FALSE; 
       }
-      if (!(write_operand(operand, c, &word1, &word2, NULL, r, &sourceLabel, 1))) {
+      strcpy(sourceOperand, operand);
+      if (!(write_operand(ctx, operand, c, &word1, &word2, NULL, r, &sourceLabel, 1))) {
          return FALSE;
       }
    }   
@@ -507,43 +610,52 @@ static int write_command_code(char* row, int* i, int c, int** cmd_code, int* cmd
    /* Process the destination operand if it exists */
    if (cmd[c].dest != NULL) {   
       /* Extract and validate the destination operand */
-      if (!copy_word_jump_space_count_coma(row, operand, i, 0, 0, r)) {
+      if (!copy_word_jump_space_count_coma(ctx, row, operand, i, 0, 0, r)) {
          return FALSE;
       }
-      if (!write_operand(operand, c, &word1, &word2, &word3, r, &targetLabel, 2)) {
+      strcpy(targetOperand, operand);
+      if (!write_operand(ctx, operand, c, &word1, &word2, &word3, r, &targetLabel, 2)) {
          return FALSE;
       }
    }
 
    /* Ensure there are no extra words after the command */
-   if (!check_extra_word(row, *i, r, "finishing a command")) {
+   if (!check_extra_word(ctx, row, *i, r, "finishing a command")) {
       return FALSE;
    }
 
+   /* Record the command for the second path */
+   if (!ctx->one_pass)
+      add_instruction(ctx, c, ctx->IC, sourceOperand, targetOperand, r);
+
    /* Store the first word in the command code array */
-   ensure_capacity(cmd_code, cmd_capacity, IC);
-   (*cmd_code)[IC++] = word1;
+   word_store_set(&ctx->arena, &ctx->cmd_code, ctx->IC++, word1);
+
+   /* In one-pass mode, remember the operands to fill once all the symbols are known */
+   if (ctx->one_pass)
+      add_fixup(ctx, sourceOperand, sourceLabel ? ctx->IC : NO, r);
 
    /* Increment IC for source label if present */
    if (sourceLabel == TRUE) {
-      IC++;
+      ctx->IC++;
    }
 
    /* Store the second word if it exists */
    if (word2 != 0) {
-      ensure_capacity(cmd_code, cmd_capacity, IC);
-      (*cmd_code)[IC++] = word2;
+      word_store_set(&ctx->arena, &ctx->cmd_code, ctx->IC++, word2);
    }
 
+   if (ctx->one_pass)
+      add_fixup(ctx, targetOperand, targetLabel ? ctx->IC : NO, r);
+
    /* Increment IC for target label if present */
    if (targetLabel == TRUE) {
-      IC++;
+      ctx->IC++;
    }
 
    /* Store the third word if it exists */
    if (word3 != 0) {
-      ensure_capacity(cmd_code, cmd_capacity, IC);
-      (*cmd_code)[IC++] = word3;
+      word_store_set(&ctx->arena, &ctx->cmd_code, ctx->IC++, word3);
    }
    
    return TRUE; /* Successfully processed the command */
@@ -552,17 +664,17 @@ static int write_command_code(char* row, int* i, int c, int** cmd_code, int* cmd
 
 
 
-static int write_data_code(char* row, int** data_code, int* data_capacity, int r, int i, char* tmp) {
+static int write_data_code(struct AssemblerContext* ctx, char* row, int r, int i, char* tmp, int directive) {
    char word1[MAX] = { 0 }; /* Buffer to store the current word being processed */
    int num; /* Variable to store the parsed integer */
    char* endptr; /* Pointer for strtol to detect invalid characters */
 
    /* Handle `.data` directive */
-   if ((strcmp(tmp, ".data")) == 0) {
+   if (directive == DIRECTIVE_DATA) {
 
       do {
          /* Extract the next word and validate comma placement */
-         if (!(copy_word_jump_space_count_coma(row, word1, &i, 0, 1, r)))
+         if (!(copy_word_jump_space_count_coma(ctx, row, word1, &i, 0, 1, r)))
             return FALSE;
 
          /* Convert the word to an integer */
@@ -570,33 +682,32 @@ static int write_data_code(char* row, int** data_code, int* data_capacity, int r
 
          /* Check if the number is within the valid range */
          if (num > (1 << 23) - 1 || num < -(1 << 23)) {
-            printf("Error - line %d: invalid number (%d) in .data declaration (out of range).\n", r, num);
+            report_message(ctx, "Error - line %d: invalid number (%d) in .data declaration (out of range).\n", r, num);
             return FALSE;
          }
 
          /* Check if the word contains invalid characters */
          if (*endptr != '\0') {
-            printf("Error - line %d: one or more of the parameters (%s) is not an integer.\n", r, word1);
+            report_message(ctx, "Error - line %d: one or more of the parameters (%s) is not an integer.\n", r, word1);
             return FALSE;
          }
 
          /* Check if the word is empty */
          if (word1[0] == '\0') {
-            printf("Error - line %d: no numbers in .data declaration line.\n", r);
+            report_message(ctx, "Error - line %d: no numbers in .data declaration line.\n", r);
             return FALSE;
          }
 
-         /* Ensure there is enough capacity in the data array and store the number */
-         ensure_capacity(data_code, data_capacity, DC);
-         (*data_code)[DC] = num;
-         DC++; /* Increment the data counter */
+         /* Store the number in the data code */
+         word_store_set(&ctx->arena, &ctx->data_code, ctx->DC, num);
+         ctx->DC++; /* Increment the data counter */
       } while (row[i] != '\n' && row[i] != EOF); /* Continue until the end of the line */
 
       return TRUE; /* Successfully processed `.data` directive */
    }
 
    /* Handle `.string` directive */
-   if (strcmp(tmp, ".string") == 0) {
+   if (directive == DIRECTIVE_STRING) {
 
       /* Skip whitespace characters */
       while (isspace(row[i])) {
@@ -605,44 +716,42 @@ static int write_data_code(char* row, int** data_code, int* data_capacity, int r
 
       /* Check for the opening quotation mark */
       if (row[i] == EOF || row[i] != '"') {
-         printf("Error - line %d: missing a quotation mark.\n", r);
+         report_message(ctx, "Error - line %d: missing a quotation mark.\n", r);
          return FALSE;
       }
       i++; /* Move past the opening quotation mark */
 
       /* Process characters inside the string */
       while (row[i] != '\n' && row[i] != EOF && i <= MAX && row[i] != '"') {
-         ensure_capacity(data_code, data_capacity, DC); /* Ensure capacity for the data array */
-         (*data_code)[DC] = (int)row[i]; /* Store the ASCII value of the character */
-         DC++; /* Increment the data counter */
+         word_store_set(&ctx->arena, &ctx->data_code, ctx->DC, (int)row[i]); /* Store the ASCII value of the character */
+         ctx->DC++; /* Increment the data counter */
          i++;
       }
 
       /* Check for the closing quotation mark */
       if (row[i] == '"') {
-         check_extra_word(row, i + 1, r, "finishing a string line"); /* Validate no extra text after the string */
-         ensure_capacity(data_code, data_capacity, DC); /* Ensure capacity for the null terminator */
-         (*data_code)[DC] = 0; /* Add null terminator to the string */
-         DC++; /* Increment the data counter */
+         check_extra_word(ctx, row, i + 1, r, "finishing a string line"); /* Validate no extra text after the string */
+         word_store_set(&ctx->arena, &ctx->data_code, ctx->DC, 0); /* Add null terminator to the string */
+         ctx->DC++; /* Increment the data counter */
          return TRUE; /* Successfully processed `.string` directive */
       }
 
       /* Missing closing quotation mark */
-      printf("Error - line %d: missing a quotation mark.\n", r);
+      report_message(ctx, "Error - line %d: missing a quotation mark.\n", r);
       return FALSE;
    }
 
    /* Invalid directive or unrecognized word */
-   printf("Error - line %d: the first word (%s) is not valid: must be valid command, data declaration, label definition, or symbol directives.\n", r, tmp);
+   report_message(ctx, "Error - line %d: the first word (%s) is not valid: must be valid command, data declaration, label definition, or symbol directives.\n", r, tmp);
    return FALSE;
 }
 
 
 
-static int row_type_first(char* row, int r, struct Symbol** symbols_table, int* symbols_table_size,
-   int** cmd_code, int** data_code, struct Macro* macro_table, int macro_table_size, int* cmd_capacity, int* data_capacity) {
+static int row_type_first(struct AssemblerContext* ctx, char* row, int r) {
    char word1[MAX], tmp[MAX]; /* Buffers for processing words in the line */
-   int i, c, isLabel; /* Indices and flags for processing */
+   int i, isLabel; /* Indices and flags for processing */
+   int kind, index = NO; /* The class of a word (classify_word) and its index among the commands or the directives */
 
    i = 0, isLabel = FALSE; /* Initialize index and label flag */
 
@@ -652,26 +761,30 @@ static int row_type_first(char* row, int r, struct Symbol** symbols_table, int*
    }
 
    /* Extract the first word from the line and check if there is extra/missing comma serounde it*/
-   if (!copy_word_jump_space_count_coma(row, word1, &i, 0, 0, r))
+   if (!copy_word_jump_space_count_coma(ctx, row, word1, &i, 0, 0, r))
       return FALSE;
 
+   /* One lookup tells the directives and the commands apart */
+   kind = classify_word(word1, &index);
+
    /* Handle `.entry` directive */
-   if (strcmp(word1, ".entry") == 0) {
+   if (kind == WORD_DIRECTIVE && index == DIRECTIVE_ENTRY) {
       i = copy_word_jump_space(row, word1, i); /* Get the next word */
-      isLabel = symbols_table_management(word1, "entry", symbols_table, symbols_table_size, ADD_TYPE, 0, r, macro_table, macro_table_size, 0);
+      isLabel = symbols_table_management(ctx, word1, SYMBOL_ENTRY, ADD_TYPE, 0, r, 0);
+      ctx->isEntry = TRUE; /* Mark that an entry symbol exists (the second path marks it again) */
       if (isLabel) {
-         return check_extra_word(row, i, r, "finishing an entry line");
+         return check_extra_word(ctx, row, i, r, "finishing an entry line");
       } else {
          return FALSE;
       }
    }
 
    /* Handle `.extern` directive */
-   if (strcmp(word1, ".extern") == 0) {
+   if (kind == WORD_DIRECTIVE && index == DIRECTIVE_EXTERN) {
       i = copy_word_jump_space(row, word1, i); /* Get the next word */
-      isLabel = symbols_table_management(word1, "external", symbols_table, symbols_table_size, ADD_NAME, NO, r, macro_table, macro_table_size, 0);/*Add external symbol*/
+      isLabel = symbols_table_management(ctx, word1, SYMBOL_EXTERNAL, ADD_NAME, NO, r, 0);/*Add external symbol*/
       if (isLabel) {
-         return check_extra_word(row, i, r, "finishing an extern line");/*Check if there is extra text at the end of the line*/
+         return check_extra_word(ctx, row, i, r, "finishing an extern line");/*Check if there is extra text at the end of the line*/
       } else {
          return FALSE;
       }
@@ -679,136 +792,110 @@ static int row_type_first(char* row, int r, struct Symbol** symbols_table, int*
 
    /* Handle data directives (`.string`, `.data`) */
    if (word1[0] == '.') {
-      return write_data_code(row, data_code, data_capacity, r, i, word1);
+      return write_data_code(ctx, row, r, i, word1, kind == WORD_DIRECTIVE ? index : NO);
    }
 
    /* Handle commands */
-   if ((c = cmd_table(word1)) != -1) {
-      return write_command_code(row, &i, c, cmd_code, cmd_capacity, r);
+   if (kind == WORD_COMMAND) {
+      return write_command_code(ctx, row, &i, index, r);
    }
 
    /* Handle labels followed by directives or commands */
    if (row[i] == ':' && row[i + 1] == ' ') {
       i = copy_word_jump_space(row, tmp, i + 1); /* Get the next word */
+      kind = classify_word(tmp, &index);
       
       /*Found data label:*/
-      if (strcmp(tmp, ".string") == 0 || strcmp(tmp, ".data") == 0) {
+      if (kind == WORD_DIRECTIVE && (index == DIRECTIVE_STRING || index == DIRECTIVE_DATA)) {
          /* Add label to symbol table and process data directive */
-         return symbols_table_management(word1, "data", symbols_table, symbols_table_size, ADD_NAME, DC, r, macro_table, macro_table_size, 0) &&
-                write_data_code(row, data_code, data_capacity, r, i, tmp);
+         return symbols_table_management(ctx, word1, SYMBOL_DATA, ADD_NAME, ctx->DC, r, 0) &&
+                write_data_code(ctx, row, r, i, tmp, index);
       } 
       
       /*Entry directive line:*/
-      else if (strcmp(tmp, ".entry") == 0) {
+      else if (kind == WORD_DIRECTIVE && index == DIRECTIVE_ENTRY) {
          /* Warn about meaningless label before `.entry` */
-         printf(" Attention - line %d: label defined at the beginning of an .entry line, is meaningless, and the assembler ignores it.\n", r);
+         report_message(ctx, " Attention - line %d: label defined at the beginning of an .entry line, is meaningless, and the assembler ignores it.\n", r);
          /* Add entry label to symbol table */
-         return symbols_table_management(word1, "entry", symbols_table, symbols_table_size, ADD_TYPE, NO, r, macro_table, macro_table_size, NO);
+         return symbols_table_management(ctx, word1, SYMBOL_ENTRY, ADD_TYPE, NO, r, NO);
       } 
       
       /*Extern directive line:*/
-      else if (strcmp(tmp, ".extern") == 0) {
+      else if (kind == WORD_DIRECTIVE && index == DIRECTIVE_EXTERN) {
          /* Warn about meaningless label before `.extern` */
-         printf(" Attention - line %d: label defined at the beginning of an .extern line, is meaningless, and the assembler ignores it.\n", r);
-         return symbols_table_management(word1, "external", symbols_table, symbols_table_size, ADD_NAME, NO, r, macro_table, macro_table_size, NO);
+         report_message(ctx, " Attention - line %d: label defined at the beginning of an .extern line, is meaningless, and the assembler ignores it.\n", r);
+         return symbols_table_management(ctx, word1, SYMBOL_EXTERNAL, ADD_NAME, NO, r, NO);
       } 
       
       /*Found code label:*/
-      else if ((c = cmd_table(tmp)) != NO) {
+      else if (kind == WORD_COMMAND) {
          /* Add code label to symbol table and process command */
-         return symbols_table_management(word1, "code", symbols_table, symbols_table_size, ADD_NAME, IC, r, macro_table, macro_table_size, NO) &&
-                write_command_code(row, &i, c, cmd_code, cmd_capacity, r);
+         return symbols_table_management(ctx, word1, SYMBOL_CODE, ADD_NAME, ctx->IC, r, NO) &&
+                write_command_code(ctx, row, &i, index, r);
       } 
       
       else {
          /* Invalid word after label */
-         printf("Error - line %d: after the label must be a valid command or data declaration.\n", r);
+         report_message(ctx, "Error - line %d: after the label must be a valid command or data declaration.\n", r);
          return FALSE;
       }
    }
 
    /* Invalid first word in the line */
-   printf("Error - line %d: the first word (%s) is not valid: must be valid command, data declaration, label definition, or symbol directives.\n", r, word1);
+   report_message(ctx, "Error - line %d: the first word (%s) is not valid: must be valid command, data declaration, label definition, or symbol directives.\n", r, word1);
    return FALSE;
 }
 
 
 
-static int read_row_first(const char *file, FILE *source, int **cmd_code, int **data_code, struct Symbol **symbols_table,
-                    int *symbols_table_size, struct Macro *macro_table, int macro_table_size, int cmd_capacity, int data_capacity)
+static int read_row_first(struct AssemblerContext* ctx)
 {
    char row[MAX]; /* Buffer to store the current row being read */
-   int r, InputValidation;
-
-   r = 1; /* Line counter starts at 1 */
-   InputValidation = TRUE; /* Assume input is valid initially */
+   int r;
 
-   while (fgets(row, MAX, source)) /* Read each line from the source file */
+   for (r = 1; r <= ctx->line_count; r++) /* Read each line of the expanded source, line counter starts at 1 */
    {
-      if (row_type_first(row, r, symbols_table, symbols_table_size, cmd_code, data_code,
-                     macro_table, macro_table_size, &cmd_capacity, &data_capacity) == FALSE)
+      copy_line(ctx, r - 1, row);
+      if (row_type_first(ctx, row, r) == FALSE)
       {
-         InputValidation = FALSE; /* Mark input as invalid if row processing fails */
+         ctx->input_validation = FALSE; /* Mark input as invalid if row processing fails */
       }
-      r++; /* Increment line counter */
-      row[0] = '\0'; /* Clear the row buffer for the next line */
    }
 
-   return InputValidation; /* Return the overall validation result */
+   return ctx->input_validation; /* Return the overall validation result */
 }
 
 
 
 
-int first_path(const char* fileName,
-   struct Macro* macro_table,
-   int macro_table_size,
-   struct Symbol** symbols_table,
-   int* symbols_table_size,
-   int** cmd_code,
-   int cmd_capacity,
-   int* ICF,
-   int** data_code,
-   int data_capacity,
-   int* DCF)
+int first_path(struct AssemblerContext* ctx)
 {
-   FILE *source; /* Pointer to the source file */
-   char amFilename[256]; /* Buffer to store the filename with ".am" extension */
    int input_validation, i; /* Variables for input validation and loop index */
-   DC = 0;
-   IC = 0; /* Initialize Data Counter (DC) and Instruction Counter (IC) */
+   ctx->DC = 0;
+   ctx->IC = 0; /* Initialize Data Counter (DC) and Instruction Counter (IC) */
 
-   sprintf(amFilename, "%s%s", fileName, ".am"); /* Create the filename with ".am" extension */
-   source = fopen(amFilename, "r"); /* Open the source file in read mode */
-   if (source == NULL) { /* Check if the file failed to open */
-      perror("Error opening source file"); /* Print error message */
-      exit(EXIT_FAILURE); /* Exit the program with failure */
-   }
-
-   /* Read the source file and process rows in the first pass */
-   input_validation = read_row_first(fileName, source, cmd_code, data_code, symbols_table,
-      symbols_table_size, macro_table, macro_table_size, cmd_capacity, data_capacity);
+   /* Read the expanded source and process rows in the first pass */
+   input_validation = read_row_first(ctx);
 
-   *ICF = IC; /* Set the final instruction counter value */
-   for (i = 0; i < *symbols_table_size; i++) { /* Iterate over the symbols table */
-      struct Symbol *pSymbol = &((*symbols_table)[i]); /* Pointer to the current symbol */
-      if (pSymbol->type != NULL && strstr(pSymbol->type, "data") != NULL) {
+   ctx->ICF = ctx->IC; /* Set the final instruction counter value */
+   for (i = 0; i < ctx->symbol_count; i++) { /* Iterate over the symbols table */
+      struct Symbol *pSymbol = &(ctx->symbols_table[i]); /* Pointer to the current symbol */
+      if (pSymbol->kind & SYMBOL_DATA) {
          /* Adjust the address of data symbols */
-         pSymbol->address += (*ICF + 100);
-      } else if (pSymbol->type != NULL && strstr(pSymbol->type, "code") != NULL) {
+         pSymbol->address += (ctx->ICF + 100);
+      } else if (pSymbol->kind & SYMBOL_CODE) {
          /* Adjust the address of code symbols */
          pSymbol->address += 100;
-      } else if (pSymbol->type != NULL && strstr(pSymbol->type, "entry") != NULL) {
+      } else if (pSymbol->kind & SYMBOL_ENTRY) {
          /* Check if entry symbols have a defined address */
          if (pSymbol->address == NO) {
-            printf("Error: the address of the entry symbol (%s) is not defined.\n", pSymbol->name);
+            report_message(ctx, "Error: the address of the entry symbol (%s) is not defined.\n", pSymbol->name);
             input_validation = FALSE; /* Mark input as invalid */
          }
       }
    }
 
-   fclose(source); /* Close the source file */
-
-   *DCF = DC; /* Set the final data counter value */
+   ctx->DCF = ctx->DC; /* Set the final data counter value */
+   ctx->input_validation = input_validation;
    return input_validation; /* Return the validation result */
 }
\ No newline at end of file
@@ -8,45 +8,27 @@
 
 
 /**
- * @brief Performs the first pass of the assembler process on the given source file.
+ * @brief Performs the first pass of the assembler process on the expanded source of a file.
  *
- * This function reads the source file, processes its rows, and updates the symbol table,
- * command code, and data code. It also calculates the final instruction counter (ICF)
- * and data counter (DCF) values. The function handles macros, symbols, and validates
+ * This function goes over the lines of the expanded source, processes its rows, and updates
+ * the symbol table, command code, and data code. It also calculates the final instruction
+ * counter (ICF) and data counter (DCF) values. The function handles symbols and validates
  * the input during the first pass.
  *
- * @param fileName The name of the source file (without extension) to process.
- * @param macro_table An array of Macro structures containing macro definitions.
- * @param macro_table_size The size of the macro table.
- * @param symbols_table A pointer to the symbol table, which will be updated during processing.
- * @param symbols_table_size A pointer to the size of the symbol table, which will be updated.
- * @param cmd_code A pointer to the command code array, which will be updated during processing.
- * @param cmd_capacity The capacity of the command code array.
- * @param ICF A pointer to store the final instruction counter value.
- * @param data_code A pointer to the data code array, which will be updated during processing.
- * @param data_capacity The capacity of the data code array.
- * @param DCF A pointer to store the final data counter value.
+ * @param ctx The context of the file to process. Its symbols table, code arrays and counters are
+ *            updated during processing, and its ICF and DCF are set at the end of the pass.
  * 
  * @return TRUE if the first pass was successful and did not find errors in the input file, FALSE otherwise.
  *
- * @note The function assumes that the source file has already been preprocessed
- *       (e.g., macros expanded) and has a ".am" extension.
+ * @note The function reads the lines of the source after macro expansion from `ctx->lines`
+ *       (`ctx->line_count` of them), filled in memory by the pre-assembler; no .am file is read.
  * @note The function updates the addresses of symbols in the symbol table based on their type.
  *       Symbols of type "data" are offset by (ICF + 100), and symbols of type "code" are offset by 100.
  *       If a symbol of type "entry" has an undefined address, an error is reported.
- * @note The function exits the program with an error message if the source file cannot be opened.
+ * @note The function opens no file; the errors it finds in the source are reported to the
+ *       messages of the context.
  */
-int first_path(const char* fileName,
-   struct Macro* macro_table,
-   int macro_table_size,
-   struct Symbol** symbols_table,
-   int* symbols_table_size,
-   int** cmd_code,
-   int cmd_capacity,
-   int* ICF,
-   int** data_code,
-   int data_capacity,
-   int* DCF);
+int first_path(struct AssemblerContext* ctx);
 
 
    
@@ -55,25 +37,24 @@ int first_path(const char* fileName,
  * @brief Manages the symbols table by performing various actions such as adding a symbol, 
  *        updating its type, finding a symbol, retrieving its address, or adding an external address.
  * 
+ * @param ctx The context of the file being processed (holds the symbols table and the macro table).
  * @param name The name of the symbol to manage.
- * @param type The type of the symbol ("code", "data", "entry", "external").
- * @param symbols_table Pointer to the symbols table array.
- * @param symbols_table_size Pointer to the size of the symbols table.
+ * @param kind The kind of the symbol (SYMBOL_CODE, SYMBOL_DATA, SYMBOL_ENTRY or SYMBOL_EXTERNAL).
  * @param action The action to perform (ADD_NAME, ADD_TYPE, FIND_NAME, GET_ADDRESS, ADD_EXTERNAL_ADDRESS).
  * @param address The address to assign to the symbol (used for ADD_NAME and ADD_EXTERNAL_ADDRESS actions).
  * @param r The line number in the source code for error reporting.
- * @param macro_table Pointer to the macro table array.
- * @param macro_table_size The size of the macro table.
  * @param index The index of the symbol in the table (used for GET_ADDRESS and ADD_EXTERNAL_ADDRESS actions).
  * 
  * @return int Returns TRUE (1) on success, FALSE (0) on failure; or the index of the symbol / NO (-1)  in the table for FIND_NAME.
  * 
- * @note This function handles memory allocation for the symbols table and external addresses.
+ * @note This function handles memory allocation for the symbols table and the uses of external symbols.
  *       It also performs error checking for conflicting symbol definitions.
+ * @note Symbols are looked up by name through a hash index, while the table itself keeps them in
+ *       order of definition (the order of the .ent and .ext files).
  */
 
- int symbols_table_management(char* name, char* type, struct Symbol** symbols_table, int* symbols_table_size,
-   int action, int address, int r, struct Macro* macro_table, int macro_table_size, int index);
+ int symbols_table_management(struct AssemblerContext* ctx, char* name, int kind,
+   int action, int address, int r, int index);
 
 
 #endif /* FIRST_PATH_H */
\ No newline at end of file
@@ -31,60 +31,77 @@ struct cmd_struct cmd[] = {
    {"stop", 0, 15, NULL, NULL, 001111, 000000},
 };
 
+/*
+ * Perfect hash of all the fixed words: the commands, the registers, the reserved words and the directives.
+ * Every word lands in its own slot of `fixed_words` at
+ *    (4 * length + 3 * word[0] + 7 * word[1] + 7 * word[length - 1]) % FIXED_WORDS_SIZE,
+ * so classifying a token takes one hash and a single comparison.
+ * The factors were searched for offline; the table must be regenerated if a fixed word is added.
+ */
+static const struct fixed_word fixed_words[FIXED_WORDS_SIZE] = {
+   {"cmp", WORD_COMMAND, 1}, {".data", WORD_DIRECTIVE, DIRECTIVE_DATA}, {NULL, WORD_NONE, 0}, {NULL, WORD_NONE, 0},
+   {"r5", WORD_REGISTER, 5}, {NULL, WORD_NONE, 0}, {"sub", WORD_COMMAND, 3}, {"clr", WORD_COMMAND, 5},
+   {NULL, WORD_NONE, 0}, {NULL, WORD_NONE, 0}, {"data", WORD_RESERVED, DIRECTIVE_DATA}, {"not", WORD_COMMAND, 6},
+   {"r1", WORD_REGISTER, 1}, {"jsr", WORD_COMMAND, 11}, {NULL, WORD_NONE, 0}, {NULL, WORD_NONE, 0},
+   {NULL, WORD_NONE, 0}, {"extern", WORD_RESERVED, DIRECTIVE_EXTERN}, {"r6", WORD_REGISTER, 6}, {NULL, WORD_NONE, 0},
+   {"entry", WORD_RESERVED, DIRECTIVE_ENTRY}, {"jmp", WORD_COMMAND, 9}, {"mov", WORD_COMMAND, 0}, {NULL, WORD_NONE, 0},
+   {NULL, WORD_NONE, 0}, {NULL, WORD_NONE, 0}, {"r2", WORD_REGISTER, 2}, {NULL, WORD_NONE, 0},
+   {".string", WORD_DIRECTIVE, DIRECTIVE_STRING}, {NULL, WORD_NONE, 0}, {NULL, WORD_NONE, 0}, {NULL, WORD_NONE, 0},
+   {"r7", WORD_REGISTER, 7}, {"red", WORD_COMMAND, 12}, {NULL, WORD_NONE, 0}, {NULL, WORD_NONE, 0},
+   {NULL, WORD_NONE, 0}, {"stop", WORD_COMMAND, 15}, {NULL, WORD_NONE, 0}, {"add", WORD_COMMAND, 2},
+   {"r3", WORD_REGISTER, 3}, {NULL, WORD_NONE, 0}, {NULL, WORD_NONE, 0}, {".extern", WORD_DIRECTIVE, DIRECTIVE_EXTERN},
+   {NULL, WORD_NONE, 0}, {NULL, WORD_NONE, 0}, {"string", WORD_RESERVED, DIRECTIVE_STRING}, {NULL, WORD_NONE, 0},
+   {"dec", WORD_COMMAND, 8}, {NULL, WORD_NONE, 0}, {NULL, WORD_NONE, 0}, {"rts", WORD_COMMAND, 14},
+   {".entry", WORD_DIRECTIVE, DIRECTIVE_ENTRY}, {NULL, WORD_NONE, 0}, {"r4", WORD_REGISTER, 4}, {"bne", WORD_COMMAND, 10},
+   {NULL, WORD_NONE, 0}, {NULL, WORD_NONE, 0}, {"lea", WORD_COMMAND, 4}, {NULL, WORD_NONE, 0},
+   {"prn", WORD_COMMAND, 13}, {NULL, WORD_NONE, 0}, {"inc", WORD_COMMAND, 7}, {NULL, WORD_NONE, 0},
+};
+
+int classify_word(char* word, int* index) {
+   size_t length; /* Length of the word */
+   const struct fixed_word* candidate; /* The only fixed word that may match */
+
+   length = strlen(word);
+   if (length < 2 || length > MAX_FIXED_WORD_LENGTH) /* Shorter or longer than every fixed word */
+      return WORD_NONE;
+
+   candidate = &fixed_words[(4 * length + 3 * (unsigned char)word[0] + 7 * (unsigned char)word[1] +
+                             7 * (unsigned char)word[length - 1]) % FIXED_WORDS_SIZE];
+   if (candidate->name == NULL || strcmp(word, candidate->name) != 0)
+      return WORD_NONE;
+
+   if (index != NULL)
+      *index = candidate->index;
+   return candidate->kind;
+}
+
 int get_opcode(char* word) {
    int i;
-   /* Iterate through the command table to find the matching command name */
-   for (i = 0; i < 16; i++) {
-     if (strcmp(word, cmd[i].name) == 0) {
-       return cmd[i].opcode_bin; /* Return the binary opcode if found */
-     }
-   }
+   /* Look the word up, and return the binary opcode if it is a command */
+   if (classify_word(word, &i) == WORD_COMMAND)
+      return cmd[i].opcode_bin;
    return FALSE; /* Return FALSE if not found */
 }
 
 int get_funct(char* word) {
    int i;
-   /* Iterate through the command table to find the matching command name */
-   for (i = 0; i < 16; i++) {
-     if (strcmp(word, cmd[i].name) == 0) {
-       return cmd[i].funct; /* Return the funct value if found */
-     }
-   }
+   /* Look the word up, and return the funct value if it is a command */
+   if (classify_word(word, &i) == WORD_COMMAND)
+      return cmd[i].funct;
    return NO; /* Return NO if not found */
 }
 
 int cmd_table(char* word) {
    int i;
-   /* Iterate through the command table to find the matching command name */
-   for (i = 0; i < 16; i++) {
-     if (strcmp(word, cmd[i].name) == 0) {
-       return i; /* Return the index of the command in the table */
-     }
-   }
+   /* Look the word up, and return the index of the command in the table */
+   if (classify_word(word, &i) == WORD_COMMAND)
+      return i;
    return NO; /* Return NO if not found */
 }
 
 int reserved_word(char* word) {
-   int i;
-   /* Check if the word matches any command name in the command table */
-   for (i = 0; i < 16; i++) {
-     if (strcmp(word, cmd[i].name) == 0) {
-       return TRUE; /* Return TRUE if the word is a command */
-     }
-   }
-
-   /* Check if the word matches any reserved keyword */
-   for (i = 0; i < 27; i++) {
-     if (strcmp(word, reswords[i]) == 0) {
-       return TRUE; /* Return TRUE if the word is reserved */
-     }
-   }
-   return FALSE; /* Return FALSE if not reserved */
+   int kind;
+   /* Commands, registers and the directive names (without the dot) are reserved */
+   kind = classify_word(word, NULL);
+   return kind == WORD_COMMAND || kind == WORD_REGISTER || kind == WORD_RESERVED;
 }
-
-/* Array of reserved words including commands, registers, and keywords */
-char reswords[27][8] = {
-   "mov", "cmp", "add", "sub", "lea", "clr", "not", "inc", "dec", "jmp", "bne", "jsr", "red", "prn", "rts", "stop",
-   "r1", "r2", "r3", "r4", "r5", "r6", "r7",
-   "data", "string", "entry", "extern"
-};
@@ -31,6 +31,39 @@ struct cmd_struct {
 
 
 
+#define WORD_NONE 0        /* Not a fixed word */
+#define WORD_COMMAND 1     /* A command (index in `cmd`) */
+#define WORD_REGISTER 2    /* A register (index is its number) */
+#define WORD_RESERVED 3    /* A directive name without its dot: data, string, entry, extern */
+#define WORD_DIRECTIVE 4   /* A directive: .data, .string, .entry, .extern */
+
+#define DIRECTIVE_DATA 0   /* The index of .data (and data) */
+#define DIRECTIVE_STRING 1 /* The index of .string (and string) */
+#define DIRECTIVE_ENTRY 2  /* The index of .entry (and entry) */
+#define DIRECTIVE_EXTERN 3 /* The index of .extern (and extern) */
+
+#define FIXED_WORDS_SIZE 64
+#define MAX_FIXED_WORD_LENGTH 7
+
+
+
+/**
+ * struct fixed_word - A word with a fixed meaning, as classified by classify_word.
+ * @name: The word.
+ * @kind: WORD_COMMAND, WORD_REGISTER, WORD_RESERVED or WORD_DIRECTIVE.
+ * @index: The index of the command in `cmd`, the number of the register, or the index of the
+ *         directive (DIRECTIVE_DATA, DIRECTIVE_STRING, DIRECTIVE_ENTRY or DIRECTIVE_EXTERN).
+ */
+struct fixed_word {
+    char *name;
+    int kind;
+    int index;
+};
+
+
+
+
+
 /**
  * @var cmd
  * @brief Array of command structures.
@@ -43,6 +76,22 @@ extern struct cmd_struct cmd[16];
 
 
 
+/**
+ * @fn int classify_word(char *word, int *index)
+ * @brief Classifies a word as a command, a register, a reserved word or a directive, in one lookup.
+ *
+ * @param word A string representing the word.
+ * @param index Pointer to store the index of the word within its kind (see struct fixed_word), or NULL.
+ * @return The kind of the word (WORD_COMMAND, WORD_REGISTER, WORD_RESERVED or WORD_DIRECTIVE),
+ *         or WORD_NONE if the word has no fixed meaning.
+ *
+ * The word is looked up in a perfect hash of all the fixed words, so only one comparison is made.
+ * The other lookup functions of this file are wrappers of this function.
+ */
+int classify_word(char *word, int *index);
+
+
+
 /**
  * @fn char *get_opcode(char *word)
  * @brief Retrieves the opcode associated with a given command word.
@@ -102,24 +151,12 @@ int cmd_table(char *word);
  * @param word A string representing the word to check.
  * @return 1 if the word is a reserved word, 0 otherwise.
  *
- * This function searches for the given word in the reserved words table
- * and determines whether it is a reserved word. It assumes that the input
- * word is a valid null-terminated string.
+ * This function classifies the given word with classify_word: commands,
+ * registers and the directive names without their dot are reserved. It
+ * assumes that the input word is a valid null-terminated string.
  */
 
 int reserved_word(char *word);
 
 
-
-/**
- * @var reswords
- * @brief Array of reserved words.
- *
- * This 2D array contains 27 reserved words, each with a maximum length
- * of 7 characters (plus a null terminator). These words are predefined
- * and cannot be used as identifiers or commands in the system.
- */
-
-extern char reswords[27][8];
-
 #endif /* FIXED_TABLES_H */
\ No newline at end of file
@@ -0,0 +1,118 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include "hash_index.h"
+#include "auxiliary_functions_constants.h"
+
+
+/**
+ * @brief Puts an element in the first empty slot of its probe sequence.
+ *
+ * @param entries The slots of the index.
+ * @param capacity The number of slots (a power of two).
+ * @param hash The hash of the name of the element.
+ * @param id The index of the element in its table.
+ */
+static void place_entry(struct HashEntry* entries, int capacity, unsigned long hash, int id);
+
+
+
+/**
+ * @brief Doubles the number of slots of an index and places its elements again.
+ *
+ * @param index The index to grow.
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+static void grow_hash_index(struct HashIndex* index);
+
+
+
+unsigned long hash_name(const char* name, size_t length) {
+   unsigned long hash; /* The hash so far */
+   size_t i; /* Index in the name */
+
+   hash = 2166136261UL; /* FNV offset basis */
+   for (i = 0; i < length; i++) {
+      hash ^= (unsigned char)name[i];
+      hash = (hash * 16777619UL) & 0xFFFFFFFFUL; /* FNV prime, kept to 32 bits */
+   }
+   return hash;
+}
+
+
+
+static void place_entry(struct HashEntry* entries, int capacity, unsigned long hash, int id) {
+   int slot; /* The probed slot */
+
+   for (slot = (int)(hash & (capacity - 1)); entries[slot].id != NO; slot = (slot + 1) & (capacity - 1))
+      ;
+   entries[slot].hash = hash;
+   entries[slot].id = id;
+}
+
+
+
+static void grow_hash_index(struct HashIndex* index) {
+   struct HashEntry* entries; /* The new slots */
+   int capacity, i; /* Number of new slots, loop index */
+
+   capacity = index->capacity == 0 ? INITIAL_HASH_INDEX_SIZE : index->capacity * 2;
+   entries = (struct HashEntry*)malloc(capacity * sizeof(struct HashEntry));
+   if (entries == NULL) {
+      perror("Error allocating memory for hash index");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < capacity; i++)
+      entries[i].id = NO;
+
+   /* Place the elements again, by their kept hashes */
+   for (i = 0; i < index->capacity; i++) {
+      if (index->entries[i].id != NO)
+         place_entry(entries, capacity, index->entries[i].hash, index->entries[i].id);
+   }
+
+   free(index->entries);
+   index->entries = entries;
+   index->capacity = capacity;
+}
+
+
+
+int hash_index_find(const struct HashIndex* index, const char* name, size_t length, HashKey key, const void* table) {
+   unsigned long hash; /* The hash of the name */
+   const char* candidate; /* The name of an element with the same hash */
+   int slot; /* The probed slot */
+
+   if (index->count == 0)
+      return NO;
+
+   hash = hash_name(name, length);
+   for (slot = (int)(hash & (index->capacity - 1)); index->entries[slot].id != NO; slot = (slot + 1) & (index->capacity - 1)) {
+      if (index->entries[slot].hash != hash)
+         continue;
+      candidate = key(table, index->entries[slot].id);
+      if (strncmp(candidate, name, length) == 0 && candidate[length] == '\0')
+         return index->entries[slot].id;
+   }
+   return NO;
+}
+
+
+
+void hash_index_insert(struct HashIndex* index, const char* name, size_t length, int id) {
+   if ((index->count + 1) * 2 > index->capacity) /* Keep the index at most half full */
+      grow_hash_index(index);
+
+   place_entry(index->entries, index->capacity, hash_name(name, length), id);
+   index->count++;
+}
+
+
+
+void free_hash_index(struct HashIndex* index) {
+   free(index->entries);
+   index->entries = NULL;
+   index->capacity = 0;
+   index->count = 0;
+}
@@ -0,0 +1,101 @@
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include <stddef.h>
+
+#define INITIAL_HASH_INDEX_SIZE 64
+
+
+
+/**
+ * @brief A slot of a hash index.
+ * @struct HashEntry
+ * @param hash The hash of the name of the element.
+ * @param id The index of the element in its table, or NO (-1) for an empty slot.
+ */
+struct HashEntry {
+   unsigned long hash;
+   int id;
+};
+
+
+
+/**
+ * @brief An open-addressing (linear probing) index from names to the elements of a table.
+ * @struct HashIndex
+ *
+ * The index only keeps the position of every element in its table, so the table itself keeps its
+ * order (the order of insertion). The names are compared through a function that returns the name
+ * of an element of the table.
+ *
+ * @param entries The slots of the index (NULL until the first insertion).
+ * @param capacity The number of slots, a power of two.
+ * @param count The number of elements in the index.
+ */
+struct HashIndex {
+   struct HashEntry* entries;
+   int capacity;
+   int count;
+};
+
+
+
+/**
+ * @brief Returns the name of an element of a table, for comparing it with a searched name.
+ *
+ * @param table The table of the elements.
+ * @param id The index of the element in the table.
+ * @return The name of the element (null-terminated).
+ */
+typedef const char* (*HashKey)(const void* table, int id);
+
+
+
+/**
+ * @brief Computes the hash of a name (FNV-1a).
+ *
+ * @param name The name (does not have to be null-terminated).
+ * @param length The number of characters of the name.
+ * @return The hash of the name.
+ */
+unsigned long hash_name(const char* name, size_t length);
+
+
+
+/**
+ * @brief Finds an element of a table by its name.
+ *
+ * @param index The index of the table.
+ * @param name The name to find (does not have to be null-terminated).
+ * @param length The number of characters of the name.
+ * @param key Function returning the name of an element of the table.
+ * @param table The table of the elements, passed to `key`.
+ * @return The index of the element in the table, or NO (-1) if there is no element with that name.
+ */
+int hash_index_find(const struct HashIndex* index, const char* name, size_t length, HashKey key, const void* table);
+
+
+
+/**
+ * @brief Adds an element to the index.
+ *
+ * @param index The index of the table.
+ * @param name The name of the element (does not have to be null-terminated).
+ * @param length The number of characters of the name.
+ * @param id The index of the element in its table.
+ *
+ * @note The name must not be in the index already.
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+void hash_index_insert(struct HashIndex* index, const char* name, size_t length, int id);
+
+
+
+/**
+ * @brief Frees the slots of an index and empties it.
+ *
+ * @param index The index to free.
+ */
+void free_hash_index(struct HashIndex* index);
+
+#endif /* HASH_INDEX_H */
@@ -0,0 +1,397 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include "json_value.h"
+
+
+/**
+ * @brief The state of the parser.
+ * @struct JsonParser
+ * @param arena The arena the values are allocated from.
+ * @param p The next character to read.
+ * @param end The end of the text.
+ * @param depth The nesting depth of the value being parsed.
+ */
+struct JsonParser {
+   struct Arena* arena;
+   const char* p;
+   const char* end;
+   int depth;
+};
+
+
+
+/**
+ * @brief Skips the white space before the next token.
+ *
+ * @param parser The state of the parser.
+ */
+static void skip_space(struct JsonParser* parser);
+
+
+
+/**
+ * @brief Parses a value.
+ *
+ * @param parser The state of the parser.
+ * @return The value, or NULL if the text is not valid.
+ */
+static struct JsonValue* parse_value(struct JsonParser* parser);
+
+
+
+/**
+ * @brief Parses a string literal, starting at its opening quote.
+ *
+ * @param parser The state of the parser.
+ * @param length Pointer to store the length of the decoded string.
+ * @return The decoded string (null-terminated), or NULL if the literal is not valid.
+ */
+static char* parse_string(struct JsonParser* parser, size_t* length);
+
+
+
+/**
+ * @brief Reads the 4 hexadecimal digits of a \\u escape.
+ *
+ * @param parser The state of the parser, at the first digit.
+ * @return The code unit, or NO if the digits are not valid.
+ */
+static long parse_hex4(struct JsonParser* parser);
+
+
+
+/**
+ * @brief Writes a code point in UTF-8.
+ *
+ * @param code The code point.
+ * @param out The buffer to write to (room for 4 bytes).
+ * @return The number of bytes written.
+ */
+static int put_utf8(unsigned long code, char* out);
+
+
+
+
+static void skip_space(struct JsonParser* parser) {
+   while (parser->p < parser->end && (*parser->p == ' ' || *parser->p == '\t' || *parser->p == '\n' || *parser->p == '\r'))
+      parser->p++;
+}
+
+
+
+
+static long parse_hex4(struct JsonParser* parser) {
+   long code = 0; /* The code unit */
+   int i, digit; /* Loop index and the value of a digit */
+
+   if (parser->end - parser->p < 4)
+      return NO;
+   for (i = 0; i < 4; i++, parser->p++) {
+      if (isdigit((unsigned char)*parser->p))
+         digit = *parser->p - '0';
+      else if (*parser->p >= 'a' && *parser->p <= 'f')
+         digit = *parser->p - 'a' + 10;
+      else if (*parser->p >= 'A' && *parser->p <= 'F')
+         digit = *parser->p - 'A' + 10;
+      else
+         return NO;
+      code = code * 16 + digit;
+   }
+   return code;
+}
+
+
+
+
+static int put_utf8(unsigned long code, char* out) {
+   if (code < 0x80) {
+      out[0] = (char)code;
+      return 1;
+   }
+   if (code < 0x800) {
+      out[0] = (char)(0xC0 | (code >> 6));
+      out[1] = (char)(0x80 | (code & 0x3F));
+      return 2;
+   }
+   if (code < 0x10000) {
+      out[0] = (char)(0xE0 | (code >> 12));
+      out[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+      out[2] = (char)(0x80 | (code & 0x3F));
+      return 3;
+   }
+   out[0] = (char)(0xF0 | (code >> 18));
+   out[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+   out[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+   out[3] = (char)(0x80 | (code & 0x3F));
+   return 4;
+}
+
+
+
+
+static char* parse_string(struct JsonParser* parser, size_t* length) {
+   const char* start; /* The first character after the opening quote */
+   char* text, * out; /* The decoded string, and the next byte to write */
+   long code, low; /* A code unit of a \u escape, and the low half of a surrogate pair */
+
+   start = ++parser->p;
+   while (parser->p < parser->end && *parser->p != '"') /* Find the closing quote, to size the string */
+      parser->p += *parser->p == '\\' ? 2 : 1;
+   if (parser->p >= parser->end)
+      return NULL;
+
+   /* Every escape decodes to fewer bytes than it takes, so the literal is large enough for the string */
+   text = out = (char*)arena_alloc(parser->arena, parser->p - start + 1);
+   for (parser->p = start; *parser->p != '"';) {
+      if ((unsigned char)*parser->p < 0x20)
+         return NULL; /* Control characters must be escaped */
+      if (*parser->p != '\\') {
+         *out++ = *parser->p++;
+         continue;
+      }
+
+      parser->p++;
+      switch (*parser->p++) {
+         case '"': *out++ = '"'; break;
+         case '\\': *out++ = '\\'; break;
+         case '/': *out++ = '/'; break;
+         case 'b': *out++ = '\b'; break;
+         case 'f': *out++ = '\f'; break;
+         case 'n': *out++ = '\n'; break;
+         case 'r': *out++ = '\r'; break;
+         case 't': *out++ = '\t'; break;
+         case 'u':
+            if ((code = parse_hex4(parser)) == NO)
+               return NULL;
+            if (code >= 0xD800 && code < 0xDC00 && parser->end - parser->p >= 6 &&
+                parser->p[0] == '\\' && parser->p[1] == 'u') { /* A surrogate pair */
+               parser->p += 2;
+               if ((low = parse_hex4(parser)) == NO || low < 0xDC00 || low >= 0xE000)
+                  return NULL;
+               code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            out += put_utf8((unsigned long)code, out);
+            break;
+         default:
+            return NULL;
+      }
+   }
+   parser->p++; /* The closing quote */
+
+   *out = '\0';
+   *length = out - text;
+   return text;
+}
+
+
+
+
+static struct JsonValue* parse_value(struct JsonParser* parser) {
+   struct JsonValue* value, * child, ** link; /* The value, an element or member, and where to link the next one */
+   char* end; /* The end of a number */
+   size_t length; /* Length of a member name */
+
+   skip_space(parser);
+   if (parser->p >= parser->end || parser->depth >= JSON_MAX_DEPTH)
+      return NULL;
+   value = (struct JsonValue*)arena_alloc(parser->arena, sizeof(struct JsonValue));
+
+   switch (*parser->p) {
+      case '{':
+      case '[':
+         value->type = *parser->p == '{' ? JSON_OBJECT : JSON_ARRAY;
+         parser->p++;
+         parser->depth++;
+         link = &value->children;
+         skip_space(parser);
+         if (parser->p < parser->end && *parser->p == (value->type == JSON_OBJECT ? '}' : ']')) {
+            parser->p++;
+            parser->depth--;
+            return value; /* Empty */
+         }
+         for (;;) {
+            char* key = NULL; /* The name of a member */
+
+            if (value->type == JSON_OBJECT) {
+               skip_space(parser);
+               if (parser->p >= parser->end || *parser->p != '"' || (key = parse_string(parser, &length)) == NULL)
+                  return NULL;
+               skip_space(parser);
+               if (parser->p >= parser->end || *parser->p++ != ':')
+                  return NULL;
+            }
+            if ((child = parse_value(parser)) == NULL)
+               return NULL;
+            child->key = key;
+            *link = child;
+            link = &child->next;
+
+            skip_space(parser);
+            if (parser->p >= parser->end)
+               return NULL;
+            if (*parser->p == ',') {
+               parser->p++;
+               continue;
+            }
+            if (*parser->p++ != (value->type == JSON_OBJECT ? '}' : ']'))
+               return NULL;
+            parser->depth--;
+            return value;
+         }
+
+      case '"':
+         value->type = JSON_STRING;
+         value->text = parse_string(parser, &value->length);
+         return value->text != NULL ? value : NULL;
+
+      case 't':
+      case 'f':
+      case 'n':
+         if (parser->end - parser->p >= 4 && strncmp(parser->p, "true", 4) == 0)
+            value->type = JSON_TRUE, parser->p += 4;
+         else if (parser->end - parser->p >= 5 && strncmp(parser->p, "false", 5) == 0)
+            value->type = JSON_FALSE, parser->p += 5;
+         else if (parser->end - parser->p >= 4 && strncmp(parser->p, "null", 4) == 0)
+            value->type = JSON_NULL, parser->p += 4;
+         else
+            return NULL;
+         return value;
+
+      default:
+         if (*parser->p != '-' && !isdigit((unsigned char)*parser->p))
+            return NULL;
+         value->type = JSON_NUMBER;
+         value->number = strtod(parser->p, &end); /* The text is null-terminated, so strtod stops in it */
+         if (end == parser->p || end > parser->end)
+            return NULL;
+         parser->p = end;
+         return value;
+   }
+}
+
+
+
+
+struct JsonValue* json_parse(struct Arena* arena, const char* text, size_t length) {
+   struct JsonParser parser; /* The state of the parser */
+   struct JsonValue* root; /* The parsed value */
+
+   parser.arena = arena;
+   parser.p = text;
+   parser.end = text + length;
+   parser.depth = 0;
+
+   root = parse_value(&parser);
+   skip_space(&parser);
+   return parser.p == parser.end ? root : NULL; /* Nothing may follow the value */
+}
+
+
+
+
+const struct JsonValue* json_find(const struct JsonValue* value, const char* path) {
+   const struct JsonValue* member; /* A member of the current object */
+   size_t length; /* Length of the current name of the path */
+
+   while (value != NULL && *path != '\0') {
+      if (value->type != JSON_OBJECT)
+         return NULL;
+      length = strcspn(path, ".");
+      for (member = value->children; member != NULL; member = member->next) {
+         if (strncmp(member->key, path, length) == 0 && member->key[length] == '\0')
+            break;
+      }
+      value = member;
+      path += length + (path[length] == '.');
+   }
+   return value;
+}
+
+
+
+
+long json_integer(const struct JsonValue* value, long fallback) {
+   return value != NULL && value->type == JSON_NUMBER ? (long)value->number : fallback;
+}
+
+
+
+
+const char* json_text(const struct JsonValue* value) {
+   return value != NULL && value->type == JSON_STRING ? value->text : NULL;
+}
+
+
+
+
+void json_append_string(struct TextBuffer* buffer, const char* text, size_t length) {
+   char escape[8]; /* An escaped character */
+   size_t i, start; /* Loop index, and the start of the characters not appended yet */
+
+   append_text(buffer, "\"", 1);
+   for (i = 0, start = 0; i < length; i++) {
+      unsigned char c = (unsigned char)text[i];
+
+      if (c != '"' && c != '\\' && c >= 0x20)
+         continue;
+      append_text(buffer, text + start, i - start); /* The characters before the escape */
+      if (c == '"' || c == '\\')
+         sprintf(escape, "\\%c", c);
+      else if (c == '\n')
+         strcpy(escape, "\\n");
+      else if (c == '\t')
+         strcpy(escape, "\\t");
+      else
+         sprintf(escape, "\\u%04x", c);
+      append_text(buffer, escape, strlen(escape));
+      start = i + 1;
+   }
+   append_text(buffer, text + start, length - start);
+   append_text(buffer, "\"", 1);
+}
+
+
+
+
+void json_append_value(struct TextBuffer* buffer, const struct JsonValue* value) {
+   char number[64]; /* A number in decimal */
+   const struct JsonValue* child; /* An element or member */
+
+   if (value == NULL || value->type == JSON_NULL) {
+      append_text(buffer, "null", 4);
+      return;
+   }
+
+   switch (value->type) {
+      case JSON_FALSE:
+         append_text(buffer, "false", 5);
+         break;
+      case JSON_TRUE:
+         append_text(buffer, "true", 4);
+         break;
+      case JSON_NUMBER:
+         if (value->number == (double)(long)value->number)
+            sprintf(number, "%ld", (long)value->number); /* Ids and positions are integers */
+         else
+            sprintf(number, "%.17g", value->number);
+         append_text(buffer, number, strlen(number));
+         break;
+      case JSON_STRING:
+         json_append_string(buffer, value->text, value->length);
+         break;
+      default: /* Array or object */
+         append_text(buffer, value->type == JSON_OBJECT ? "{" : "[", 1);
+         for (child = value->children; child != NULL; child = child->next) {
+            if (child != value->children)
+               append_text(buffer, ",", 1);
+            if (value->type == JSON_OBJECT) {
+               json_append_string(buffer, child->key, strlen(child->key));
+               append_text(buffer, ":", 1);
+            }
+            json_append_value(buffer, child);
+         }
+         append_text(buffer, value->type == JSON_OBJECT ? "}" : "]", 1);
+         break;
+   }
+}
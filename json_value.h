@@ -0,0 +1,112 @@
+/**
+ * @file json_value.h
+ * @brief A small JSON parser and writer, for the messages of the language server.
+ *
+ * A message is parsed into a tree of values allocated from an arena, so the whole tree is released
+ * at once with the arena. The elements of an array and the members of an object are linked lists,
+ * in their order in the text.
+ */
+
+#ifndef JSON_VALUE_H
+#define JSON_VALUE_H
+#include "auxiliary_functions_constants.h"
+
+#define JSON_NULL 0
+#define JSON_FALSE 1
+#define JSON_TRUE 2
+#define JSON_NUMBER 3
+#define JSON_STRING 4
+#define JSON_ARRAY 5
+#define JSON_OBJECT 6
+
+#define JSON_MAX_DEPTH 64 /* Deeper nesting is rejected, so a message cannot exhaust the stack */
+
+
+
+/**
+ * @brief A JSON value.
+ * @struct JsonValue
+ * @param type The type of the value (JSON_NULL to JSON_OBJECT).
+ * @param number The value of a number.
+ * @param text The value of a string, decoded and null-terminated (it may also contain null characters).
+ * @param length The length of the string in bytes.
+ * @param key The name of the value when it is a member of an object, NULL otherwise.
+ * @param children The first element of an array or the first member of an object.
+ * @param next The next element or member of the parent.
+ */
+struct JsonValue {
+   int type;
+   double number;
+   char* text;
+   size_t length;
+   char* key;
+   struct JsonValue* children;
+   struct JsonValue* next;
+};
+
+
+
+/**
+ * @brief Parses a JSON text.
+ *
+ * @param arena The arena to allocate the values from.
+ * @param text The text to parse (it must be followed by a null character).
+ * @param length The length of the text.
+ * @return The root value, or NULL if the text is not valid JSON.
+ */
+struct JsonValue* json_parse(struct Arena* arena, const char* text, size_t length);
+
+
+
+/**
+ * @brief Finds a value by its path of member names, separated by dots ("textDocument.uri").
+ *
+ * @param value The object to start from (NULL is allowed).
+ * @param path The member names.
+ * @return The value, or NULL if a member is missing or a value on the path is not an object.
+ */
+const struct JsonValue* json_find(const struct JsonValue* value, const char* path);
+
+
+
+/**
+ * @brief Returns a value as an integer.
+ *
+ * @param value The value (NULL is allowed).
+ * @param fallback The result when the value is not a number.
+ * @return The number, truncated to an integer, or `fallback`.
+ */
+long json_integer(const struct JsonValue* value, long fallback);
+
+
+
+/**
+ * @brief Returns the text of a string value.
+ *
+ * @param value The value (NULL is allowed).
+ * @return The text, or NULL when the value is not a string.
+ */
+const char* json_text(const struct JsonValue* value);
+
+
+
+/**
+ * @brief Appends a string to a buffer as a JSON string literal, with its quotes.
+ *
+ * @param buffer The buffer to append to.
+ * @param text The string.
+ * @param length The length of the string in bytes.
+ */
+void json_append_string(struct TextBuffer* buffer, const char* text, size_t length);
+
+
+
+/**
+ * @brief Appends a value to a buffer as JSON text.
+ *
+ * @param buffer The buffer to append to.
+ * @param value The value (NULL is written as null).
+ */
+void json_append_value(struct TextBuffer* buffer, const struct JsonValue* value);
+
+#endif /* JSON_VALUE_H */
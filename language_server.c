@@ -0,0 +1,1549 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include "language_server.h"
+#include "json_value.h"
+#include "first_path.h"
+#include "second_path.h"
+
+#define SEVERITY_ERROR 1 /* The LSP severities of the "Error" and " Attention" messages */
+#define SEVERITY_WARNING 2
+#define JSONRPC_PARSE_ERROR -32700
+#define JSONRPC_METHOD_NOT_FOUND -32601
+
+
+/**
+ * @brief A message of the assembler about a line of a document.
+ * @struct Diagnostic
+ * @param phase The phase that reported the message (0 for the pre-assembler to LSP_PHASE_COUNT - 1).
+ * @param severity SEVERITY_ERROR or SEVERITY_WARNING.
+ * @param message The text of the message, without its "Error - line N:" prefix.
+ * @param next The next message of the same line.
+ */
+struct Diagnostic {
+   int phase;
+   int severity;
+   char* message;
+   struct Diagnostic* next;
+};
+
+
+
+/**
+ * @brief A line of an open document.
+ * @struct DocumentLine
+ * @param text The characters of the line, without its newline (null-terminated).
+ * @param length The number of characters of the line.
+ * @param in_macro TRUE if the line is part of a macro definition, from "mcro" to "mcroend".
+ * @param dirty TRUE if the line changed since it was last assembled.
+ * @param phases The number of phases whose messages about the line are known.
+ * @param diagnostics The messages about the line, in the order they were reported.
+ */
+struct DocumentLine {
+   char* text;
+   int length;
+   int in_macro;
+   int dirty;
+   int phases;
+   struct Diagnostic* diagnostics;
+};
+
+
+
+/**
+ * @brief A name defined in a document, as found by the last full assembly.
+ * @struct KnownName
+ * @param name The name (null-terminated).
+ * @param kind The SYMBOL_CODE, SYMBOL_DATA, SYMBOL_ENTRY and SYMBOL_EXTERNAL bits of a symbol (0 for a macro).
+ * @param definitions The number of lines of the document that define the symbol as a label (a line of a
+ *                    macro body counts twice, as the macro can be expanded more than once).
+ */
+struct KnownName {
+   const char* name;
+   int kind;
+   int definitions;
+};
+
+
+
+/**
+ * @brief A document known to the server.
+ * @struct Document
+ * @param uri The URI of the document, as sent by the client.
+ * @param open TRUE while the document is open (a closed document keeps its slot for when it is opened again).
+ * @param lines The lines of the document.
+ * @param line_count The number of lines (an empty document has one empty line).
+ * @param line_capacity The allocated size of `lines`.
+ * @param errors The number of errors of every phase, in the lines and the global messages.
+ * @param globals The messages that are not about a line ("Error: ..."), from the last full assembly.
+ * @param names The memory of the symbol and macro names.
+ * @param symbols The symbols of the last full assembly.
+ * @param symbol_count The number of symbols.
+ * @param symbol_index The index of `symbols` by name.
+ * @param macros The macros of the last full assembly.
+ * @param macro_count The number of macros.
+ * @param macro_index The index of `macros` by name.
+ */
+struct Document {
+   char* uri;
+   int open;
+   struct DocumentLine* lines;
+   int line_count, line_capacity;
+   int errors[LSP_PHASE_COUNT];
+   struct Diagnostic* globals;
+   struct Arena names;
+   struct KnownName* symbols;
+   int symbol_count;
+   struct HashIndex symbol_index;
+   struct KnownName* macros;
+   int macro_count;
+   struct HashIndex macro_index;
+};
+
+
+
+/**
+ * @brief A line given to the assembler, and the line of the document its messages belong to.
+ * @struct RunLine
+ * @param text The characters of the line, without its newline.
+ * @param length The number of characters of the line.
+ * @param target The index of the line in the document, or NO for a line that is not in the document.
+ */
+struct RunLine {
+   const char* text;
+   int length;
+   int target;
+};
+
+
+
+/**
+ * @brief The lines of a single assembly of a document, for finding the line of every message.
+ * @struct Run
+ * @param doc The document.
+ * @param lines The assembled lines.
+ * @param count The number of lines.
+ * @param source The lines joined into a source, each with its newline.
+ * @param size The length of the source.
+ * @param starts The position of every line in the source.
+ * @param pre_lines The lines that the pre-assembler numbers (not empty and not a comment), in order.
+ * @param pre_count The number of lines in `pre_lines`.
+ * @param full TRUE if all the lines of the document are assembled.
+ */
+struct Run {
+   struct Document* doc;
+   const struct RunLine* lines;
+   int count;
+   const char* source;
+   size_t size;
+   size_t* starts;
+   int* pre_lines;
+   int pre_count;
+   int full;
+};
+
+
+
+/**
+ * @brief The state of the server.
+ * @struct LanguageServer
+ * @param in The stream of the messages of the client.
+ * @param out The stream of the responses and notifications.
+ * @param documents The documents, in the order they were first opened.
+ * @param document_count The number of documents.
+ * @param document_capacity The allocated size of `documents`.
+ * @param document_index The index of `documents` by URI.
+ * @param message The body of the current message.
+ * @param values The memory of the parsed message, released after every message.
+ * @param reply The message being written to the client.
+ * @param scratch A buffer for the text of an edit.
+ * @param before The definitions of the lines an edit replaces (see append_signature).
+ * @param after The definitions of the lines that replace them.
+ * @param shutdown TRUE once the client sent the shutdown request.
+ */
+struct LanguageServer {
+   FILE* in, * out;
+   struct Document** documents;
+   int document_count, document_capacity;
+   struct HashIndex document_index;
+   struct TextBuffer message;
+   struct Arena values;
+   struct TextBuffer reply;
+   struct TextBuffer scratch;
+   struct TextBuffer before, after;
+   int shutdown;
+};
+
+
+
+/**
+ * @brief Allocates or grows a block of memory, exiting the program if memory is exhausted.
+ *
+ * @param block The block to grow, or NULL.
+ * @param size The new size of the block.
+ * @return The block.
+ */
+static void* reallocate(void* block, size_t size);
+
+
+
+/**
+ * @brief Returns the name of a known symbol or macro, for the indexes of a document.
+ *
+ * @param table The names (struct KnownName).
+ * @param id The index of the name.
+ * @return The name.
+ */
+static const char* known_name_key(const void* table, int id);
+
+
+
+/**
+ * @brief Returns the URI of a document, for the index of the documents.
+ *
+ * @param table The documents (pointers to struct Document).
+ * @param id The index of the document.
+ * @return The URI of the document.
+ */
+static const char* document_uri(const void* table, int id);
+
+
+
+/**
+ * @brief Appends a null-terminated string to a buffer.
+ *
+ * @param buffer The buffer to append to.
+ * @param text The string.
+ */
+static void append_string(struct TextBuffer* buffer, const char* text);
+
+
+
+/**
+ * @brief Appends a number in decimal to a buffer.
+ *
+ * @param buffer The buffer to append to.
+ * @param number The number.
+ */
+static void append_number(struct TextBuffer* buffer, long number);
+
+
+
+/**
+ * @brief Appends an LSP range within a line to a buffer.
+ *
+ * @param buffer The buffer to append to.
+ * @param line The line.
+ * @param start The first character of the range.
+ * @param end The character after the range.
+ */
+static void append_range(struct TextBuffer* buffer, int line, int start, int end);
+
+
+
+/**
+ * @brief Reads the next message of the client into the message buffer of the server.
+ *
+ * @param server The state of the server.
+ * @return TRUE if a message was read, FALSE at the end of the input.
+ */
+static int read_message(struct LanguageServer* server);
+
+
+
+/**
+ * @brief Writes the reply buffer of the server to the client as a message.
+ *
+ * @param server The state of the server.
+ */
+static void send_reply(struct LanguageServer* server);
+
+
+
+/**
+ * @brief Starts a response in the reply buffer, up to its result.
+ *
+ * @param server The state of the server.
+ * @param id The id of the request.
+ */
+static void begin_response(struct LanguageServer* server, const struct JsonValue* id);
+
+
+
+/**
+ * @brief Sends an error response.
+ *
+ * @param server The state of the server.
+ * @param id The id of the request (NULL if it is not known).
+ * @param code The JSON-RPC error code.
+ * @param message The description of the error.
+ */
+static void send_error(struct LanguageServer* server, const struct JsonValue* id, int code, const char* message);
+
+
+
+/**
+ * @brief Handles a message of the client.
+ *
+ * @param server The state of the server.
+ * @param root The parsed message.
+ * @return FALSE for the exit notification, TRUE otherwise.
+ */
+static int handle_message(struct LanguageServer* server, const struct JsonValue* root);
+
+
+
+/**
+ * @brief Finds a document by its URI.
+ *
+ * @param server The state of the server.
+ * @param uri The URI (NULL is allowed).
+ * @return The document, or NULL if it is not known or not open.
+ */
+static struct Document* find_document(struct LanguageServer* server, const char* uri);
+
+
+
+/**
+ * @brief Opens a document with its text and assembles it.
+ *
+ * @param server The state of the server.
+ * @param uri The URI of the document.
+ * @param text The text of the document.
+ * @param length The length of the text.
+ * @return The document.
+ */
+static struct Document* open_document(struct LanguageServer* server, const char* uri, const char* text, size_t length);
+
+
+
+/**
+ * @brief Frees the lines, messages and names of a document, and marks it closed.
+ *
+ * @param doc The document.
+ */
+static void release_document(struct Document* doc);
+
+
+
+/**
+ * @brief Inserts the lines of a text into a document, as changed lines.
+ *
+ * @param doc The document.
+ * @param at The index of the first inserted line.
+ * @param text The text, split at its newlines (it always makes at least one line).
+ * @param length The length of the text.
+ */
+static void insert_lines(struct Document* doc, int at, const char* text, size_t length);
+
+
+
+/**
+ * @brief Removes lines from a document.
+ *
+ * @param doc The document.
+ * @param at The index of the first removed line.
+ * @param count The number of lines to remove.
+ */
+static void remove_lines(struct Document* doc, int at, int count);
+
+
+
+/**
+ * @brief Adds a message to the end of a list of messages.
+ *
+ * @param doc The document the message is about (its error counts are updated).
+ * @param list The list.
+ * @param phase The phase that reported the message.
+ * @param severity The severity of the message.
+ * @param message The text of the message.
+ * @param length The length of the text.
+ */
+static void add_diagnostic(struct Document* doc, struct Diagnostic** list, int phase, int severity, const char* message, size_t length);
+
+
+
+/**
+ * @brief Frees a list of messages.
+ *
+ * @param doc The document the messages are about (its error counts are updated).
+ * @param list The list, emptied.
+ */
+static void clear_diagnostics(struct Document* doc, struct Diagnostic** list);
+
+
+
+/**
+ * @brief Finds the next symbol name in a line: a word that starts with a letter, outside of strings,
+ *        comments and directive names.
+ *
+ * @param text The line.
+ * @param length The length of the line.
+ * @param pos The position to search from (0 for the start of the line), moved after the name.
+ * @param start Pointer to store the position of the name.
+ * @return The length of the name, or 0 if there are no more names.
+ */
+static int next_name(const char* text, int length, int* pos, int* start);
+
+
+
+/**
+ * @brief Checks if a name in a line is defined there: a label, a macro or an external symbol.
+ *
+ * @param text The line.
+ * @param length The length of the line.
+ * @param start The position of the name.
+ * @param name_length The length of the name.
+ * @return TRUE if the line defines the name, FALSE otherwise.
+ */
+static int is_definition(const char* text, int length, int start, int name_length);
+
+
+
+/**
+ * @brief Finds the label defined at the start of a line ("NAME: ").
+ *
+ * @param text The line.
+ * @param length The length of the line.
+ * @param start Pointer to store the position of the label.
+ * @return The length of the label, or 0 if the line does not start with a label.
+ */
+static int label_length(const char* text, int length, int* start);
+
+
+
+/**
+ * @brief Appends what a line defines to a signature, so an edit that keeps the signature of its lines
+ *        can be assembled alone.
+ *
+ * A label line adds its label and whether it is a code or a data label. A line that cannot be checked
+ * that way (a macro definition or invocation, a .entry or .extern directive, a label that is not
+ * defined exactly once, or a ':' that is not a label) needs a full assembly.
+ *
+ * @param doc The document (for its symbols and macro names).
+ * @param text The line.
+ * @param length The length of the line.
+ * @param signature The signature to append to.
+ * @return TRUE if the line was added to the signature, FALSE if the line needs a full assembly.
+ */
+static int append_signature(const struct Document* doc, const char* text, int length, struct TextBuffer* signature);
+
+
+
+/**
+ * @brief Counts the lines that define every symbol of a document as a label.
+ *
+ * @param doc The document, after a full assembly.
+ */
+static void count_definitions(struct Document* doc);
+
+
+
+/**
+ * @brief Applies a change of the client to a document.
+ *
+ * @param server The state of the server.
+ * @param doc The document.
+ * @param change The change: a range and its new text, or only the new text of the whole document.
+ * @return TRUE if the change needs a full assembly, FALSE if the changed lines can be assembled alone.
+ */
+static int apply_change(struct LanguageServer* server, struct Document* doc, const struct JsonValue* change);
+
+
+
+/**
+ * @brief Finds the line of the document that a message of the assembler is about.
+ *
+ * @param run The assembled lines.
+ * @param ctx The context of the assembly.
+ * @param phase The phase that reported the message.
+ * @param number The line number in the message.
+ * @return The index of the line in the document, or NO if the line is not in the document.
+ */
+static int find_target(const struct Run* run, const struct AssemblerContext* ctx, int phase, long number);
+
+
+
+/**
+ * @brief Adds the messages reported by a phase to the lines they are about.
+ *
+ * @param run The assembled lines.
+ * @param ctx The context of the assembly.
+ * @param from The position of the first message of the phase in the diagnostics of the context.
+ * @param phase The phase.
+ */
+static void collect_messages(const struct Run* run, const struct AssemblerContext* ctx, size_t from, int phase);
+
+
+
+/**
+ * @brief Assembles lines of a document and adds the messages to them, phase after phase, until a phase fails.
+ *
+ * @param doc The document.
+ * @param lines The lines to assemble.
+ * @param count The number of lines.
+ * @param full TRUE if the lines are the whole document (the symbols and macros are kept, and the global messages).
+ * @return The number of phases that ran.
+ */
+static int run_lines(struct Document* doc, const struct RunLine* lines, int count, int full);
+
+
+
+/**
+ * @brief Keeps the symbol and macro names found by a full assembly in a document.
+ *
+ * @param doc The document.
+ * @param ctx The context of the assembly.
+ */
+static void keep_names(struct Document* doc, const struct AssemblerContext* ctx);
+
+
+
+/**
+ * @brief Marks the lines of a document that are part of a macro definition.
+ *
+ * @param doc The document.
+ */
+static void mark_macro_lines(struct Document* doc);
+
+
+
+/**
+ * @brief Assembles a whole document, replacing all its messages.
+ *
+ * @param doc The document.
+ */
+static void full_run(struct Document* doc);
+
+
+
+/**
+ * @brief Assembles the changed lines of a document, after a declaration of every known symbol they use.
+ *
+ * @param doc The document.
+ */
+static void changed_lines_run(struct Document* doc);
+
+
+
+/**
+ * @brief Returns the last phase whose messages are published: the first phase with errors, or the last phase.
+ *
+ * @param doc The document.
+ * @return The phase.
+ */
+static int published_phase(const struct Document* doc);
+
+
+
+/**
+ * @brief Brings the messages of a document up to date after its changes.
+ *
+ * @param doc The document.
+ * @param structural TRUE if the changes need a full assembly.
+ */
+static void validate(struct Document* doc, int structural);
+
+
+
+/**
+ * @brief Sends the messages of a document to the client.
+ *
+ * @param server The state of the server.
+ * @param doc The document (a closed document has no messages).
+ */
+static void publish_diagnostics(struct LanguageServer* server, const struct Document* doc);
+
+
+
+/**
+ * @brief Answers a definition or references request: the places of the name at a position.
+ *
+ * @param server The state of the server.
+ * @param id The id of the request.
+ * @param params The parameters of the request.
+ * @param references TRUE for the references of the name, FALSE for its definitions.
+ */
+static void find_name(struct LanguageServer* server, const struct JsonValue* id, const struct JsonValue* params, int references);
+
+
+
+
+static void* reallocate(void* block, size_t size) {
+   block = realloc(block, size > 0 ? size : 1);
+   if (block == NULL) {
+      perror("Error allocating memory for the language server");
+      exit(EXIT_FAILURE);
+   }
+   return block;
+}
+
+
+
+
+static const char* known_name_key(const void* table, int id) {
+   return ((const struct KnownName*)table)[id].name;
+}
+
+
+
+
+static const char* document_uri(const void* table, int id) {
+   return ((struct Document* const*)table)[id]->uri;
+}
+
+
+
+
+static void append_string(struct TextBuffer* buffer, const char* text) {
+   append_text(buffer, text, strlen(text));
+}
+
+
+
+
+static void append_number(struct TextBuffer* buffer, long number) {
+   char digits[32]; /* The number in decimal */
+
+   sprintf(digits, "%ld", number);
+   append_string(buffer, digits);
+}
+
+
+
+
+static void append_range(struct TextBuffer* buffer, int line, int start, int end) {
+   append_string(buffer, "{\"start\":{\"line\":");
+   append_number(buffer, line);
+   append_string(buffer, ",\"character\":");
+   append_number(buffer, start);
+   append_string(buffer, "},\"end\":{\"line\":");
+   append_number(buffer, line);
+   append_string(buffer, ",\"character\":");
+   append_number(buffer, end);
+   append_string(buffer, "}}");
+}
+
+
+
+
+static int read_message(struct LanguageServer* server) {
+   char header[LSP_MAX_HEADER]; /* A header line */
+   char chunk[4096]; /* A block of the body */
+   long length = NO; /* The length of the body, from its Content-Length header */
+   size_t n; /* The size of a block */
+
+   for (;;) {
+      if (fgets(header, sizeof(header), server->in) == NULL)
+         return FALSE;
+      if (strncmp(header, "Content-Length:", 15) == 0)
+         length = strtol(header + 15, NULL, 10);
+      else if (strcmp(header, "\r\n") == 0 || strcmp(header, "\n") == 0) { /* The end of the headers */
+         if (length >= 0)
+            break;
+      }
+   }
+
+   server->message.size = 0;
+   append_text(&server->message, "", 0);
+   while (length > 0) {
+      n = fread(chunk, 1, length < (long)sizeof(chunk) ? (size_t)length : sizeof(chunk), server->in);
+      if (n == 0)
+         return FALSE;
+      append_text(&server->message, chunk, n);
+      length -= (long)n;
+   }
+   return TRUE;
+}
+
+
+
+
+static void send_reply(struct LanguageServer* server) {
+   fprintf(server->out, "Content-Length: %lu\r\n\r\n", (unsigned long)server->reply.size);
+   fwrite(server->reply.text, 1, server->reply.size, server->out);
+   fflush(server->out);
+}
+
+
+
+
+static void begin_response(struct LanguageServer* server, const struct JsonValue* id) {
+   server->reply.size = 0;
+   append_string(&server->reply, "{\"jsonrpc\":\"2.0\",\"id\":");
+   json_append_value(&server->reply, id);
+   append_string(&server->reply, ",\"result\":");
+}
+
+
+
+
+static void send_error(struct LanguageServer* server, const struct JsonValue* id, int code, const char* message) {
+   server->reply.size = 0;
+   append_string(&server->reply, "{\"jsonrpc\":\"2.0\",\"id\":");
+   json_append_value(&server->reply, id);
+   append_string(&server->reply, ",\"error\":{\"code\":");
+   append_number(&server->reply, code);
+   append_string(&server->reply, ",\"message\":");
+   json_append_string(&server->reply, message, strlen(message));
+   append_string(&server->reply, "}}");
+   send_reply(server);
+}
+
+
+
+
+static int handle_message(struct LanguageServer* server, const struct JsonValue* root) {
+   const char* method = json_text(json_find(root, "method")); /* The method, NULL for a response of the client */
+   const struct JsonValue* id = json_find(root, "id"), * params = json_find(root, "params"); /* NULL for a notification */
+   const struct JsonValue* text, * change; /* The text of an opened document, and a change of a document */
+   struct Document* doc; /* The document of the message */
+   int structural; /* TRUE if the changes need a full assembly */
+
+   if (method == NULL)
+      return TRUE;
+
+   if (strcmp(method, "initialize") == 0) {
+      begin_response(server, id);
+      append_string(&server->reply, "{\"capabilities\":{\"textDocumentSync\":{\"openClose\":true,\"change\":2},"
+                                    "\"definitionProvider\":true,\"referencesProvider\":true},"
+                                    "\"serverInfo\":{\"name\":\"myassem\",\"version\":\"" ASSEMBLER_VERSION "\"}}}");
+      send_reply(server);
+   }
+   else if (strcmp(method, "shutdown") == 0) {
+      server->shutdown = TRUE;
+      begin_response(server, id);
+      append_string(&server->reply, "null}");
+      send_reply(server);
+   }
+   else if (strcmp(method, "exit") == 0) {
+      return FALSE;
+   }
+   else if (strcmp(method, "textDocument/didOpen") == 0) {
+      text = json_find(params, "textDocument.text");
+      if (json_text(json_find(params, "textDocument.uri")) != NULL && json_text(text) != NULL) {
+         doc = open_document(server, json_text(json_find(params, "textDocument.uri")), text->text, text->length);
+         publish_diagnostics(server, doc);
+      }
+   }
+   else if (strcmp(method, "textDocument/didChange") == 0) {
+      doc = find_document(server, json_text(json_find(params, "textDocument.uri")));
+      if (doc != NULL) {
+         structural = FALSE;
+         change = json_find(params, "contentChanges");
+         for (change = change != NULL ? change->children : NULL; change != NULL; change = change->next)
+            structural |= apply_change(server, doc, change);
+         validate(doc, structural);
+         publish_diagnostics(server, doc);
+      }
+   }
+   else if (strcmp(method, "textDocument/didClose") == 0) {
+      doc = find_document(server, json_text(json_find(params, "textDocument.uri")));
+      if (doc != NULL) {
+         release_document(doc);
+         publish_diagnostics(server, doc); /* Clear the messages of the document in the editor */
+      }
+   }
+   else if (strcmp(method, "textDocument/definition") == 0) {
+      find_name(server, id, params, FALSE);
+   }
+   else if (strcmp(method, "textDocument/references") == 0) {
+      find_name(server, id, params, TRUE);
+   }
+   else if (id != NULL) { /* Notifications that are not handled are ignored */
+      send_error(server, id, JSONRPC_METHOD_NOT_FOUND, "Method not found");
+   }
+   return TRUE;
+}
+
+
+
+
+static struct Document* find_document(struct LanguageServer* server, const char* uri) {
+   int id; /* Index of the document */
+
+   if (uri == NULL)
+      return NULL;
+   id = hash_index_find(&server->document_index, uri, strlen(uri), document_uri, server->documents);
+   return id != NO && server->documents[id]->open ? server->documents[id] : NULL;
+}
+
+
+
+
+static struct Document* open_document(struct LanguageServer* server, const char* uri, const char* text, size_t length) {
+   struct Document* doc; /* The document */
+   int id; /* Index of the document */
+
+   id = hash_index_find(&server->document_index, uri, strlen(uri), document_uri, server->documents);
+   if (id != NO) {
+      doc = server->documents[id];
+      release_document(doc); /* Opened again without being closed: start over */
+   }
+   else {
+      if (server->document_count == server->document_capacity) { /* Double the table */
+         server->document_capacity = server->document_capacity > 0 ? server->document_capacity * 2 : INITIAL_DOCUMENT_TABLE_SIZE;
+         server->documents = (struct Document**)reallocate(server->documents, server->document_capacity * sizeof(struct Document*));
+      }
+      doc = (struct Document*)reallocate(NULL, sizeof(struct Document));
+      memset(doc, 0, sizeof(*doc));
+      doc->uri = (char*)reallocate(NULL, strlen(uri) + 1);
+      strcpy(doc->uri, uri);
+      server->documents[server->document_count] = doc;
+      hash_index_insert(&server->document_index, doc->uri, strlen(doc->uri), server->document_count++);
+   }
+
+   doc->open = TRUE;
+   insert_lines(doc, 0, text, length);
+   full_run(doc);
+   return doc;
+}
+
+
+
+
+static void release_document(struct Document* doc) {
+   remove_lines(doc, 0, doc->line_count);
+   clear_diagnostics(doc, &doc->globals);
+   free(doc->lines);
+   doc->lines = NULL;
+   doc->line_capacity = 0;
+
+   free_arena(&doc->names);
+   free_hash_index(&doc->symbol_index);
+   free_hash_index(&doc->macro_index);
+   doc->symbols = doc->macros = NULL;
+   doc->symbol_count = doc->macro_count = 0;
+   doc->open = FALSE;
+}
+
+
+
+
+static void insert_lines(struct Document* doc, int at, const char* text, size_t length) {
+   const char* end = text + length, * newline; /* The end of the text, and the newline of the current line */
+   struct DocumentLine* line; /* An inserted line */
+   int count, i; /* Number of inserted lines, loop index */
+   size_t n; /* Length of a line */
+
+   for (count = 1, newline = text; (newline = (const char*)memchr(newline, '\n', end - newline)) != NULL; newline++)
+      count++;
+
+   if (doc->line_count + count > doc->line_capacity) { /* Grow the table */
+      if (doc->line_capacity == 0)
+         doc->line_capacity = INITIAL_DOCUMENT_LINES;
+      while (doc->line_count + count > doc->line_capacity)
+         doc->line_capacity *= 2;
+      doc->lines = (struct DocumentLine*)reallocate(doc->lines, doc->line_capacity * sizeof(struct DocumentLine));
+   }
+   if (at < doc->line_count)
+      memmove(doc->lines + at + count, doc->lines + at, (doc->line_count - at) * sizeof(struct DocumentLine));
+   doc->line_count += count;
+
+   for (i = 0; i < count; i++) {
+      newline = (const char*)memchr(text, '\n', end - text);
+      n = newline != NULL ? (size_t)(newline - text) : (size_t)(end - text);
+
+      line = &doc->lines[at + i];
+      memset(line, 0, sizeof(*line));
+      line->text = (char*)reallocate(NULL, n + 1);
+      memcpy(line->text, text, n);
+      line->text[n] = '\0';
+      line->length = (int)n;
+      line->dirty = TRUE;
+      text += n + 1;
+   }
+}
+
+
+
+
+static void remove_lines(struct Document* doc, int at, int count) {
+   int i;
+
+   for (i = at; i < at + count; i++) {
+      clear_diagnostics(doc, &doc->lines[i].diagnostics);
+      free(doc->lines[i].text);
+   }
+   if (at + count < doc->line_count)
+      memmove(doc->lines + at, doc->lines + at + count, (doc->line_count - at - count) * sizeof(struct DocumentLine));
+   doc->line_count -= count;
+}
+
+
+
+
+static void add_diagnostic(struct Document* doc, struct Diagnostic** list, int phase, int severity, const char* message, size_t length) {
+   struct Diagnostic* diagnostic; /* The new message */
+
+   diagnostic = (struct Diagnostic*)reallocate(NULL, sizeof(struct Diagnostic));
+   diagnostic->phase = phase;
+   diagnostic->severity = severity;
+   diagnostic->message = (char*)reallocate(NULL, length + 1);
+   memcpy(diagnostic->message, message, length);
+   diagnostic->message[length] = '\0';
+   diagnostic->next = NULL;
+
+   while (*list != NULL)
+      list = &(*list)->next;
+   *list = diagnostic;
+   if (severity == SEVERITY_ERROR)
+      doc->errors[phase]++;
+}
+
+
+
+
+static void clear_diagnostics(struct Document* doc, struct Diagnostic** list) {
+   struct Diagnostic* diagnostic, * next; /* The current message and the one after it */
+
+   for (diagnostic = *list; diagnostic != NULL; diagnostic = next) {
+      next = diagnostic->next;
+      if (diagnostic->severity == SEVERITY_ERROR)
+         doc->errors[diagnostic->phase]--;
+      free(diagnostic->message);
+      free(diagnostic);
+   }
+   *list = NULL;
+}
+
+
+
+
+static int next_name(const char* text, int length, int* pos, int* start) {
+   int i = *pos; /* The current character */
+
+   if (i == 0 && length > 0 && text[0] == ';') /* A comment line */
+      return 0;
+
+   while (i < length) {
+      if (text[i] == '"') { /* Skip a string */
+         for (i++; i < length && text[i] != '"'; i++)
+            ;
+         i++;
+         continue;
+      }
+      if (!isalnum((unsigned char)text[i])) {
+         i++;
+         continue;
+      }
+
+      *start = i;
+      while (i < length && isalnum((unsigned char)text[i]))
+         i++;
+      if (isalpha((unsigned char)text[*start]) && (*start == 0 || text[*start - 1] != '.')) { /* Not a number or a directive */
+         *pos = i;
+         return i - *start;
+      }
+   }
+   *pos = i;
+   return 0;
+}
+
+
+
+
+static int is_definition(const char* text, int length, int start, int name_length) {
+   int first = 0; /* The first character of the line that is not a space */
+
+   if (label_length(text, length, &first) == name_length && first == start) /* LABEL: */
+      return TRUE;
+
+   for (first = 0; first < length && isspace((unsigned char)text[first]); first++)
+      ;
+   if (strncmp(text + first, "mcro", MCRO_LENGTH) == 0 && isspace((unsigned char)text[first + MCRO_LENGTH]) &&
+       start > first + MCRO_LENGTH) /* mcro NAME */
+      return TRUE;
+   return strncmp(text + first, ".extern", 7) == 0 && start > first; /* .extern NAME */
+}
+
+
+
+
+static int label_length(const char* text, int length, int* start) {
+   int i; /* The current character */
+
+   for (i = 0; i < length && isspace((unsigned char)text[i]); i++)
+      ;
+   if (i == length || !isalpha((unsigned char)text[i]))
+      return 0;
+   for (*start = i; i < length && isalnum((unsigned char)text[i]); i++)
+      ;
+   return i + 1 < length && text[i] == ':' && text[i + 1] == ' ' ? i - *start : 0; /* As the first path reads a label */
+}
+
+
+
+
+static int append_signature(const struct Document* doc, const char* text, int length, struct TextBuffer* signature) {
+   char word[MAX_SYMBOL_NAME + 1]; /* The word after the label */
+   int i = 0, start, label, id, n; /* The current character, the label and its symbol, length of the word */
+   int kind, index; /* The class of the word after the label (classify_word) and its index */
+
+   if (length == 0 || text[0] == ';') /* Skipped by the pre-assembler */
+      return TRUE;
+
+   if ((label = label_length(text, length, &start)) > 0) {
+      id = hash_index_find(&doc->symbol_index, text + start, label, known_name_key, doc->symbols);
+      if (id == NO || doc->symbols[id].definitions != 1)
+         return FALSE;
+
+      /* The word after the label decides the kind of the symbol, as in the first path */
+      for (i = start + label + 1; i < length && isspace((unsigned char)text[i]); i++)
+         ;
+      for (n = 0; i < length && n < MAX_SYMBOL_NAME && !isspace((unsigned char)text[i]) && text[i] != ':' && text[i] != ','; i++)
+         word[n++] = text[i];
+      word[n] = '\0';
+      kind = classify_word(word, &index);
+      if (kind != WORD_COMMAND && !(kind == WORD_DIRECTIVE && (index == DIRECTIVE_DATA || index == DIRECTIVE_STRING)))
+         return FALSE; /* .entry, .extern or not a valid line: the symbol may not be added */
+
+      append_text(signature, text + start, label);
+      append_string(signature, kind == WORD_DIRECTIVE ? ":d\n" : ":c\n");
+   }
+
+   for (; i < length; i++) {
+      if (text[i] == '"') { /* Skip a string */
+         for (i++; i < length && text[i] != '"'; i++)
+            ;
+         continue;
+      }
+      if (text[i] == ':')
+         return FALSE;
+      if (text[i] == '.' && ((length - i >= 6 && strncmp(text + i, ".entry", 6) == 0) ||
+                             (length - i >= 7 && strncmp(text + i, ".extern", 7) == 0)))
+         return FALSE;
+      if (!isalnum((unsigned char)text[i]))
+         continue;
+
+      for (start = i; i < length && isalnum((unsigned char)text[i]); i++)
+         ;
+      if (i - start >= MCRO_LENGTH && strncmp(text + start, "mcro", MCRO_LENGTH) == 0) /* mcro or mcroend */
+         return FALSE;
+      if (hash_index_find(&doc->macro_index, text + start, i - start, known_name_key, doc->macros) != NO)
+         return FALSE; /* A macro invocation */
+      i--;
+   }
+   return TRUE;
+}
+
+
+
+
+static void count_definitions(struct Document* doc) {
+   int i, start, label, id; /* Loop index, the label of a line and its symbol */
+
+   for (i = 0; i < doc->line_count; i++) {
+      if ((label = label_length(doc->lines[i].text, doc->lines[i].length, &start)) == 0)
+         continue;
+      id = hash_index_find(&doc->symbol_index, doc->lines[i].text + start, label, known_name_key, doc->symbols);
+      if (id != NO)
+         doc->symbols[id].definitions += doc->lines[i].in_macro ? 2 : 1;
+   }
+}
+
+
+
+
+static int apply_change(struct LanguageServer* server, struct Document* doc, const struct JsonValue* change) {
+   const struct JsonValue* range = json_find(change, "range"), * text = json_find(change, "text"); /* The changed range and its new text */
+   long first, first_char, last, last_char; /* The start and end of the range */
+   int structural = FALSE, i; /* TRUE if the change needs a full assembly, loop index */
+   const char* p, * end, * newline; /* A new line, the end of the new lines and the end of the line */
+
+   if (json_text(text) == NULL)
+      return FALSE;
+   if (range == NULL) { /* The whole text of the document */
+      remove_lines(doc, 0, doc->line_count);
+      insert_lines(doc, 0, text->text, text->length);
+      return TRUE;
+   }
+
+   /* Keep the range inside the document */
+   first = json_integer(json_find(range, "start.line"), 0);
+   first = first < 0 ? 0 : (first >= doc->line_count ? doc->line_count - 1 : first);
+   first_char = json_integer(json_find(range, "start.character"), 0);
+   first_char = first_char < 0 ? 0 : (first_char > doc->lines[first].length ? doc->lines[first].length : first_char);
+   last = json_integer(json_find(range, "end.line"), first);
+   last = last < first ? first : (last >= doc->line_count ? doc->line_count - 1 : last);
+   last_char = json_integer(json_find(range, "end.character"), 0);
+   last_char = last_char < 0 ? 0 : (last_char > doc->lines[last].length ? doc->lines[last].length : last_char);
+   if (last == first && last_char < first_char)
+      last_char = first_char;
+
+   /* A line of a macro body, or a line added right after one, changes the macro */
+   if (first > 0 && doc->lines[first - 1].in_macro)
+      structural = TRUE;
+   server->before.size = 0;
+   for (i = (int)first; i <= last && !structural; i++)
+      structural = doc->lines[i].in_macro || !append_signature(doc, doc->lines[i].text, doc->lines[i].length, &server->before);
+
+   /* The new lines: the start of the first line, the new text and the end of the last line */
+   server->scratch.size = 0;
+   append_text(&server->scratch, doc->lines[first].text, first_char);
+   append_text(&server->scratch, text->text, text->length);
+   append_text(&server->scratch, doc->lines[last].text + last_char, doc->lines[last].length - last_char);
+
+   /* The edit can be assembled alone if the new lines define the same labels as the old ones */
+   server->after.size = 0;
+   for (p = server->scratch.text, end = p + server->scratch.size; !structural; p = newline + 1) {
+      newline = (const char*)memchr(p, '\n', end - p);
+      if (newline == NULL)
+         newline = end;
+      structural = !append_signature(doc, p, (int)(newline - p), &server->after);
+      if (newline == end)
+         break;
+   }
+   if (!structural)
+      structural = server->before.size != server->after.size ||
+                   (server->before.size > 0 && memcmp(server->before.text, server->after.text, server->before.size) != 0);
+
+   remove_lines(doc, (int)first, (int)(last - first + 1));
+   insert_lines(doc, (int)first, server->scratch.text, server->scratch.size);
+   return structural;
+}
+
+
+
+
+static int find_target(const struct Run* run, const struct AssemblerContext* ctx, int phase, long number) {
+   size_t offset; /* Position of the line of the message in the source */
+   int low, high, middle; /* Binary search over the positions of the lines */
+
+   if (number < 1)
+      return NO;
+   if (phase == 0) /* The pre-assembler numbers the lines that are not empty or comments */
+      return number <= run->pre_count ? run->lines[run->pre_lines[number - 1]].target : NO;
+
+   /* The first and second paths number the lines of the expanded source, which point into the source */
+   if (number > ctx->line_count || ctx->lines[number - 1].text < run->source || ctx->lines[number - 1].text >= run->source + run->size)
+      return NO;
+   offset = (size_t)(ctx->lines[number - 1].text - run->source);
+   for (low = 0, high = run->count - 1; low < high;) {
+      middle = (low + high + 1) / 2;
+      if (run->starts[middle] <= offset)
+         low = middle;
+      else
+         high = middle - 1;
+   }
+   return run->lines[low].target;
+}
+
+
+
+
+static void collect_messages(const struct Run* run, const struct AssemblerContext* ctx, size_t from, int phase) {
+   const char* p, * end, * newline, * after; /* The current line of the messages, their end, the end of the line and the text after the prefix */
+   struct TextBuffer message = {0}; /* The text of the current message */
+   int severity = 0, target = NO; /* Severity and line of the current message (0 before the first message) */
+   size_t n; /* Length of a line of the messages */
+   long number; /* The line number in a message */
+
+   if (ctx->diagnostics.size <= from)
+      return;
+
+   p = ctx->diagnostics.text + from;
+   end = ctx->diagnostics.text + ctx->diagnostics.size;
+   for (; p <= end; p = newline < end ? newline + 1 : end) {
+      newline = (const char*)memchr(p, '\n', end - p);
+      if (newline == NULL)
+         newline = end;
+      n = newline - p;
+
+      if (p == end || strncmp(p, "Error - line ", 13) == 0 || strncmp(p, " Attention - line ", 18) == 0 || strncmp(p, "Error: ", 7) == 0) {
+         /* A new message (or the end): add the current one */
+         if (severity != 0 && target != NO)
+            add_diagnostic(run->doc, &run->doc->lines[target].diagnostics, phase, severity, message.text, message.size);
+         else if (severity != 0 && run->full)
+            add_diagnostic(run->doc, &run->doc->globals, phase, severity, message.text, message.size);
+         if (p == end)
+            break;
+
+         severity = p[0] == 'E' ? SEVERITY_ERROR : SEVERITY_WARNING;
+         target = NO;
+         after = p + 7;
+         if (p[5] != ':') { /* A message about a line */
+            number = strtol(p + (severity == SEVERITY_ERROR ? 13 : 18), (char**)&after, 10);
+            target = find_target(run, ctx, phase, number);
+            while (after < newline && (*after == ':' || *after == ' '))
+               after++;
+         }
+         message.size = 0;
+         append_text(&message, after, newline - after);
+      }
+      else if (severity != 0 && n > 0) { /* A line that continues the message */
+         append_text(&message, "\n", 1);
+         append_text(&message, p, n);
+      }
+   }
+   free(message.text);
+}
+
+
+
+
+static int run_lines(struct Document* doc, const struct RunLine* lines, int count, int full) {
+   struct AssemblerContext ctx; /* The context of the assembly */
+   struct TextBuffer source = {0}; /* The lines joined into a source */
+   struct Run run; /* The lines, for finding the line of every message */
+   int i, content, phases, result; /* Loop index, length of a line without a \r, number of phases that ran and their result */
+   size_t from; /* The first message of the current phase */
+
+   run.doc = doc;
+   run.lines = lines;
+   run.count = count;
+   run.full = full;
+   run.starts = (size_t*)reallocate(NULL, (count + 1) * sizeof(size_t));
+   run.pre_lines = (int*)reallocate(NULL, (count + 1) * sizeof(int));
+   run.pre_count = 0;
+
+   for (i = 0; i < count; i++) {
+      run.starts[i] = source.size;
+      append_text(&source, lines[i].text, lines[i].length);
+      if (i < count - 1 || lines[i].target != doc->line_count - 1) /* The last line of the document has no newline */
+         append_text(&source, "\n", 1);
+
+      /* The same lines as the pre-assembler skips */
+      content = lines[i].length;
+      if (content > 0 && lines[i].text[content - 1] == '\r')
+         content--;
+      if (content > 0 && lines[i].text[0] != ';' && lines[i].text[0] != '\0')
+         run.pre_lines[run.pre_count++] = i;
+   }
+   run.source = source.text != NULL ? source.text : "";
+   run.size = source.size;
+
+   init_context(&ctx, doc->uri);
+   ctx.capture_diagnostics = TRUE;
+
+   phases = 1;
+   result = read_row_pre(&ctx, run.source, run.size);
+   collect_messages(&run, &ctx, 0, 0);
+   while (result && phases < LSP_PHASE_COUNT) {
+      from = ctx.diagnostics.size;
+      result = phases == 1 ? first_path(&ctx) : second_path(&ctx);
+      collect_messages(&run, &ctx, from, phases++);
+   }
+
+   if (full)
+      keep_names(doc, &ctx);
+   free_context(&ctx);
+   free(source.text);
+   free(run.starts);
+   free(run.pre_lines);
+   return phases;
+}
+
+
+
+
+static void keep_names(struct Document* doc, const struct AssemblerContext* ctx) {
+   int i;
+
+   free_arena(&doc->names);
+   free_hash_index(&doc->symbol_index);
+   free_hash_index(&doc->macro_index);
+
+   doc->symbol_count = ctx->symbol_count;
+   doc->symbols = (struct KnownName*)arena_alloc(&doc->names, (doc->symbol_count + 1) * sizeof(struct KnownName));
+   for (i = 0; i < doc->symbol_count; i++) {
+      doc->symbols[i].name = arena_strdup(&doc->names, ctx->symbols_table[i].name);
+      doc->symbols[i].kind = ctx->symbols_table[i].kind;
+      hash_index_insert(&doc->symbol_index, doc->symbols[i].name, strlen(doc->symbols[i].name), i);
+   }
+
+   doc->macro_count = ctx->macro_count;
+   doc->macros = (struct KnownName*)arena_alloc(&doc->names, (doc->macro_count + 1) * sizeof(struct KnownName));
+   for (i = 0; i < doc->macro_count; i++) {
+      doc->macros[i].name = arena_strdup(&doc->names, ctx->macro_table[i].name);
+      hash_index_insert(&doc->macro_index, doc->macros[i].name, strlen(doc->macros[i].name), i);
+   }
+}
+
+
+
+
+static void mark_macro_lines(struct Document* doc) {
+   int i, inside = FALSE; /* Loop index, TRUE between a "mcro" line and its "mcroend" */
+   const char* text, * end; /* The line, and the first "mcroend" in it */
+
+   for (i = 0; i < doc->line_count; i++) {
+      text = doc->lines[i].text;
+      if (doc->lines[i].length == 0 || text[0] == ';') { /* Skipped by the pre-assembler */
+         doc->lines[i].in_macro = inside;
+         continue;
+      }
+
+      /* The same tests as the pre-assembler: "mcroend" as a word ends a definition, "mcro " anywhere starts one */
+      if (inside) {
+         doc->lines[i].in_macro = TRUE;
+         end = strstr(text, "mcroend");
+         if (end != NULL && (end == text || isspace((unsigned char)end[-1])) &&
+             (end[MACRO_END_LENGTH] == '\0' || isspace((unsigned char)end[MACRO_END_LENGTH])))
+            inside = FALSE;
+      }
+      else {
+         inside = strstr(text, "mcro ") != NULL; /* A misplaced one is an error: marking it only costs a full run */
+         doc->lines[i].in_macro = inside;
+      }
+   }
+}
+
+
+
+
+static void full_run(struct Document* doc) {
+   struct RunLine* lines; /* All the lines of the document */
+   int i, phases; /* Loop index, number of phases that ran */
+
+   lines = (struct RunLine*)reallocate(NULL, doc->line_count * sizeof(struct RunLine));
+   for (i = 0; i < doc->line_count; i++) {
+      lines[i].text = doc->lines[i].text;
+      lines[i].length = doc->lines[i].length;
+      lines[i].target = i;
+      clear_diagnostics(doc, &doc->lines[i].diagnostics);
+   }
+   clear_diagnostics(doc, &doc->globals);
+
+   phases = run_lines(doc, lines, doc->line_count, TRUE);
+   for (i = 0; i < doc->line_count; i++) {
+      doc->lines[i].phases = phases;
+      doc->lines[i].dirty = FALSE;
+   }
+   mark_macro_lines(doc);
+   count_definitions(doc);
+   free(lines);
+}
+
+
+
+
+static void changed_lines_run(struct Document* doc) {
+   struct RunLine* lines; /* The changed lines, then the declarations */
+   struct TextBuffer declarations = {0}; /* A line for every known symbol the changed lines use */
+   struct HashIndex declared = {0}; /* The symbols declared so far */
+   const struct KnownName* symbol; /* A symbol used by a changed line */
+   int i, count = 0, pos, start, length, id, phases; /* Loop index, number of lines, a name in a line, a symbol, number of phases that ran */
+   const char* p, * end, * newline; /* A declaration line, the end of the declarations, the end of the line */
+
+   for (i = 0; i < doc->line_count; i++)
+      count += doc->lines[i].dirty;
+   if (count == 0)
+      return;
+   lines = (struct RunLine*)reallocate(NULL, count * sizeof(struct RunLine));
+
+   /* The labels of the changed lines are defined by the lines themselves */
+   for (i = 0; i < doc->line_count; i++) {
+      if (doc->lines[i].dirty && (length = label_length(doc->lines[i].text, doc->lines[i].length, &start)) > 0 &&
+          (id = hash_index_find(&doc->symbol_index, doc->lines[i].text + start, length, known_name_key, doc->symbols)) != NO &&
+          hash_index_find(&declared, doc->lines[i].text + start, length, known_name_key, doc->symbols) == NO)
+         hash_index_insert(&declared, doc->lines[i].text + start, length, id);
+   }
+
+   for (i = 0, count = 0; i < doc->line_count; i++) {
+      if (!doc->lines[i].dirty)
+         continue;
+      lines[count].text = doc->lines[i].text;
+      lines[count].length = doc->lines[i].length;
+      lines[count++].target = i;
+      clear_diagnostics(doc, &doc->lines[i].diagnostics);
+
+      /* Declare the symbols of the line as the full assembly found them, so the second path checks their use */
+      for (pos = 0; (length = next_name(doc->lines[i].text, doc->lines[i].length, &pos, &start)) > 0;) {
+         id = hash_index_find(&doc->symbol_index, doc->lines[i].text + start, length, known_name_key, doc->symbols);
+         if (id == NO || hash_index_find(&declared, doc->lines[i].text + start, length, known_name_key, doc->symbols) != NO)
+            continue;
+         hash_index_insert(&declared, doc->lines[i].text + start, length, id);
+
+         symbol = &doc->symbols[id];
+         if (symbol->kind & SYMBOL_EXTERNAL) {
+            append_string(&declarations, ".extern ");
+            append_string(&declarations, symbol->name);
+            append_string(&declarations, "\n");
+         }
+         else {
+            append_string(&declarations, symbol->name);
+            append_string(&declarations, symbol->kind & SYMBOL_DATA ? ": .data 0\n" : ": stop\n");
+         }
+      }
+   }
+
+   if (declarations.size > 0) {
+      lines = (struct RunLine*)reallocate(lines, (count + declared.count) * sizeof(struct RunLine));
+      for (p = declarations.text, end = p + declarations.size; p < end; p = newline + 1) {
+         newline = (const char*)memchr(p, '\n', end - p);
+         lines[count].text = p;
+         lines[count].length = (int)(newline - p);
+         lines[count++].target = NO;
+      }
+   }
+
+   phases = run_lines(doc, lines, count, FALSE);
+   for (i = 0; i < doc->line_count; i++) {
+      if (doc->lines[i].dirty) {
+         doc->lines[i].phases = phases;
+         doc->lines[i].dirty = FALSE;
+      }
+   }
+   free(lines);
+   free(declarations.text);
+   free_hash_index(&declared);
+}
+
+
+
+
+static int published_phase(const struct Document* doc) {
+   int phase = 0;
+
+   while (phase < LSP_PHASE_COUNT - 1 && doc->errors[phase] == 0)
+      phase++;
+   return phase;
+}
+
+
+
+
+static void validate(struct Document* doc, int structural) {
+   int i, reached = LSP_PHASE_COUNT; /* Loop index, the number of phases known for every line */
+
+   if (structural) {
+      full_run(doc);
+      return;
+   }
+
+   changed_lines_run(doc);
+   for (i = 0; i < doc->line_count; i++) {
+      if (doc->lines[i].phases < reached)
+         reached = doc->lines[i].phases;
+   }
+
+   /* A line may lack the messages of the published phase (a phase that failed before stopped there) */
+   if (reached <= published_phase(doc))
+      full_run(doc);
+}
+
+
+
+
+static void publish_diagnostics(struct LanguageServer* server, const struct Document* doc) {
+   const struct Diagnostic* diagnostic; /* A message */
+   int phase = published_phase(doc), i, first = TRUE; /* The last published phase, loop index, TRUE before the first message */
+
+   server->reply.size = 0;
+   append_string(&server->reply, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":");
+   json_append_string(&server->reply, doc->uri, strlen(doc->uri));
+   append_string(&server->reply, ",\"diagnostics\":[");
+
+   for (i = -1; i < doc->line_count; i++) { /* The global messages first, on the first line */
+      for (diagnostic = i < 0 ? doc->globals : doc->lines[i].diagnostics; diagnostic != NULL; diagnostic = diagnostic->next) {
+         if (diagnostic->phase > phase)
+            continue;
+         if (!first)
+            append_string(&server->reply, ",");
+         first = FALSE;
+         append_string(&server->reply, "{\"range\":");
+         append_range(&server->reply, i < 0 ? 0 : i, 0, doc->lines[i < 0 ? 0 : i].length);
+         append_string(&server->reply, ",\"severity\":");
+         append_number(&server->reply, diagnostic->severity);
+         append_string(&server->reply, ",\"source\":\"myassem\",\"message\":");
+         json_append_string(&server->reply, diagnostic->message, strlen(diagnostic->message));
+         append_string(&server->reply, "}");
+      }
+   }
+   append_string(&server->reply, "]}}");
+   send_reply(server);
+}
+
+
+
+
+static void find_name(struct LanguageServer* server, const struct JsonValue* id, const struct JsonValue* params, int references) {
+   struct Document* doc = find_document(server, json_text(json_find(params, "textDocument.uri"))); /* The document */
+   long line = json_integer(json_find(params, "position.line"), NO), character = json_integer(json_find(params, "position.character"), 0);
+   int declarations = json_find(params, "context.includeDeclaration") != NULL &&
+                      json_find(params, "context.includeDeclaration")->type == JSON_TRUE; /* TRUE to include the definitions in the references */
+   const char* text, * name; /* The line of the position, and the name at the position */
+   int name_length, start, end, i, pos, length, definition, first = TRUE; /* The name and a name of a line, TRUE before the first place */
+
+   begin_response(server, id);
+   if (doc == NULL || line < 0 || line >= doc->line_count) {
+      append_string(&server->reply, "null}");
+      send_reply(server);
+      return;
+   }
+
+   /* The name around the position */
+   text = doc->lines[line].text;
+   start = end = character < 0 ? 0 : (character > doc->lines[line].length ? doc->lines[line].length : (int)character);
+   while (start > 0 && isalnum((unsigned char)text[start - 1]))
+      start--;
+   while (end < doc->lines[line].length && isalnum((unsigned char)text[end]))
+      end++;
+   if (start == end || !isalpha((unsigned char)text[start])) {
+      append_string(&server->reply, "null}");
+      send_reply(server);
+      return;
+   }
+   name = text + start;
+   name_length = end - start;
+
+   append_string(&server->reply, "[");
+   for (i = 0; i < doc->line_count; i++) {
+      text = doc->lines[i].text;
+      for (pos = 0; (length = next_name(text, doc->lines[i].length, &pos, &start)) > 0;) {
+         if (length != name_length || memcmp(text + start, name, length) != 0)
+            continue;
+         definition = is_definition(text, doc->lines[i].length, start, length);
+         if (references ? (definition && !declarations) : !definition)
+            continue;
+
+         if (!first)
+            append_string(&server->reply, ",");
+         first = FALSE;
+         append_string(&server->reply, "{\"uri\":");
+         json_append_string(&server->reply, doc->uri, strlen(doc->uri));
+         append_string(&server->reply, ",\"range\":");
+         append_range(&server->reply, i, start, start + length);
+         append_string(&server->reply, "}");
+      }
+   }
+   append_string(&server->reply, "]}");
+   send_reply(server);
+}
+
+
+
+
+int run_language_server(FILE* in, FILE* out) {
+   struct LanguageServer server; /* The state of the server */
+   const struct JsonValue* root; /* The current message */
+   int exited = FALSE, i; /* TRUE once the client sent the exit notification, loop index */
+
+   memset(&server, 0, sizeof(server));
+   server.in = in;
+   server.out = out;
+
+   while (!exited && read_message(&server)) {
+      root = json_parse(&server.values, server.message.text, server.message.size);
+      if (root == NULL)
+         send_error(&server, NULL, JSONRPC_PARSE_ERROR, "Parse error");
+      else
+         exited = !handle_message(&server, root);
+      free_arena(&server.values);
+   }
+
+   for (i = 0; i < server.document_count; i++) {
+      release_document(server.documents[i]);
+      free(server.documents[i]->uri);
+      free(server.documents[i]);
+   }
+   free(server.documents);
+   free_hash_index(&server.document_index);
+   free(server.message.text);
+   free(server.reply.text);
+   free(server.scratch.text);
+   free(server.before.text);
+   free(server.after.text);
+   return exited && server.shutdown;
+}
@@ -0,0 +1,43 @@
+/**
+ * @file language_server.h
+ * @brief A language server over the standard input and output (`--lsp`), for editors.
+ *
+ * The server speaks the Language Server Protocol (JSON-RPC messages with a Content-Length header).
+ * It publishes the messages of the assembler as diagnostics while a source is edited, and answers
+ * go-to-definition and find-references for labels, macros and external symbols.
+ *
+ * Every open document is kept in memory as a table of lines, with the diagnostics of every line, the
+ * macro names and the symbol index of the last full assembly. An edit only replaces the changed lines:
+ * - An edit that can change a definition (it adds, removes or renames a label or changes its kind,
+ *   or touches a macro definition or invocation, or a .entry or .extern line) assembles the whole
+ *   document again, as the command line does.
+ * - Any other edit assembles only the changed lines, as a small document followed by a declaration
+ *   of every known symbol they use, and replaces the diagnostics of those lines. The diagnostics of
+ *   the other lines cannot depend on the changed lines, so they are kept.
+ *
+ * The published diagnostics are those the command line would print: the messages of the phases up to
+ * the first phase with errors. When the lines do not all have the result of that phase, the document
+ * is assembled again in full.
+ */
+
+#ifndef LANGUAGE_SERVER_H
+#define LANGUAGE_SERVER_H
+#include "auxiliary_functions_constants.h"
+
+#define LSP_PHASE_COUNT 3 /* The pre-assembler, the first path and the second path */
+#define LSP_MAX_HEADER 1024 /* Longest header line of a message */
+#define INITIAL_DOCUMENT_LINES 256
+#define INITIAL_DOCUMENT_TABLE_SIZE 8
+
+
+
+/**
+ * @brief Runs the language server until the client sends the exit notification or closes the input.
+ *
+ * @param in The stream the messages of the client are read from.
+ * @param out The stream the responses and notifications are written to.
+ * @return TRUE if the client asked to shut down before exiting, FALSE otherwise.
+ */
+int run_language_server(FILE* in, FILE* out);
+
+#endif /* LANGUAGE_SERVER_H */
@@ -0,0 +1,150 @@
+/**
+ * @file myassem.c
+ * @brief Implements libmyassem: assembling a source held in memory, without the filesystem.
+ */
+
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+
+#include "myassem.h"
+#include "auxiliary_functions_constants.h"
+
+
+/**
+ * @brief Copies the instruction and data words of an assembled file into the result.
+ *
+ * @param ctx The context of the assembled file.
+ * @param result The result to fill.
+ */
+static void collect_code(struct AssemblerContext* ctx, struct AssemblyResult* result);
+
+
+
+/**
+ * @brief Copies the entry symbols and the uses of external symbols of an assembled file into the result.
+ *
+ * The symbols are collected in the same order and with the same rules as the .ent and .ext files.
+ *
+ * @param ctx The context of the assembled file.
+ * @param result The result to fill.
+ */
+static void collect_symbols(struct AssemblerContext* ctx, struct AssemblyResult* result);
+
+
+
+/**
+ * @brief Allocates zeroed memory for a part of the result, exiting the program on failure.
+ *
+ * @param count The number of elements.
+ * @param size The size of a single element.
+ * @return Pointer to the allocated memory.
+ */
+static void* allocate_result(size_t count, size_t size);
+
+
+
+
+static void* allocate_result(size_t count, size_t size) {
+   void* memory = calloc(count > 0 ? count : 1, size); /* Never ask for zero bytes */
+   if (memory == NULL) {
+      perror("Error allocating memory for assembly result");
+      exit(EXIT_FAILURE);
+   }
+   return memory;
+}
+
+
+
+
+static void collect_code(struct AssemblerContext* ctx, struct AssemblyResult* result) {
+   int i; /* Loop index */
+
+   result->code_size = ctx->ICF;
+   result->code = (int*)allocate_result(ctx->ICF, sizeof(int));
+   for (i = 0; i < ctx->ICF; i++)
+      result->code[i] = word_store_get(&ctx->cmd_code, i) & 0xFFFFFF; /* 24-bit words, as in the .ob file */
+
+   result->data_size = ctx->DCF;
+   result->data = (int*)allocate_result(ctx->DCF, sizeof(int));
+   for (i = 0; i < ctx->DCF; i++)
+      result->data[i] = word_store_get(&ctx->data_code, i) & 0xFFFFFF;
+}
+
+
+
+
+static void collect_symbols(struct AssemblerContext* ctx, struct AssemblyResult* result) {
+   int i, entry_count, external_count; /* Loop index and counters */
+   struct Symbol* symbol; /* The current symbol */
+
+   /* Count the entries and the uses of external symbols */
+   entry_count = 0, external_count = 0;
+   for (i = 0; i < ctx->symbol_count; i++) {
+      if (ctx->isEntry && (ctx->symbols_table[i].kind & SYMBOL_ENTRY))
+         entry_count++;
+   }
+   for (i = 0; i < ctx->external_use_count; i++) {
+      if (ctx->isExternal && ctx->symbols_table[ctx->external_uses[i].symbol].kind == SYMBOL_EXTERNAL)
+         external_count++;
+   }
+
+   result->entries = (struct AssemblySymbol*)allocate_result(entry_count, sizeof(struct AssemblySymbol));
+   result->externals = (struct AssemblySymbol*)allocate_result(external_count, sizeof(struct AssemblySymbol));
+
+   /* Copy the entries in the order of the symbols table */
+   for (i = 0; i < ctx->symbol_count; i++) {
+      symbol = &ctx->symbols_table[i];
+      if (ctx->isEntry && (symbol->kind & SYMBOL_ENTRY)) {
+         strncpy(result->entries[result->entry_count].name, symbol->name, ASSEMBLY_SYMBOL_NAME_SIZE - 1);
+         result->entries[result->entry_count++].address = symbol->address;
+      }
+   }
+
+   /* Copy the uses of external symbols in address order */
+   for (i = 0; i < ctx->external_use_count; i++) {
+      symbol = &ctx->symbols_table[ctx->external_uses[i].symbol];
+      if (ctx->isExternal && symbol->kind == SYMBOL_EXTERNAL) {
+         strncpy(result->externals[result->external_count].name, symbol->name, ASSEMBLY_SYMBOL_NAME_SIZE - 1);
+         result->externals[result->external_count++].address = ctx->external_uses[i].address;
+      }
+   }
+}
+
+
+
+
+int assemble_source(const char* source, size_t length, struct AssemblyResult* result) {
+   struct AssemblerContext ctx; /* Tables, code arrays and counters of the source */
+
+   memset(result, 0, sizeof(*result));
+
+   init_context(&ctx, "");
+   ctx.capture_diagnostics = TRUE; /* Keep the messages instead of printing them */
+
+   result->success = assemble_context(&ctx, source, length);
+   if (result->success) {
+      collect_code(&ctx, result);
+      collect_symbols(&ctx, result);
+   }
+
+   /* Hand the collected messages over to the result */
+   result->diagnostics = (char*)allocate_result(ctx.diagnostics.size + 1, sizeof(char));
+   if (ctx.diagnostics.size > 0)
+      memcpy(result->diagnostics, ctx.diagnostics.text, ctx.diagnostics.size);
+
+   free_context(&ctx);
+   return result->success;
+}
+
+
+
+
+void free_assembly_result(struct AssemblyResult* result) {
+   free(result->code);
+   free(result->data);
+   free(result->entries);
+   free(result->externals);
+   free(result->diagnostics);
+   memset(result, 0, sizeof(*result));
+}
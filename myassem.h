@@ -0,0 +1,87 @@
+/**
+ * @file myassem.h
+ * @brief Public interface of libmyassem, the assembler as an embeddable library.
+ *
+ * The library assembles a source held in memory and returns the machine code, the data,
+ * the entry and external symbols and the error messages in memory. It never reads from or
+ * writes to the filesystem, and calls for different sources may run at the same time.
+ */
+
+#ifndef MYASSEM_H
+#define MYASSEM_H
+
+#include <stddef.h>
+
+#define ASSEMBLY_SYMBOL_NAME_SIZE 32
+#define ASSEMBLY_FIRST_ADDRESS 100
+
+
+
+/**
+ * @brief A symbol name with an address, as written to the .ent and .ext files.
+ * @struct AssemblySymbol
+ * @param name The name of the symbol (null-terminated).
+ * @param address For an entry, the address of the symbol. For an external, the address of a word that uses it.
+ */
+struct AssemblySymbol {
+   char name[ASSEMBLY_SYMBOL_NAME_SIZE];
+   int address;
+};
+
+
+
+/**
+ * @brief The result of assembling a source.
+ * @struct AssemblyResult
+ * @param success TRUE (1) if no errors were found, FALSE (0) otherwise. The code, data, entries and
+ *                externals are only filled on success.
+ * @param code The instruction words (24 bits each), the first one at address ASSEMBLY_FIRST_ADDRESS.
+ * @param code_size The number of instruction words (ICF).
+ * @param data The data words (24 bits each), placed right after the instruction words.
+ * @param data_size The number of data words (DCF).
+ * @param entries The entry symbols, in the order of the .ent file.
+ * @param entry_count The number of entry symbols.
+ * @param externals Every use of an external symbol, in address order (the order of the .ext file).
+ * @param external_count The number of uses of external symbols.
+ * @param diagnostics The error and attention messages, one per line (an empty string if there are none).
+ */
+struct AssemblyResult {
+   int success;
+   int* code;
+   int code_size;
+   int* data;
+   int data_size;
+   struct AssemblySymbol* entries;
+   int entry_count;
+   struct AssemblySymbol* externals;
+   int external_count;
+   char* diagnostics;
+};
+
+
+
+/**
+ * @brief Assembles a source held in memory.
+ *
+ * Runs the pre-assembler, the first path and the second path on the source, the same way the
+ * command-line assembler does for a .as file, without touching the filesystem.
+ *
+ * @param source The content of the source (what would be the .as file).
+ * @param length The length of the source in bytes.
+ * @param result The structure to fill with the result. Release it with free_assembly_result.
+ * @return TRUE (1) if no errors were found in the source, FALSE (0) otherwise.
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+int assemble_source(const char* source, size_t length, struct AssemblyResult* result);
+
+
+
+/**
+ * @brief Frees the memory of a result filled by assemble_source.
+ *
+ * @param result The result to free.
+ */
+void free_assembly_result(struct AssemblyResult* result);
+
+#endif /* MYASSEM_H */
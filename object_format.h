@@ -0,0 +1,92 @@
+/**
+ * @file object_format.h
+ * @brief Layout of the binary object file written with `--format=bin`.
+ *
+ * The binary object holds the same information as the .ob, .ent and .ext files in a single file
+ * (<name>.obj) that a loader can map into memory and use without parsing:
+ *
+ * - A header of OBJECT_HEADER_SIZE bytes (struct ObjectHeader).
+ * - The code section: the instruction words, 3 bytes each.
+ * - The data section: the data words, 3 bytes each.
+ * - The relocation table: the address of every instruction word that holds a relocatable address (4 bytes each).
+ * - The entry table: the entry symbols (struct ObjectSymbol), in the order of the .ent file.
+ * - The extern table: every use of an external symbol (struct ObjectSymbol), in address order (the order of the .ext file).
+ * - The string pool: the symbol names, null-terminated, each stored once.
+ *
+ * All the numbers are unsigned and little-endian, the header fields and table entries are 4 bytes
+ * each, and every section starts at a multiple of 4 bytes from the start of the file. A section
+ * may be empty, in which case its count is 0.
+ */
+
+#ifndef OBJECT_FORMAT_H
+#define OBJECT_FORMAT_H
+
+#define OBJECT_FORMAT_TEXT 0 /* The .ob, .ent and .ext text files */
+#define OBJECT_FORMAT_BIN 1 /* The binary object file */
+
+#define OBJECT_EXTENSION ".obj"
+#define OBJECT_MAGIC "MYAO"
+#define OBJECT_VERSION 1
+#define OBJECT_HEADER_SIZE 64
+#define OBJECT_WORD_SIZE 3
+#define OBJECT_ALIGNMENT 4
+
+
+
+/**
+ * @brief The header at the start of a binary object file.
+ * @struct ObjectHeader
+ *
+ * The fields are 4-byte little-endian numbers, so on a little-endian machine with a 4-byte
+ * `unsigned int` the start of a mapped file can be used as this structure directly.
+ *
+ * @param magic The characters of OBJECT_MAGIC (not null-terminated).
+ * @param version OBJECT_VERSION.
+ * @param base_address The address of the first instruction word (the data words follow the instruction words).
+ * @param file_size The size of the whole file in bytes.
+ * @param code_offset The position of the code section in the file.
+ * @param code_count The number of instruction words (ICF).
+ * @param data_offset The position of the data section in the file.
+ * @param data_count The number of data words (DCF).
+ * @param relocation_offset The position of the relocation table in the file.
+ * @param relocation_count The number of relocation entries.
+ * @param entry_offset The position of the entry table in the file.
+ * @param entry_count The number of entry symbols.
+ * @param extern_offset The position of the extern table in the file.
+ * @param extern_count The number of uses of external symbols.
+ * @param strings_offset The position of the string pool in the file.
+ * @param strings_size The size of the string pool in bytes.
+ */
+struct ObjectHeader {
+   unsigned char magic[4];
+   unsigned int version;
+   unsigned int base_address;
+   unsigned int file_size;
+   unsigned int code_offset;
+   unsigned int code_count;
+   unsigned int data_offset;
+   unsigned int data_count;
+   unsigned int relocation_offset;
+   unsigned int relocation_count;
+   unsigned int entry_offset;
+   unsigned int entry_count;
+   unsigned int extern_offset;
+   unsigned int extern_count;
+   unsigned int strings_offset;
+   unsigned int strings_size;
+};
+
+
+
+/**
+ * @brief An entry of the entry and extern tables of a binary object file.
+ * @struct ObjectSymbol
+ * @param name The position of the symbol name in the string pool.
+ * @param address For an entry, the address of the symbol. For an external, the address of a word that uses it.
+ */
+struct ObjectSymbol {
+   unsigned int name;
+   unsigned int address;
+};
+
+#endif /* OBJECT_FORMAT_H */
@@ -1,10 +1,145 @@
 #ifdef _MSC_VER
 #define _CRT_SECURE_NO_WARNINGS
+#else
+#define _POSIX_C_SOURCE 200809L
+#include <fcntl.h>
+#include <unistd.h>
 #endif
+#include <errno.h>
 
 
 #include "output.h"
 
+#define MAX_NUMBER_LENGTH 11 /* The digits of an int, with its sign */
+#define HEX_WORD_LENGTH 6 /* A 24-bit word in hexadecimal */
+#define MAX_OB_LINE_LENGTH (MAX_NUMBER_LENGTH + 1 + HEX_WORD_LENGTH + 1) /* Address, space, word and newline */
+#define MAX_OB_HEADER_LENGTH (5 + MAX_NUMBER_LENGTH + 1 + MAX_NUMBER_LENGTH + 1) /* Indent, ICF, space, DCF and newline */
+
+/* The decimal digits of 0 to 99, two characters each */
+static const char digit_pairs[] =
+   "00010203040506070809"
+   "10111213141516171819"
+   "20212223242526272829"
+   "30313233343536373839"
+   "40414243444546474849"
+   "50515253545556575859"
+   "60616263646566676869"
+   "70717273747576777879"
+   "80818283848586878889"
+   "90919293949596979899";
+
+/* The hexadecimal digits */
+static const char hex_digits[] = "0123456789ABCDEF";
+
+
+
+/**
+ * @brief Formats a number in decimal, zero-padded to a minimum width (like "%0*d").
+ *
+ * The digits are produced two at a time from a table, from the last one to the first.
+ *
+ * @param dest The buffer to write to (at least MAX_NUMBER_LENGTH characters, or the width if it is larger).
+ * @param value The number to format.
+ * @param width The minimum number of characters, including the sign of a negative number.
+ * @return The number of characters written (not null-terminated).
+ */
+static int format_decimal(char* dest, int value, int width);
+
+
+
+/**
+ * @brief Formats the low 24 bits of a word as 6 uppercase hexadecimal digits (like "%06X").
+ *
+ * @param dest The buffer to write to (at least HEX_WORD_LENGTH characters).
+ * @param word The word to format.
+ */
+static void format_hex_word(char* dest, int word);
+
+
+
+/**
+ * @brief Formats a line of the object file: the address and the word (like "%07d %06X\n").
+ *
+ * @param dest The buffer to write to (at least MAX_OB_LINE_LENGTH characters).
+ * @param address The address of the word.
+ * @param word The word.
+ * @return The number of characters written (not null-terminated).
+ */
+static int format_ob_line(char* dest, int address, int word);
+
+
+
+/**
+ * @brief Appends a line of the .ent or .ext file to a buffer: the symbol name and the address (like "%s %07d\n").
+ *
+ * @param buffer The buffer to append to.
+ * @param name The name of the symbol.
+ * @param address The address to write.
+ */
+static void append_symbol_line(struct TextBuffer* buffer, const char* name, int address);
+
+
+
+/**
+ * @brief Appends a little-endian number to a buffer.
+ *
+ * @param buffer The buffer to append to.
+ * @param value The number to append.
+ * @param size The number of bytes of the number.
+ */
+static void append_number(struct TextBuffer* buffer, unsigned long value, int size);
+
+
+
+/**
+ * @brief Pads a buffer with zero bytes up to a multiple of OBJECT_ALIGNMENT.
+ *
+ * @param buffer The buffer to pad.
+ */
+static void align_section(struct TextBuffer* buffer);
+
+
+
+/**
+ * @brief Adds a name to the string pool of a binary object.
+ *
+ * @param strings The string pool.
+ * @param name The name to add.
+ * @return The position of the name in the string pool.
+ */
+static unsigned long add_string(struct TextBuffer* strings, const char* name);
+
+
+
+/**
+ * @brief Writes the binary object file: the code, the data, the relocation table and the entry and extern tables.
+ *
+ * The layout is described in object_format.h. The entries and externals follow the same rules as the
+ * .ent and .ext files.
+ *
+ * @param objFilename The name of the output file to write to.
+ * @param ctx The context of the assembled file.
+ *
+ * @return TRUE if the file was written, FALSE otherwise (the error is reported to the context).
+ */
+static int write_object(const char* objFilename, struct AssemblerContext* ctx);
+
+
+
+/**
+ * @brief Writes the content of an output file with a single write.
+ *
+ * An error is reported to the messages of the file rather than ending the program, so the other files
+ * of a batch, and the requests of a server, go on.
+ *
+ * @param ctx The context of the assembled file. The length is added to the bytes written in its statistics.
+ * @param filename The name of the file to create.
+ * @param text The content of the file.
+ * @param length The length of the content.
+ * @return TRUE if the file was written, FALSE otherwise.
+ */
+static int write_file(struct AssemblerContext* ctx, const char* filename, const char* text, size_t length);
+
 /**
  * write_ob - Writes the object code to a specified file.
  *
@@ -14,39 +149,31 @@
  * code followed by the data code, each formatted as an address and a 24-bit hexadecimal value.
  *
  * @param obFilename The name of the output file to write to.
- * @param cmd_code   An array containing the instruction code.
- * @param data_code  An array containing the data code.
- * @param ICF        The final instruction counter value (number of instructions).
- * @param DCF        The final data counter value (number of data entries).
- *
- * @return TRUE if the operation is successful.
+ * @param ctx        The context of the assembled file: its instruction code, data code,
+ *                   final instruction counter (ICF) and final data counter (DCF).
  *
- * @note The function exits the program with an error message if the file cannot be opened.
+ * @return TRUE if the file was written, FALSE otherwise (the error is reported to the context).
  */
-static int write_ob(const char* obFilename, int* cmd_code, int* data_code, int ICF, int DCF);
+static int write_ob(const char* obFilename, struct AssemblerContext* ctx);
 
 
 
 /**
- * write_ext - Writes external symbols and their addresses to a file.
+ * write_ext - Writes the uses of external symbols to a file.
  *
- * This function iterates through a symbol table to find symbols marked as
- * "external" and writes their names along with their associated addresses
+ * This function goes over the uses of external symbols, in address order, and
+ * writes the name of the symbol along with the address of the word that uses it
  * to a specified output file. Each line in the output file contains the
  * symbol name and an address in the format: "symbol_name address".
+ * Symbols that are also defined in the file are not written.
  *
  * @param extFilename: The name of the output file to write the external symbols.
- * @param symbols_table: Pointer to the array of Symbol structures containing
- *                       the symbol table data.
- * @param symbols_table_size: The number of entries in the symbol table.
+ * @param ctx: The context of the assembled file: its symbols table and the uses of
+ *             external symbols, in address order.
  *
- * @return TRUE (non-zero) on success.
- *
- * @note If the file cannot be opened for writing, the function prints an
- *       error message using perror, closes the file (if applicable), and
- *       terminates the program with an exit status of EXIT_FAILURE.
+ * @return TRUE if the file was written, FALSE otherwise (the error is reported to the context).
  */
-static int write_ext(const char* extFilename, struct Symbol* symbols_table, int symbols_table_size);
+static int write_ext(const char* extFilename, struct AssemblerContext* ctx);
 
 
 
@@ -59,152 +186,396 @@ static int write_ext(const char* extFilename, struct Symbol* symbols_table, int
  * the address is zero-padded to 7 digits.
  *
  * @param entFilename The name of the file to write the "entry" symbols to.
- * @param symbols_table A pointer to the array of Symbol structures containing
- *                      the symbols to be processed.
- * @param symbols_table_size The number of elements in the symbols table.
- * 
- * @return TRUE (non-zero) if the operation completes successfully.
+ * @param ctx The context of the assembled file, whose symbols table is processed.
  * 
- * @note The function will terminate the program with an error message if:
- *       - The file cannot be opened for writing.
- *       - An error occurs while writing to the file.
- *       - The file cannot be closed properly.
+ * @return TRUE if the file was written, FALSE otherwise (the error is reported to the context).
  */
-static int write_ent(const char* entFilename, struct Symbol* symbols_table, int symbols_table_size);
+static int write_ent(const char* entFilename, struct AssemblerContext* ctx);
 
 
 
 
-static int write_ent(const char* entFilename, struct Symbol* symbols_table, int symbols_table_size) {
-   FILE* dest; /* Pointer to the output file */
-   int i; /* Loop counter for iterating through the symbols table */
+static int format_decimal(char* dest, int value, int width) {
+   char digits[MAX_NUMBER_LENGTH]; /* The digits, from the last one */
+   unsigned long number; /* The magnitude of the value */
+   int count, length, negative; /* Number of digits, characters written and sign of the value */
 
-   /* Open the entry symbols file for writing */
-   dest = fopen(entFilename, "w");
-   if (dest == NULL) {
-      /* Handle error if the file cannot be opened */
-      perror("Error opening destination file");
-      exit(EXIT_FAILURE);
+   negative = value < 0;
+   number = negative ? 0UL - (unsigned long)value : (unsigned long)value;
+
+   /* Produce the digits two at a time, from the last one */
+   count = 0;
+   while (number >= 100) {
+      digits[count++] = digit_pairs[(number % 100) * 2 + 1];
+      digits[count++] = digit_pairs[(number % 100) * 2];
+      number /= 100;
    }
+   digits[count++] = digit_pairs[number * 2 + 1];
+   if (number >= 10)
+      digits[count++] = digit_pairs[number * 2];
+
+   /* Sign, padding zeros and then the digits in order */
+   length = 0;
+   if (negative)
+      dest[length++] = '-';
+   while (length + count < width)
+      dest[length++] = '0';
+   while (count > 0)
+      dest[length++] = digits[--count];
+   return length;
+}
 
-   /* Iterate through the symbols table to find "entry" symbols */
-   for (i = 0; i < symbols_table_size; i++) {
-      /* Check if the symbol type is not NULL and contains "entry" */
-      if (symbols_table[i].type != NULL && strstr(symbols_table[i].type, "entry") != NULL) {
-         /* Write the symbol name and zero-padded address to the file */
-         if (fprintf(dest, "%s %07d\n", symbols_table[i].name, symbols_table[i].address) < 0) {
-            /* Handle error if writing to the file fails */
-            perror("Error writing to file");
-            fclose(dest);
-            exit(EXIT_FAILURE);
-         }
+
+
+
+static void format_hex_word(char* dest, int word) {
+   unsigned long bits = (unsigned long)word & 0xFFFFFF; /* The 24 bits of the word */
+
+   dest[0] = hex_digits[(bits >> 20) & 0xF];
+   dest[1] = hex_digits[(bits >> 16) & 0xF];
+   dest[2] = hex_digits[(bits >> 12) & 0xF];
+   dest[3] = hex_digits[(bits >> 8) & 0xF];
+   dest[4] = hex_digits[(bits >> 4) & 0xF];
+   dest[5] = hex_digits[bits & 0xF];
+}
+
+
+
+
+static int format_ob_line(char* dest, int address, int word) {
+   int length; /* Characters written */
+
+   length = format_decimal(dest, address, 7);
+   dest[length++] = ' ';
+   format_hex_word(dest + length, word);
+   length += HEX_WORD_LENGTH;
+   dest[length++] = '\n';
+   return length;
+}
+
+
+
+
+static void append_symbol_line(struct TextBuffer* buffer, const char* name, int address) {
+   char number[MAX_NUMBER_LENGTH + 2]; /* The space, the address and the newline */
+   int length; /* Length of the formatted address */
+
+   number[0] = ' ';
+   length = 1 + format_decimal(number + 1, address, 7);
+   number[length++] = '\n';
+
+   append_text(buffer, name, strlen(name));
+   append_text(buffer, number, length);
+}
+
+
+
+
+static int write_file(struct AssemblerContext* ctx, const char* filename, const char* text, size_t length) {
+   size_t remaining = length; /* Bytes not written yet */
+#ifndef _MSC_VER
+   int fd; /* Descriptor of the file */
+   ssize_t written; /* Bytes written by the last write */
+
+   fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+   if (fd < 0) {
+      report_message(ctx, "Error opening output file %s: %s\n", filename, strerror(errno));
+      return FALSE;
+   }
+
+   /* A single write, unless the system writes only a part of the content */
+   while (remaining > 0) {
+      written = write(fd, text, remaining);
+      if (written < 0) {
+         report_message(ctx, "Error writing output file %s: %s\n", filename, strerror(errno));
+         close(fd);
+         return FALSE;
       }
+      text += written;
+      remaining -= (size_t)written;
+   }
+
+   if (close(fd) != 0) {
+      report_message(ctx, "Error closing output file %s: %s\n", filename, strerror(errno));
+      return FALSE;
+   }
+#else
+   FILE* dest; /* Pointer to the output file */
+
+   dest = fopen(filename, "wb");
+   if (dest == NULL) {
+      report_message(ctx, "Error opening output file %s: %s\n", filename, strerror(errno));
+      return FALSE;
+   }
+   if (fwrite(text, 1, remaining, dest) != remaining) {
+      report_message(ctx, "Error writing output file %s: %s\n", filename, strerror(errno));
+      fclose(dest);
+      return FALSE;
    }
-   
-   /* Close the file after writing */
    if (fclose(dest) != 0) {
-      /* Handle error if the file cannot be closed */
-      perror("Error closing file");
-      exit(EXIT_FAILURE);
+      report_message(ctx, "Error closing output file %s: %s\n", filename, strerror(errno));
+      return FALSE;
    }
+#endif
 
-   return TRUE; /* Indicate success */
+   ctx->stats.bytes_written += length;
+   return TRUE;
 }
 
 
 
 
-static int write_ext(const char* extFilename, struct Symbol* symbols_table, int symbols_table_size) {
-   FILE* dest; /* Pointer to the output file */
-   int i, j; /* Loop counters */
+static void append_number(struct TextBuffer* buffer, unsigned long value, int size) {
+   char bytes[4]; /* The bytes of the number, the lowest first */
+   int i; /* Loop counter */
+
+   for (i = 0; i < size; i++, value >>= 8)
+      bytes[i] = (char)(value & 0xFF);
+   append_text(buffer, bytes, size);
+}
+
+
+
+
+static void align_section(struct TextBuffer* buffer) {
+   static const char zeros[OBJECT_ALIGNMENT] = { 0 }; /* Padding bytes */
+
+   if (buffer->size % OBJECT_ALIGNMENT != 0)
+      append_text(buffer, zeros, OBJECT_ALIGNMENT - buffer->size % OBJECT_ALIGNMENT);
+}
 
-   /* Open the external symbols file for writing */
-   dest = fopen(extFilename, "w");
 
-   if (dest == NULL) {
-      /* Handle error if the file cannot be opened */
-      perror("Error opening destination file");
-      fclose(dest);
-      exit(EXIT_FAILURE);
-   }
 
-   /* Iterate through the symbol table to find external symbols */
-   for (i = 0; i < symbols_table_size; i++) {
-      /* Check if the symbol type is "external" */
-      if (symbols_table[i].type[0] != '\0' &&
-         strcmp(symbols_table[i].type, "external") == 0) {
-         /* Write each external address associated with the symbol */
-         for (j = 0; j < symbols_table[i].extern_address_size; j++) {
-            fprintf(dest, "%s %07d\n", symbols_table[i].name, symbols_table[i].extern_address[j]);
+
+static unsigned long add_string(struct TextBuffer* strings, const char* name) {
+   unsigned long position = (unsigned long)strings->size; /* Where the name starts */
+
+   append_text(strings, name, strlen(name) + 1); /* With its null terminator */
+   return position;
+}
+
+
+
+
+static int write_object(const char* objFilename, struct AssemblerContext* ctx) {
+   struct TextBuffer content = { 0 }, strings = { 0 }, header = { 0 }; /* The file, its string pool and its header */
+   unsigned long offsets[6], counts[6]; /* Position and count of the code, data, relocation, entry, extern and string sections */
+   unsigned long* names; /* For every symbol, the position of its name in the string pool + 1 (0 if not added) */
+   int written; /* TRUE if the file was written */
+   struct Symbol* symbol; /* The current symbol */
+   struct ExternalUse* use; /* The current use of an external symbol */
+   const int* words; /* The current run of consecutive words */
+   int i, j, n, section; /* Loop counters, the length of the current run and the current section */
+
+   /* Leave room for the header, which is filled once the sections are placed */
+   while (content.size < OBJECT_HEADER_SIZE)
+      append_number(&content, 0, 4);
+
+   /* The code section: the instruction words */
+   offsets[0] = content.size, counts[0] = ctx->ICF;
+   for (i = 0; i < ctx->ICF; i += n) {
+      n = word_store_run(&ctx->cmd_code, i, ctx->ICF, &words);
+      for (j = 0; j < n; j++)
+         append_number(&content, (unsigned long)words[j] & 0xFFFFFF, OBJECT_WORD_SIZE);
+   }
+   align_section(&content);
+
+   /* The data section: the data words */
+   offsets[1] = content.size, counts[1] = ctx->DCF;
+   for (i = 0; i < ctx->DCF; i += n) {
+      n = word_store_run(&ctx->data_code, i, ctx->DCF, &words);
+      for (j = 0; j < n; j++)
+         append_number(&content, (unsigned long)words[j] & 0xFFFFFF, OBJECT_WORD_SIZE);
+   }
+   align_section(&content);
+
+   /* The relocation table: the instruction words that hold an address with the relocatable flag */
+   offsets[2] = content.size, counts[2] = 0;
+   for (i = 0; i < ctx->ICF; i += n) {
+      n = word_store_run(&ctx->cmd_code, i, ctx->ICF, &words);
+      for (j = 0; j < n; j++) {
+         if ((words[j] & ((1 << ARE_BITS) - 1)) == R) {
+            append_number(&content, i + j + 100, 4);
+            counts[2]++;
          }
       }
    }
 
-   /* Close the file after writing */
-   fclose(dest);
-   return TRUE; /* Indicate success */
+   /* The entry table, like the .ent file */
+   offsets[3] = content.size, counts[3] = 0;
+   for (i = 0; ctx->isEntry && i < ctx->symbol_count; i++) {
+      symbol = &ctx->symbols_table[i];
+      if (symbol->kind & SYMBOL_ENTRY) {
+         append_number(&content, add_string(&strings, symbol->name), 4);
+         append_number(&content, symbol->address, 4);
+         counts[3]++;
+      }
+   }
+
+   /* The extern table, like the .ext file: the name of a symbol is stored once for all of its uses */
+   offsets[4] = content.size, counts[4] = 0;
+   names = (unsigned long*)arena_alloc(&ctx->arena, (ctx->symbol_count + 1) * sizeof(unsigned long)); /* Position + 1, or 0 */
+   for (i = 0; ctx->isExternal && i < ctx->external_use_count; i++) {
+      use = &ctx->external_uses[i];
+      if (ctx->symbols_table[use->symbol].kind != SYMBOL_EXTERNAL)
+         continue;
+      if (names[use->symbol] == 0)
+         names[use->symbol] = add_string(&strings, ctx->symbols_table[use->symbol].name) + 1;
+      append_number(&content, names[use->symbol] - 1, 4);
+      append_number(&content, use->address, 4);
+      counts[4]++;
+   }
+
+   /* The string pool */
+   offsets[5] = content.size, counts[5] = strings.size;
+   if (strings.size > 0)
+      append_text(&content, strings.text, strings.size);
+   align_section(&content);
+
+   /* Fill the header */
+   append_text(&header, OBJECT_MAGIC, 4);
+   append_number(&header, OBJECT_VERSION, 4);
+   append_number(&header, 100, 4);
+   append_number(&header, content.size, 4);
+   for (section = 0; section < 6; section++) {
+      append_number(&header, offsets[section], 4);
+      append_number(&header, counts[section], 4);
+   }
+   memcpy(content.text, header.text, header.size);
+
+   /* Write the file at once */
+   written = write_file(ctx, objFilename, content.text, content.size);
+   free(content.text);
+   free(strings.text);
+   free(header.text);
+   return written;
 }
 
 
 
 
-static int write_ob(const char* obFilename, int* cmd_code, int* data_code, int ICF, int DCF) {
-   FILE* dest; /* Pointer to the output file */
-   int i; /* Loop counter */
+static int write_ent(const char* entFilename, struct AssemblerContext* ctx) {
+   struct TextBuffer content = { 0 }; /* The content of the file */
+   struct Symbol* symbols_table = ctx->symbols_table; /* The symbols of the file */
+   int i, written; /* Loop counter for iterating through the symbols table, and TRUE if the file was written */
 
-   /* Open the output file for writing */
-   dest = fopen(obFilename, "w");
+   /* Iterate through the symbols table to find "entry" symbols */
+   for (i = 0; i < ctx->symbol_count; i++) {
+      /* Check if the symbol is an entry */
+      if (symbols_table[i].kind & SYMBOL_ENTRY) {
+         /* Add the symbol name and zero-padded address */
+         append_symbol_line(&content, symbols_table[i].name, symbols_table[i].address);
+      }
+   }
 
-   if (dest == NULL) {
-      /* Handle error if the file cannot be opened */
-      perror("Error opening destination file");
-      fclose(dest);
-      exit(EXIT_FAILURE);
+   /* Write the file at once */
+   written = write_file(ctx, entFilename, content.text, content.size);
+   free(content.text);
+   return written;
+}
+
+
+
+
+static int write_ext(const char* extFilename, struct AssemblerContext* ctx) {
+   struct TextBuffer content = { 0 }; /* The content of the file */
+   struct Symbol* symbols_table = ctx->symbols_table; /* The symbols of the file */
+   struct ExternalUse* uses = ctx->external_uses; /* The uses of external symbols, in address order */
+   int i, written; /* Loop counter, and TRUE if the file was written */
+
+   /* Iterate through the uses of external symbols, in address order */
+   for (i = 0; i < ctx->external_use_count; i++) {
+      /* Check if the symbol is only external (not also defined in the file) */
+      if (symbols_table[uses[i].symbol].kind == SYMBOL_EXTERNAL)
+         append_symbol_line(&content, symbols_table[uses[i].symbol].name, uses[i].address);
    }
 
-   /* Write the header line with ICF (instruction count) and DCF (data count) */
-   fprintf(dest, "     %d %d\n", ICF, DCF);
+   /* Write the file at once */
+   written = write_file(ctx, extFilename, content.text, content.size);
+   free(content.text);
+   return written;
+}
+
+
+
 
-   /* Write the instruction code to the file */
-   for (i = 0; i < ICF; i++) {
-      /* Format: address (starting from 100) and 24-bit hexadecimal value */
-      fprintf(dest, "%07d %06X\n", i + 100, cmd_code[i] & 0xFFFFFF);
+static int write_ob(const char* obFilename, struct AssemblerContext* ctx) {
+   char* content; /* The content of the file */
+   size_t length; /* The length of the content */
+   const int* words; /* The current run of consecutive words */
+   int ICF = ctx->ICF, DCF = ctx->DCF; /* The number of instruction and data words */
+   int i, j, n, written; /* Loop counters, the length of the current run, and TRUE if the file was written */
+
+   /* Every line has a bounded width, so the whole file fits in one allocation */
+   content = (char*)malloc((size_t)(ICF + DCF) * MAX_OB_LINE_LENGTH + MAX_OB_HEADER_LENGTH);
+   if (content == NULL) {
+      report_message(ctx, "Error allocating memory for output file %s\n", obFilename);
+      return FALSE;
+   }
+
+   /* The header line with ICF (instruction count) and DCF (data count) */
+   memcpy(content, "     ", 5);
+   length = 5;
+   length += format_decimal(content + length, ICF, 0);
+   content[length++] = ' ';
+   length += format_decimal(content + length, DCF, 0);
+   content[length++] = '\n';
+
+   /* The instruction code: address (starting from 100) and 24-bit hexadecimal value */
+   for (i = 0; i < ICF; i += n) {
+      n = word_store_run(&ctx->cmd_code, i, ICF, &words);
+      for (j = 0; j < n; j++)
+         length += format_ob_line(content + length, i + j + 100, words[j]);
    }
 
-   /* Write the data code to the file */
-   for (i = 0; i < DCF; i++) {
-      /* Format: address (starting after instructions) and 24-bit hexadecimal value */
-      fprintf(dest, "%07d %06X\n", i + ICF + 100, data_code[i] & 0xFFFFFF);
+   /* The data code: address (starting after instructions) and 24-bit hexadecimal value */
+   for (i = 0; i < DCF; i += n) {
+      n = word_store_run(&ctx->data_code, i, DCF, &words);
+      for (j = 0; j < n; j++)
+         length += format_ob_line(content + length, i + j + ICF + 100, words[j]);
    }
 
-   /* Close the file after writing */
-   fclose(dest);
-   return TRUE; /* Indicate success */
+   /* Write the file at once */
+   written = write_file(ctx, obFilename, content, length);
+   free(content);
+   return written;
 }
 
 
 
-void output(const char* fileName, int* cmd_code, int* data_code, struct Symbol* symbols_table, int symbols_table_size, int ICF, int DCF, int isExternal, int isEntry) {
+int output(struct AssemblerContext* ctx) {
    char obFilename[256]; /* Buffer to store the .ob file name */
    char extFilename[256]; /* Buffer to store the .ext file name */
    char entFilename[256]; /* Buffer to store the .ent file name */
+   double start = stats_clock(); /* Time at the start of the output phase */
+   int written; /* TRUE if every file was written */
 
    /* Create the .ob file name by appending ".ob" to the base file name */
-   sprintf(obFilename, "%s%s", fileName, ".ob");
+   sprintf(obFilename, "%s%s", ctx->fileName, ".ob");
    /* Create the .ext file name by appending ".ext" to the base file name */
-   sprintf(extFilename, "%s%s", fileName, ".ext");
+   sprintf(extFilename, "%s%s", ctx->fileName, ".ext");
    /* Create the .ent file name by appending ".ent" to the base file name */
-   sprintf(entFilename, "%s%s", fileName, ".ent");
+   sprintf(entFilename, "%s%s", ctx->fileName, ".ent");
+
+   if (ctx->object_format == OBJECT_FORMAT_BIN) {
+      /* Write everything to a single binary object file (.obj) */
+      sprintf(obFilename, "%s%s", ctx->fileName, OBJECT_EXTENSION);
+      written = write_object(obFilename, ctx);
+      ctx->stats.phase_time[STATS_OUTPUT] = stats_clock() - start;
+      return written;
+   }
 
    /* Write the object file (.ob) with command and data code */
-   write_ob(obFilename, cmd_code, data_code, ICF, DCF);
+   written = write_ob(obFilename, ctx);
 
    /* If there are external symbols, write the external file (.ext) */
-   if (isExternal)
-      write_ext(extFilename, symbols_table, symbols_table_size);
+   if (written && ctx->isExternal)
+      written = write_ext(extFilename, ctx);
 
    /* If there are entry symbols, write the entry file (.ent) */
-   if (isEntry)
-      write_ent(entFilename, symbols_table, symbols_table_size);
+   if (written && ctx->isEntry)
+      written = write_ent(entFilename, ctx);
 
+   ctx->stats.phase_time[STATS_OUTPUT] = stats_clock() - start;
+   return written;
 }
\ No newline at end of file
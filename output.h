@@ -2,6 +2,7 @@
 #define OUTPUT_H
 #include "first_path.h"
 #include "pre_assembler.h"
+#include "object_format.h"
 
 /**
  * @brief Outputs the assembly process results to files.
@@ -9,18 +10,16 @@
  * This function generates and writes the output files for the assembly process.
  * It creates an object file (.ob) containing the command and data code, an external
  * symbols file (.ext) if external symbols exist, and an entry symbols file (.ent)
- * if entry symbols exist.
+ * if entry symbols exist. In the OBJECT_FORMAT_BIN format it creates a single binary
+ * object file (.obj) with all of them instead (see object_format.h).
  *
- * @param fileName The base name of the output files (without extension).
- * @param cmd_code Pointer to the array containing the command code.
- * @param data_code Pointer to the array containing the data code.
- * @param symbols_table Pointer to the symbol table containing symbol information.
- * @param symbols_table_size The size of the symbol table.
- * @param ICF The final value of the instruction counter.
- * @param DCF The final value of the data counter.
- * @param isExternal A flag indicating whether there are external symbols (non-zero if true).
- * @param isEntry A flag indicating whether there are entry symbols (non-zero if true).
+ * @param ctx The context of the assembled file. Its file name is the base name of the output files,
+ *            and its code arrays, symbols table, ICF, DCF, isExternal and isEntry are written out
+ *            in its object format. The time of the output phase and the number of bytes written are
+ *            added to its statistics.
+ * @return TRUE if every file was written. Otherwise FALSE, with the file that could not be written
+ *         reported to the messages of the context; the files after it are not written.
  */
-void output(const char* fileName, int* cmd_code, int* data_code, struct Symbol* symbols_table, int symbols_table_size, int ICF, int DCF, int isExternal, int isEntry);
+int output(struct AssemblerContext* ctx);
 
 #endif /* OUTPUT_H */
\ No newline at end of file
@@ -7,207 +7,226 @@
 /**
  * @brief Expands the macro table by doubling its size
  * 
- * This function doubles the size of the macro table by reallocating memory
- * and initializes the new memory slots to zero. If reallocation fails,
+ * This function doubles the size of the macro table in the arena of the file
+ * and initializes the new memory slots to zero. If allocation fails,
  * the program terminates with an error message.
  *
+ * @param arena The arena the macro table was allocated from
  * @param macro_table Pointer to the pointer of the macro table to be expanded
  * @param macro_table_size Pointer to the current size of the macro table
  * @return struct Macro* Pointer to the newly allocated macro table
  * @note The original macro table size is doubled
- * @warning Exits program if memory reallocation fails
+ * @warning Exits program if memory allocation fails
  */
-static struct Macro* expand_macro_table(struct Macro** macro_table, int* macro_table_size);
+static struct Macro* expand_macro_table(struct Arena* arena, struct Macro** macro_table, int* macro_table_size);
+
+/**
+ * @brief Returns the name of a macro, for looking macros up in the macro index.
+ *
+ * @param table The macro table.
+ * @param id The index of the macro in the table.
+ * @return The name of the macro.
+ */
+static const char* macro_name_key(const void* table, int id);
+
+/**
+ * @brief Adds a row to a list of lines, as views into the source.
+ *
+ * The row is split the same way a row buffer of MAX characters reads it: a row longer than
+ * MAX - 1 characters becomes several lines.
+ *
+ * @param arena The arena the list is allocated from.
+ * @param lines Pointer to the list of lines.
+ * @param count Pointer to the number of lines in the list.
+ * @param capacity Pointer to the allocated size of the list.
+ * @param line The start of the row in the source.
+ * @param row The row as processed by the pre-assembler: its characters from the source, then its newlines.
+ */
+static void add_row(struct Arena* arena, struct LineView** lines, int* count, int* capacity, const char* line, const char* row);
 
 /**
  * @brief Manages the macro table by adding, retrieving, or performing other actions on macros.
  *
+ * @param ctx The context of the file being processed (holds the macro table).
  * @param name The name of the macro to manage.
- * @param body The body of the macro (used when adding a new macro).
- * @param macro_table A pointer to the macro table (array of Macro structures).
- * @param macro_table_size A pointer to the size of the macro table.
+ * @param body The row to add to the body of the macro (used when finding a macro), or NULL.
+ * @param line The start of that row in the source.
  * @param action The action to perform (e.g., add, retrieve, etc.).
- * @param dest The destination file for writing (if applicable).
  * @return int Returns a status code indicating success or failure.
  *
  * @note Assumes that the macro table is dynamically allocated and can grow as needed.
  *       The function handles memory allocation for new macros.
  */
-static int macro_table_management(char* name, char* body, struct Macro** macro_table, int* macro_table_size, int action, FILE* dest);
+static int macro_table_management(struct AssemblerContext* ctx, char* name, char* body, const char* line, int action);
 
 /**
  * @brief Adds a macro name to the macro table, and check it's validtaion.
  *
+ * @param ctx The context of the file being processed (holds the macro table).
  * @param r The current row number in the source file (used for error reporting).
  * @param name The name of the macro to add.
- * @param macro_table A pointer to the macro table (array of Macro structures).
- * @param macro_table_size A pointer to the size of the macro table.
  * @return int Returns a status code indicating success or failure.
  *
  * @note Assumes that the macro name is unique and does not already exist in the table.
  *       If the table is full, it will be resized to accommodate the new macro.
  */
-static int add_macro_name(int r, char* name, struct Macro** macro_table, int* macro_table_size);
+static int add_macro_name(struct AssemblerContext* ctx, int r, char* name);
 
 /**
  * @brief Processes a row that defines a macro, extracting its name and body.
  *
+ * @param ctx The context of the file being processed (holds the macro table).
  * @param row The current row from the source file.
  * @param r The current row number in the source file (used for error reporting).
- * @param macro_table A pointer to the macro table (array of Macro structures).
- * @param macro_table_size A pointer to the size of the macro table.
  * @param word A buffer to store the extracted macro name.
  * @return int Returns a status code indicating success or failure.
  *
  * @note Assumes that the row contains a valid macro definition.
  *       The function will parse the row and update the macro table accordingly.
  */
-static int macro_definition_row(char* row, int r, struct Macro** macro_table, int* macro_table_size, char* word, int* isDefinition);
+static int macro_definition_row(struct AssemblerContext* ctx, char* row, int r, char* word, int* isDefinition);
 
 /**
- * @brief Writes a row to the destination file, expanding macros if necessary.
+ * @brief Adds a row to the expanded source of the file, expanding macros if necessary.
  *
+ * @param ctx The context of the file being processed (holds the macro table).
  * @param row The current row from the source file.
- * @param dest The destination file for writing.
+ * @param line The start of the row in the source.
  * @param r The current row number in the source file (used for error reporting).
- * @param macro_table A pointer to the macro table (array of Macro structures).
- * @param macro_table_size A pointer to the size of the macro table.
  * @param macro_name A buffer to store the name of the macro being expanded (if applicable).
  *
  * @note Assumes that the row may contain a macro invocation.
- *       If a macro is found, its body will be written to the destination file instead of the macro name.
+ *       If a macro is found, its body will be written to the expanded source instead of the macro name.
  */
-static int write_row_pre(char* row, FILE* dest, int r, struct Macro** macro_table, int* macro_table_size, char* macro_name);
+static int write_row_pre(struct AssemblerContext* ctx, char* row, const char* line, int r, char* macro_name);
 
 
 /**
  * @brief Expands the macro table by doubling its size
  * 
- * This function doubles the size of the macro table by reallocating memory
- * and initializes the new memory slots to zero. If reallocation fails,
+ * This function doubles the size of the macro table in the arena of the file
+ * and initializes the new memory slots to zero. If allocation fails,
  * the program terminates with an error message.
  *
+ * @param arena The arena the macro table was allocated from
  * @param macro_table Pointer to the pointer of the macro table to be expanded
  * @param macro_table_size Pointer to the current size of the macro table
  * @return struct Macro* Pointer to the newly allocated macro table
  * @note The original macro table size is doubled
- * @warning Exits program if memory reallocation fails
+ * @warning Exits program if memory allocation fails
  */
-static struct Macro* expand_macro_table(struct Macro** macro_table, int* macro_table_size) {
-   struct Macro* new_table;
+static struct Macro* expand_macro_table(struct Arena* arena, struct Macro** macro_table, int* macro_table_size) {
    int old_size = *macro_table_size;
    
-   *macro_table_size *= 2; /* Double the table size for reallocation */
-   new_table = realloc(*macro_table, (*macro_table_size) * sizeof(struct Macro)); /* Reallocate memory */
-   
-   if (new_table == NULL) { /* Check if reallocation failed */
-      perror("Error reallocating memory for macro table");
-      exit(EXIT_FAILURE);
-   }
-   
-   /* Initialize new memory slots */
-   memset(&new_table[old_size], 0, ((*macro_table_size) - old_size) * sizeof(struct Macro));
-   
-   return new_table;
+   *macro_table_size *= 2; /* Double the table size */
+
+   /* The new memory slots are zeroed by the arena */
+   return (struct Macro*)arena_grow(arena, *macro_table, old_size * sizeof(struct Macro), (*macro_table_size) * sizeof(struct Macro));
+}
+
+static const char* macro_name_key(const void* table, int id) {
+   return ((const struct Macro*)table)[id].name;
+}
+
+int find_macro(struct AssemblerContext* ctx, const char* name, size_t length) {
+   ctx->stats.macro_lookups++;
+   return hash_index_find(&ctx->macro_index, name, length, macro_name_key, ctx->macro_table);
+}
+
+static void add_row(struct Arena* arena, struct LineView** lines, int* count, int* capacity, const char* line, const char* row) {
+   struct LineView view; /* The current line */
+   int length, newlines; /* Characters of the row from the source and newlines after them */
+
+   length = (int)strcspn(row, "\n");
+   newlines = (int)strlen(row + length);
+
+   do {
+      view.text = line;
+      view.length = length < MAX - 1 ? length : MAX - 1;
+      view.newline = view.length < MAX - 1 && newlines > 0; /* A line ends at its first newline */
+      append_lines(arena, lines, count, capacity, &view, 1);
+
+      line += view.length;
+      length -= view.length;
+      newlines -= view.newline;
+   } while (length > 0 || newlines > 0);
 }
 
-static int macro_table_management(char* name, char* body, struct Macro** macro_table, int* macro_table_size, int action, FILE* dest) {
-   int i; /* Loop index for traversing the macro table */
+static int macro_table_management(struct AssemblerContext* ctx, char* name, char* body, const char* line, int action) {
+   int i; /* Index of the macro in the macro table */
+   struct Macro* macro; /* The macro found */
 
    if (action == ADD_NAME) { /* Handle adding a new macro name */
-      for (i = 0; i < *macro_table_size; i++) {
-         if ((*macro_table)[i].name == NULL) { /* Find an empty slot in the table */
-            (*macro_table)[i].name = myStrdup(name); /* Duplicate the macro name */
-            return TRUE; /* Successfully added the macro name */
-         }
-      }
-      
-      *macro_table = expand_macro_table(macro_table, macro_table_size); /* Update the macro table pointer */
-      (*macro_table)[i].name = myStrdup(name); /* Add the new macro name */
+      if (ctx->macro_count == ctx->macro_table_size) /* No empty slot after the last macro */
+         ctx->macro_table = expand_macro_table(&ctx->arena, &ctx->macro_table, &ctx->macro_table_size); /* Update the macro table pointer */
+
+      i = ctx->macro_count++;
+      ctx->macro_table[i].name = arena_strdup(&ctx->arena, name); /* Duplicate the macro name */
+      if (find_macro(ctx, name, strlen(name)) == NO) /* A macro defined again keeps its first definition */
+         hash_index_insert(&ctx->macro_index, name, strlen(name), i);
       return TRUE; /* Successfully added the macro name */
    }
 
    else if (action == FIND_NAME) { /* Handle finding a macro name */
-      for (i = 0; i < *macro_table_size; i++) {
-         if ((*macro_table)[i].name != NULL && strcmp((*macro_table)[i].name, name) == 0) { /* Check for a match */
-            if (body == NULL) { /* If no body is provided, return success */
-               return TRUE;
-            }
-            if ((*macro_table)[i].body == NULL) { /* If the macro body is empty */
-               (*macro_table)[i].body = myStrdup(body); /* Duplicate the body */
-            }
-            else { /* Append the new body to the existing body */
-               char* new_body = malloc(strlen((*macro_table)[i].body) + strlen(body) + 1); /* Allocate memory for concatenation */
-               if (new_body == NULL) { /* Check if allocation failed */
-                  perror("Error allocating memory for macro body");
-                  exit(EXIT_FAILURE);
-               }
-               strcpy(new_body, (*macro_table)[i].body); /* Copy the existing body */
-               strcat(new_body, body); /* Append the new body */
-               free((*macro_table)[i].body); /* Free the old body */
-               (*macro_table)[i].body = new_body; /* Update the body pointer */
-            }
-            return TRUE; /* Successfully updated the macro body */
-         }
+      if ((i = find_macro(ctx, name, strlen(name))) == NO)
+         return FALSE; /* Macro name not found */
+      if (body == NULL) { /* If no body is provided, return success */
+         return TRUE;
       }
-      return FALSE; /* Macro name not found */
+      /* Add the new row to the body, as a view into the source */
+      macro = &ctx->macro_table[i];
+      add_row(&ctx->arena, &macro->body, &macro->body_count, &macro->body_capacity, line, body);
+      return TRUE; /* Successfully updated the macro body */
    }
 
    
    else if (action == PRINT) { /* Handle printing a macro body */
-      char* trimmed_name = myStrdup(name); /* Duplicate the macro name */
-      if (trimmed_name != NULL) {
-         trimmed_name[strcspn(trimmed_name, "\n")] = '\0'; /* Remove trailing newline */
-         for (i = 0; i < *macro_table_size; i++) {
-            if ((*macro_table)[i].name != NULL) { /* Check if the slot is not empty */
-               if (strcmp((*macro_table)[i].name, trimmed_name) == 0) { /* Check for a match */
-                  fputs((*macro_table)[i].body, dest); /* Write the macro body to the destination */
-                  free(trimmed_name); /* Free the duplicated name */
-                  return TRUE; /* Successfully printed the macro body */
-               }
-            }
-         }
-         free(trimmed_name); /* Free the duplicated name if no match is found */
+      /* The row is a macro invocation if all of it, up to the newline, is a macro name */
+      if ((i = find_macro(ctx, name, strcspn(name, "\n"))) != NO) {
+         macro = &ctx->macro_table[i];
+         if (macro->body_count > 0) /* A macro may have an empty body */
+            append_lines(&ctx->arena, &ctx->lines, &ctx->line_count, &ctx->line_capacity, macro->body, macro->body_count); /* Add the views of the macro body to the expanded source */
+         return TRUE; /* Successfully printed the macro body */
       }
    }
    return FALSE; /* Action not successful */
 }
 
-static int add_macro_name(int r, char* name, struct Macro** macro_table, int* macro_table_size) {
+static int add_macro_name(struct AssemblerContext* ctx, int r, char* name) {
    int i; /* Loop index for validating the macro name */
 
    /* Check if the macro name exceeds the maximum allowed length */
    if (strlen(name) > MAX_MACRO_NAME) {
-      printf("Error - line %d: the macro name (%s) is too long.\n", r, name);
+      report_message(ctx, "Error - line %d: the macro name (%s) is too long.\n", r, name);
       return FALSE;
    }
 
    /* Check if the macro name is a reserved word */
    if (reserved_word(name)) {
-      printf("Error - line %d: the macro name (%s) is a reserved word.\n", r, name);
+      report_message(ctx, "Error - line %d: the macro name (%s) is a reserved word.\n", r, name);
       return FALSE;
    }
 
    /* Check if the macro name starts with a valid character (letter or underscore) */
    if (!isalpha(name[0]) && name[0] != '_') {
-      printf("Error - line %d: the macro name (%s) is not valid.\n", r, name);
+      report_message(ctx, "Error - line %d: the macro name (%s) is not valid.\n", r, name);
       return FALSE;
    }
 
    /* Validate the rest of the macro name (alphanumeric or underscore) */
    for (i = 1; name[i] != '\0'; i++) {
       if (!isalnum(name[i]) && name[i] != '_') {
-         printf("Error - line %d: the macro name (%s) is not valid.\n", r, name);
+         report_message(ctx, "Error - line %d: the macro name (%s) is not valid.\n", r, name);
          return FALSE;
       }
    }
 
    /* Add the macro name to the macro table */
-   return macro_table_management(name, NULL, macro_table, macro_table_size, ADD_NAME, NULL);
+   return macro_table_management(ctx, name, NULL, NULL, ADD_NAME);
 }
 
 
-static int macro_definition_row(char* row, int r, struct Macro** macro_table, int* macro_table_size, char* word, int* isDefinition) {
+static int macro_definition_row(struct AssemblerContext* ctx, char* row, int r, char* word, int* isDefinition) {
    int i; /* Index for traversing the row */
    char* pos; /* Pointer to locate the "mcro" keyword in the row */
 
@@ -215,28 +234,27 @@ static int macro_definition_row(char* row, int r, struct Macro** macro_table, in
    pos = strstr(row, "mcro ");
    if (pos != NULL) {
       if (pos != row) { /* Ensure "mcro" starts at the beginning of the line */
-         printf("Error - line %d: macro definition must start at the beginning of the line.\n", r);
-         printf("The line text: %s", row);
+         report_message(ctx, "Error - line %d: macro definition must start at the beginning of the line.\n", r);
+         report_message(ctx, "The line text: %s", row);
          return FALSE;
       }
 
       /* Extract the macro name after "mcro" */
       i = copy_word(row, word, MCRO_LENGTH+1);
       if (row[i] != '\n') { /* Ensure no extra characters after the macro name */
-         printf("Error - line %d: additional characters on a line after finishing a macro definition.\n", r);
-         printf("The line text: %s", row);
+         report_message(ctx, "Error - line %d: additional characters on a line after finishing a macro definition.\n", r);
+         report_message(ctx, "The line text: %s", row);
          return FALSE;
       }
 
       /* Add the macro name to the macro table and set the definition flag */
-      *isDefinition = add_macro_name(r, word, macro_table, macro_table_size);
+      *isDefinition = add_macro_name(ctx, r, word);
       return *isDefinition; /* Return the status of adding the macro name */
    }
    return TRUE; /* Return TRUE if no macro definition is found (so there are no errors in macro definition)*/
 }
 
-static int write_row_pre(char* row, FILE* dest, int r, 
-   struct Macro** macro_table, int* macro_table_size, char* macro_name) {
+static int write_row_pre(struct AssemblerContext* ctx, char* row, const char* line, int r, char* macro_name) {
    char* i; /* Pointer for string operations */
    int isDefinition; /* Flag to indicate if a macro definition is being processed */
 
@@ -249,24 +267,24 @@ static int write_row_pre(char* row, FILE* dest, int r,
       if ((i != NULL) && (i == row || isspace(*(i - 1))) && (isspace(*(i + MACRO_END_LENGTH)))) {
          isDefinition = FALSE; /* Reset the flag as the macro definition ends */
          if (i != row) { /* Ensure "mcroend" starts at the beginning of the line */
-            printf("Error - line %d: macro end must start at the beginning of the line.\n", r);
-            printf("The line text: %s", row);
+            report_message(ctx, "Error - line %d: macro end must start at the beginning of the line.\n", r);
+            report_message(ctx, "The line text: %s", row);
             return FALSE;
          }
          if (*(i + MACRO_END_LENGTH) != '\n' && *(i + MACRO_END_LENGTH) != '\0') { /* Check for extra characters after "mcroend" */
-            printf("Error - line %d: additional characters on a line after 'mcroend'.\n", r);
-            printf("The line text: %s", row);
+            report_message(ctx, "Error - line %d: additional characters on a line after 'mcroend'.\n", r);
+            report_message(ctx, "The line text: %s", row);
             return FALSE;
          }
          macro_name[0] = '\0'; /* Clear the macro name to indicate no active macro */
          return TRUE;
       }
       /* Add the current row to the macro body in the macro table */
-      return macro_table_management(macro_name, row, macro_table, macro_table_size, FIND_NAME, dest);
+      return macro_table_management(ctx, macro_name, row, line, FIND_NAME);
    }
 
    /* Check if the row defines a new macro */
-   if (macro_definition_row(row, r, macro_table, macro_table_size, macro_name, &isDefinition) == FALSE) {
+   if (macro_definition_row(ctx, row, r, macro_name, &isDefinition) == FALSE) {
       return FALSE; /* Return FALSE if the macro definition is invalid */
    }
    if (isDefinition == TRUE) { /* If a macro definition starts, skip further processing */
@@ -274,63 +292,59 @@ static int write_row_pre(char* row, FILE* dest, int r,
    }
 
    /* Check if the row is a macro invocation and print its body */
-   if (macro_table_management(row, NULL, macro_table, macro_table_size, PRINT, dest) == TRUE) {
+   if (macro_table_management(ctx, row, NULL, NULL, PRINT) == TRUE) {
       return TRUE;
    }
 
-   /* If the row is neither a macro definition nor invocation, write it as-is */
-   fputs(row, dest);
+   /* If the row is neither a macro definition nor invocation, add it as-is */
+   add_row(&ctx->arena, &ctx->lines, &ctx->line_count, &ctx->line_capacity, line, row);
    return TRUE;
 }
 
-int read_row_pre(const char* file, FILE* source, FILE* dest, struct Macro** macro_table, int* macro_table_size) {
-   int r, row_size, inputValidation; /* r: line number, row_size: buffer size for row, inputValidation: status flag */
+int read_row_pre(struct AssemblerContext* ctx, const char* source, size_t length) {
+   int r; /* r: line number */
    char macro_name[MAX_MACRO_NAME] = {0}; /* Stores the current macro name being processed */
-   char* temp; /* Temporary pointer for reallocating memory */
+   char row[MAX + 1]; /* The current row: up to MAX - 1 characters, the newline added to a truncated row and the null terminator */
+   const char* line, * end, * newline; /* Start of the current line, end of the source and the newline of the line */
+   size_t next, content; /* Distance to the next line, length of the line without its newline */
+   int has_newline, row_length; /* TRUE if the line ends with a newline, length of the row (with its newline) */
    
-   r = 1, row_size = INITIAL_ROW_SIZE, inputValidation = TRUE; /* Initialize variables */
-   
-   char* row = (char*)malloc(row_size * sizeof(char)); /* Allocate memory for the row buffer */
-   if (row == NULL) { /* Check if memory allocation failed */
-      perror("Error allocating memory for row");
-      exit(EXIT_FAILURE);
-   }
+   r = 1; /* Initialize variables */
+
+   for (line = source, end = source + length; line < end; line += next) { /* Go over the lines of the source */
+      ctx->stats.source_lines++;
 
-   while (fgets(row, row_size, source)) { /* Read each line from the source file */
-      if(row[0] == '\0' || row[0] == '\n' || row[0] == ';') { /* Skip empty lines or comments */
+      /* Find the end of the line and the start of the next one */
+      newline = (const char*)memchr(line, '\n', end - line);
+      has_newline = newline != NULL;
+      next = has_newline ? (size_t)(newline - line) + 1 : (size_t)(end - line);
+      content = next - has_newline;
+      if (content > 0 && line[content - 1] == '\r') /* A CRLF (or a trailing \r) ends the line like a newline */
+         content--;
+
+      if (content == 0 || line[0] == ';' || line[0] == '\0') { /* Skip empty lines or comments, whatever their length */
          continue;
       }
-      while (strlen(row) == row_size - 1 && row[row_size - 2] != '\n') { /* Handle long lines */
-         row_size *= 2; /* Double the buffer size */
-         temp = (char*)realloc(row, row_size * sizeof(char)); /* Reallocate memory for the row buffer */
-         if (temp == NULL) { /* Check if memory reallocation failed */
-            free(row);
-            perror("Error reallocating memory for row");
-            exit(EXIT_FAILURE);
-         }
-         row = temp;
-         if (!fgets(row + row_size/2 - 1, row_size/2 + 1, source)) { /* Read remaining content */
-            break;
-         }
-      }
 
-      if (strlen(row) >= INITIAL_ROW_SIZE - 1) { /* Check if the line exceeds the initial buffer size */
-         printf("Error - line %d: line is too long.\n", r);
-         printf("The line text: %s", row);
+      /* Copy the line into the row, with its newline, up to the maximum row length */
+      row_length = content + has_newline < INITIAL_ROW_SIZE - 1 ? (int)(content + has_newline) : INITIAL_ROW_SIZE - 1;
+      memcpy(row, line, content < (size_t)row_length ? content : (size_t)row_length);
+      if ((size_t)row_length > content)
+         row[content] = '\n';
+      row[row_length] = '\0';
+
+      if (content + has_newline >= INITIAL_ROW_SIZE - 1) { /* Check if the line exceeds the maximum row length */
+         report_message(ctx, "Error - line %d: line is too long.\n", r);
+         report_message(ctx, "The line text: %.*s%s", (int)content, line, has_newline ? "\n" : "");
          row[INITIAL_ROW_SIZE - 1] = '\n'; /* Truncate the line */
          row[INITIAL_ROW_SIZE] = '\0'; /* Null-terminate the string */
       }
 
-      /* Remove trailing \r if exists */
-      if (row[strlen(row)-1] == '\r')
-         row[strlen(row)-1] = '\0';
-      if(write_row_pre(row, dest, r, macro_table, macro_table_size, macro_name) == FALSE) { /* Process the row */
-         inputValidation = FALSE; /* Update status flag if processing fails */
+      if(write_row_pre(ctx, row, line, r, macro_name) == FALSE) { /* Process the row */
+         ctx->input_validation = FALSE; /* Update status flag if processing fails */
       }
       r++; /* Increment the line number */
    }
 
-   free(row); /* Free the allocated memory for the row buffer */
-
-   return inputValidation; /* Return the status of the processing */
+   return ctx->input_validation; /* Return the status of the processing */
 }
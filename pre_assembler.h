@@ -2,6 +2,7 @@
 #define PRE_ASSEMBLER_H
 #include "auxiliary_functions_constants.h"
 #include "fixed_tables.h"
+#include "assembler_context.h"
 
 
 
@@ -10,25 +11,45 @@
  * @brief Defines a structure to store a macro's name and body.
  * @struct Macro
  * @param name Pointer to the macro's name string.
- * @param body Pointer to the macro's body content string.
+ * @param body The lines of the macro's body, as views into the source (expanding the macro copies the views, not the text).
+ * @param body_count The number of lines in the body.
+ * @param body_capacity The allocated size of `body`.
  */
 struct Macro {
     char* name; /* Pointer to macro name */
-    char* body; /* Pointer to macro body */
+    struct LineView* body; /* Lines of the macro body */
+    int body_count, body_capacity; /* Number of lines and allocated size of the body */
 };
  
 /**
- * @brief Reads rows from the source file, processes macros, and writes the output to the destination file.
+ * @brief Finds a macro by its name.
  *
- * @param file The name of the source file being processed.
- * @param source The source file pointer.
- * @param dest The destination file pointer.
- * @param macro_table A pointer to the macro table (array of Macro structures).
- * @param macro_table_size A pointer to the size of the macro table.
+ * The lookup goes through the hash index of the macro table and does not allocate, so the name
+ * can be borrowed from a row (it does not have to be null-terminated).
+ *
+ * @param ctx The context of the file being processed (holds the macro table and its index).
+ * @param name The name to find.
+ * @param length The number of characters of the name.
+ * @return The index of the macro in the macro table, or NO if there is no macro with that name.
+ */
+int find_macro(struct AssemblerContext* ctx, const char* name, size_t length);
+
+/**
+ * @brief Reads rows from the source, processes macros, and adds the lines of the expanded source to the context.
+ *
+ * @param ctx The context of the file being processed (holds the macro table and the expanded source).
+ * @param source The content of the source file. The lines of the expanded source point into it.
+ * @param length The length of the source in bytes.
+ * @return TRUE if no errors were found in the macro definitions, FALSE otherwise.
+ *
+ * The lines are found with memchr directly in the source (which may be a memory-mapped file). A CRLF
+ * ends a line like a newline, and empty lines and comments are skipped whole, whatever their length.
+ * No text is copied: a row becomes a view into the source, and a macro invocation copies the views
+ * of the macro body.
  *
  * @note Assumes that the source file is properly formatted and contains valid macro definitions.
- *       The function processes each row, expanding macros and writing the result to the destination file.
+ *       The function processes each row, expanding macros and appending the result to `ctx->lines`.
  */
-int read_row_pre(const char* file, FILE* source, FILE* dest, struct Macro** macro_table, int* macro_table_size);
+int read_row_pre(struct AssemblerContext* ctx, const char* source, size_t length);
 
 #endif /* PRE_ASSEMBLER_H */
\ No newline at end of file
@@ -6,8 +6,9 @@
  * @file second_path.c
  * @brief Implements the second pass of the assembler, processing symbols and generating machine code.
  *
- * This file contains functions for handling the second pass of the assembler. It processes rows of assembly code,
- * manages the symbols table, and generates the final machine code.
+ * This file contains functions for handling the second pass of the assembler. It goes over the commands
+ * decoded by the first pass (or over the fixups it recorded in one-pass mode), looks up the symbols of their
+ * operands in the symbols table, and completes the final machine code.
  *
  * @note This module assumes that the first pass has already been completed successfully.
  */
@@ -16,256 +17,134 @@
 
 
 /**
- * @brief Reads rows from a source file during the second pass of assembly processing.
+ * @brief Completes the operands of a decoded command with the addresses of their symbols.
  *
- * This function processes each row of the given source file, validates its content,
- * and updates the symbols table and other relevant data structures as needed.
+ * The words of the operands are found from the addressing methods of the command: the first word of the
+ * command is followed by a word for an immediate, direct or relative source operand, then by a word for
+ * the destination operand.
  *
- * @param file The name of the file being processed (used for error reporting).
- * @param source A pointer to the open file stream to read rows from.
- * @param cmd_code A pointer to an integer that stores the command code.
- * @param symbols_table A pointer to the symbols table, which is updated during processing.
- * @param symbols_table_size A pointer to the size of the symbols table.
- * @param isExternal A pointer to an integer flag indicating if the symbol is external.
- * @param isEntry A pointer to an integer flag indicating if the symbol is an entry.
- * @return int Returns TRUE if all rows are valid, otherwise FALSE.
- */
-static int read_row_second(const char* file, FILE* source, int* cmd_code, struct Symbol** symbols_table,
-   int* symbols_table_size, int* isExternal, int* isEntry);
-
-
-
-
-/**
- * @brief Processes a row in the second pass of an assembler and determines its type.
+ * @param ctx The context of the file being processed (symbols table, command code and flags).
+ * @param instruction The decoded command.
  *
- * This function analyzes a given row of assembly code during the second pass of the assembler.
- * It identifies the type of the row (directive, command, label) and performs the necessary
- * operations, such as managing the symbols table or processing commands.
+ * @return Returns TRUE (1) if the command was completed successfully, or FALSE (0) if an error occurred.
  *
- * @param row The input row of assembly code as a null-terminated string.
- * @param r The current row number in the source file.
- * @param symbols_table A pointer to the symbols table, which is an array of Symbol structures.
- * @param symbols_table_size A pointer to the size of the symbols table.
- * @param cmd_code A pointer to store the command code if the row contains a valid command.
- * @param isExternal A pointer to a flag indicating if the row references an external symbol.
- * @param isEntry A pointer to a flag indicating if the row contains an entry directive.
- * 
- * @return TRUE if the row is successfully processed or does not require further processing.
- *         Otherwise, returns an error code indicating the failure reason.
+ * @note Error messages are printed to the standard output in case of invalid symbols or addressing modes.
  */
-static int row_type_second(char* row, int r, struct Symbol** symbols_table, int* symbols_table_size,
-   int* cmd_code, int* isExternal, int* isEntry);
+static int symbol_command_code(struct AssemblerContext* ctx, struct Instruction* instruction);
 
 
 
 
 /**
- * @brief Processes a command row to determine the command code and updates the symbols table.
- *
- * This function analyzes a given row of assembly code, extracts symbols, and determines their
- * addressing modes. It updates the command code array and the symbols table accordingly.
- * The function also handles errors related to undefined symbols, invalid addressing modes,
- * and external symbols.
+ * @brief Fills the word of an operand with the address of its symbol.
  *
- * @param row The input row of assembly code as a string.
- * @param i The starting index in the row to begin processing.
- * @param cmd_code Pointer to the command code array to be updated.
- * @param symbols_table Pointer to the symbols table array.
- * @param symbols_table_size Pointer to the size of the symbols table.
- * @param r The current line number in the source code (used for error reporting).
- * @param isExternal Pointer to a flag indicating if an external symbol was encountered.
- * 
- * @return Returns TRUE (1) if the row was processed successfully, or FALSE (0) if an error occurred.
+ * This function looks the symbol up in the symbols table, and handles errors related to undefined
+ * symbols, data symbols used with relative addressing, and external symbols used with relative
+ * addressing. Uses of external symbols are added to the symbols table.
  *
- * @note The function assumes that the symbols table and command code array are properly initialized.
- *       It also assumes that the input row is null-terminated.
- * @note The function modifies the global variable IC (Instruction Counter).
- * @note Error messages are printed to the standard output in case of invalid symbols or addressing modes.
+ * @param ctx The context of the file being processed (symbols table, command code and flags).
+ * @param name The name of the symbol.
+ * @param relative TRUE for relative addressing, FALSE for direct addressing.
+ * @param slot The index of the operand word in the command code array.
+ * @param r The line of the operand in the source code (used for error reporting).
+ * @return TRUE if the symbol was resolved, FALSE if an error was found.
  */
-static int symbol_command_code(char* row, int i, int* cmd_code, struct Symbol** symbols_table,
-   int* symbols_table_size, int r, int* isExternal);
-
-
-
+static int resolve_operand(struct AssemblerContext* ctx, char* name, int relative, int slot, int r);
 
 
-extern int IC, DC; /* IC: Instruction Counter, DC: Data Counter - shared across modules */
 
 
+static int resolve_operand(struct AssemblerContext* ctx, char* name, int relative, int slot, int r) {
+   int j; /* Index of the symbol in the symbols table */
 
+   if ((j = symbols_table_management(ctx, name, 0, FIND_NAME, 0, r, 0)) == NO) { /* Undefined symbol */
+      report_message(ctx, "Error - line %d: One of the operands (%s) is an undefined label, or there are extraneous characters surrounding it.\n", r, name);
+      return FALSE;
+   }
 
-
-static int symbol_command_code(char* row, int i, int* cmd_code, struct Symbol** symbols_table,
-   int* symbols_table_size, int r, int* isExternal) {
-   int word2, j, isAnd; /* word2: stores calculated address, j: index in symbols table, isAnd: flag for relative addressing */
-   char word1[MAX] = { 0 }; /* word1: buffer to store extracted word */
-   word2 = 0;
-
-   IC++; /* Increment instruction counter for the current command */
-
-   while (row[i] != '\n' && row[i] != '\0') { /* Process the row until end of line or null terminator */
-      isAnd = FALSE; /* Reset relative addressing flag */
-      i = copy_word_jump_space(row, word1, i); /* Extract the next word from the row */
-
-      if (word1[0] == '#') { /* Immediate addressing mode */
-         IC++; /* Increment IC for immediate value */
-      }
-      if (word1[0] == '\0' || word1[0] == 'r' || word1[0] == '#') { /* Skip empty words, registers, or immediate values */
-         continue;
-      }
-
-      if (word1[0] == '&') { /* Relative addressing mode */
-         memmove(word1, word1 + 1, strlen(word1)); /* Remove '&' from the word */
-         isAnd = TRUE; /* Mark as relative addressing */
-      }
-      if ((j = symbols_table_management(word1, NULL, symbols_table, symbols_table_size, FIND_NAME, 0, r, NULL, 0, 0)) != NO) {
-         /* Check if the symbol exists in the symbols table */
-         if (((*symbols_table)[j].type != NULL) && (strstr((*symbols_table)[j].type, "external") == NULL)) {
-            /* If the symbol is not external */
-            if (isAnd == TRUE) { /* Handle relative addressing */
-               if(strstr((*symbols_table)[j].type, "data") != NULL){ /* Check if symbol is a data symbol */
-                  printf("Error - line %d: the symbol (%s) is a data symbol, and cannot be used with relative addressing.\n", r, word1);
-                  return FALSE; /* Return error for invalid relative addressing */
-               }
-               word2 = (symbols_table_management(word1, NULL, symbols_table, symbols_table_size, GET_ADDRESS, 0, r, NULL, 0, j) - (IC + 100) + 1) << ARE_BITS;
-               cmd_code[IC] = word2 + A; /* Store calculated address with absolute flag */
-            }
-            else { /* Direct addressing */
-               word2 = symbols_table_management(word1, NULL, symbols_table, symbols_table_size, GET_ADDRESS, 0, r, NULL, 0, j);
-               cmd_code[IC] = ((word2) << ARE_BITS) + R; /* Store address with relocatable flag */
-            }
-
-         }
-         else { /* Handle external symbols */
-            if (isAnd == TRUE) { /* Relative addressing is invalid for external symbols */
-               printf("Error - line %d: the symbol (%s) is an external symbol, and cannot be used with relative addressing.\n", r, word1);
-               return FALSE; /* Return error */
-            }
-            cmd_code[IC] = E; /* Mark as external */
-            symbols_table_management(NULL, NULL, symbols_table, symbols_table_size, ADD_EXTERNAL_ADDRESS, IC + 100, r, NULL, 0, j);
-            *isExternal = TRUE; /* Mark that an external symbol was encountered */
+   if (!(ctx->symbols_table[j].kind & SYMBOL_EXTERNAL)) { /* The symbol is not external */
+      if (relative) {
+         if (ctx->symbols_table[j].kind & SYMBOL_DATA) { /* Data symbols cannot be jumped to */
+            report_message(ctx, "Error - line %d: the symbol (%s) is a data symbol, and cannot be used with relative addressing.\n", r, name);
+            return FALSE;
          }
+         word_store_set(&ctx->arena, &ctx->cmd_code, slot, ((ctx->symbols_table[j].address - (slot + 100) + 1) << ARE_BITS) + A); /* Distance with absolute flag */
       }
-      else { /* Undefined symbol */
-         printf("Error - line %d: One of the operands (%s) is an undefined label, or there are extraneous characters surrounding it.\n", r, word1);
-         return FALSE; /* Return error for undefined label */
-      }
-
-      IC++; /* Increment instruction counter for the next word */
+      else
+         word_store_set(&ctx->arena, &ctx->cmd_code, slot, (ctx->symbols_table[j].address << ARE_BITS) + R); /* Address with relocatable flag */
+      return TRUE;
    }
 
-   return TRUE; /* Successfully processed the row */
+   /* External symbol */
+   if (relative) {
+      report_message(ctx, "Error - line %d: the symbol (%s) is an external symbol, and cannot be used with relative addressing.\n", r, name);
+      return FALSE;
+   }
+   word_store_set(&ctx->arena, &ctx->cmd_code, slot, E); /* Mark as external */
+   symbols_table_management(ctx, NULL, 0, ADD_EXTERNAL_ADDRESS, slot + 100, r, j);
+   ctx->isExternal = TRUE; /* Mark that an external symbol was encountered */
+   return TRUE;
 }
 
 
 
 
+static int symbol_command_code(struct AssemblerContext* ctx, struct Instruction* instruction) {
+   int k, slot, mode; /* k: operand index, slot: index of the operand word, mode: addressing method */
 
-static int row_type_second(char* row, int r, struct Symbol** symbols_table, int* symbols_table_size,
-   int* cmd_code, int* isExternal, int* isEntry) {
-   char word1[MAX]; /* Buffer to store the first word in the row */
-   int i, c; /* i: index in the row, c: command code index */
-
-   i = 0; /* Initialize index to 0 */
-   if (row[0] == '\n' || row[0] == '\0' || row[0] == ';') {
-      /* Skip empty lines or comments */
-      return TRUE;
-   }
-
-   i = copy_word_jump_space(row, word1, i); /* Extract the first word from the row */
-
-   if (strcmp(word1, ".entry") == 0) {
-      /* Handle .entry directive */
-      i = copy_word_jump_space(row, word1, i); /* Extract the symbol name */
-      *isEntry = TRUE; /* Mark that an entry symbol exists */
-      return symbols_table_management(word1, "entry", symbols_table, symbols_table_size, ADD_TYPE, 0, r, NULL, 0, 0);
-   }
-
-   if ((c = cmd_table(word1)) != NO) {
-      /* If the word is a valid command, process it */
-      return symbol_command_code(row, i, cmd_code, symbols_table, symbols_table_size, r, isExternal);
+   slot = instruction->ic + 1; /* The operand words follow the first word */
+   for (k = 0; k < 2; k++) {
+      mode = instruction->modes[k];
+      if (mode == NO || mode == REGISTER_ADDRESSING) /* No operand, or a register inside the first word */
+         continue;
+      if (mode != IMMEDIATE_ADDRESSING &&
+          !resolve_operand(ctx, ctx->operand_names.text + instruction->operands[k], mode == RELATIVE_ADDRESSING, slot, instruction->line))
+         return FALSE;
+      slot++;
    }
 
-   if (isalpha(row[0])) {
-      /* Check if the row starts with a label */
-      if (row[i] == ':' && isspace(row[i + 1])) {
-         i = copy_word_jump_space(row, word1, i + 1); /* Extract the word after the label */
-         if ((strcmp(word1, ".data") == 0) || (strcmp(word1, ".string") == 0) || (strcmp(word1, ".extern") == 0)) {
-            /* Skip .data, .string, and .extern directives */
-            return TRUE;
-         }
-         if ((c = cmd_table(word1)) != NO) {
-            /* If the word is a valid command, process it */
-            return symbol_command_code(row, i, cmd_code, symbols_table, symbols_table_size, r, isExternal);
-         }
-      }
-   }
-   return TRUE; /* Return TRUE for rows that don't require further processing */
+   return TRUE; /* Successfully completed the command */
 }
 
 
 
 
-static int read_row_second(const char* file, FILE* source, int* cmd_code, struct Symbol** symbols_table,
-   int* symbols_table_size, int* isExternal, int* isEntry) {
-   char row[MAX]; /* Buffer to store each line of the source file */
-   int r, InputValidation; /* r: current row number, InputValidation: flag for overall validation */
-
-   r = 1; /* Initialize row number to 1 */
-   InputValidation = TRUE; /* Assume input is valid initially */
+int resolve_fixups(struct AssemblerContext* ctx) {
+   int k, failed_line; /* k: index of the fixup, failed_line: the last line with an error */
+   struct Fixup* fixup; /* The current fixup */
 
-   /* Read the source file line by line */
-   while (fgets(row, MAX, source)) {
-      /* Process the current row and update validation status */
-      if (row_type_second(row, r, symbols_table, symbols_table_size, cmd_code, isExternal, isEntry) == FALSE)
-         InputValidation = FALSE; /* Mark as invalid if any row fails validation */
+   ctx->isExternal = FALSE; /* Set again for every use of an external symbol */
+   word_store_reserve(&ctx->arena, &ctx->cmd_code, ctx->ICF); /* The last operand word may be past the written code */
 
-      r++; /* Increment row number */
+   /* Like the second path, stop at the first error in a line and go on with the next lines */
+   for (k = 0, failed_line = NO; k < ctx->fixup_count; k++) {
+      fixup = &ctx->fixups[k];
+      if (fixup->line == failed_line)
+         continue;
+      if (!resolve_operand(ctx, ctx->operand_names.text + fixup->name, fixup->relative, fixup->slot, fixup->line)) {
+         failed_line = fixup->line;
+         ctx->input_validation = FALSE;
+      }
    }
 
-   return InputValidation; /* Return the overall validation status */
+   return ctx->input_validation;
 }
 
 
 
 
-int second_path(const char* filename, struct Symbol* symbols_table, int symbols_table_size,
-   int* cmd_code, int* data_code, int ICF, int DCF)
+int second_path(struct AssemblerContext* ctx)
 {
-   FILE* source; /* Pointer to the source file */
-   int input_validation, isExternal, isEntry; /* Flags for validation, external symbols, and entry symbols */
-   char amFilename[256]; /* Buffer to hold the filename with .am extension */
-
-   isEntry = FALSE; /* Initialize entry flag to FALSE */
-   isExternal = FALSE; /* Initialize external flag to FALSE */
-
-   /* Construct the filename with .am extension */
-   sprintf(amFilename, "%s%s", filename, ".am");
-   source = fopen(amFilename, "r"); /* Open the source file for reading */
-   if (source == NULL) {
-      perror("Error opening source file"); /* Print error if file cannot be opened */
-      exit(EXIT_FAILURE); /* Exit the program with failure status */
-   }
-
-   IC = 0, DC = 0; /* Reset instruction counter (IC) and data counter (DC) */
-   
-   /* Process the source file row by row during the second pass */
-   input_validation = read_row_second(filename, source, cmd_code, &symbols_table, &symbols_table_size, &isExternal, &isEntry);
+   int k; /* Index of the decoded command */
 
-   fclose(source); /* Close the source file */
+   ctx->isExternal = FALSE; /* Initialize external flag to FALSE (the entry flag is set by the first path) */
+   word_store_reserve(&ctx->arena, &ctx->cmd_code, ctx->ICF); /* The last operand word may be past the written code */
 
-   if (input_validation) {
-      /* If no errors, generate output files */
-      printf("No errors in the input file: %s, generating its output files.\n", filename);
-      output(filename, cmd_code, data_code, symbols_table, symbols_table_size, ICF, DCF, isExternal, isEntry);
-      return TRUE; /* Return success */
+   /* Complete the decoded commands one by one */
+   for (k = 0; k < ctx->instruction_count; k++) {
+      if (symbol_command_code(ctx, &ctx->instructions[k]) == FALSE)
+         ctx->input_validation = FALSE; /* Mark as invalid if any command fails */
    }
-   else {
-      /* If errors exist, do not generate output files */
-      printf("Errors in the input file: %s, not generating its output files.\n", filename);
-      return FALSE; /* Return failure */
-   }
-
 
-}
\ No newline at end of file
+   return ctx->input_validation; /* Return the overall validation status */
+}
@@ -8,23 +8,32 @@
 /**
  * @brief Performs the second pass of the assembler process on the given source file.
  * 
- * This function reads the preprocessed assembly file, validates its content, and generates
- * the necessary output files if no errors are found. It also updates the symbol table and
- * checks for external and entry symbols.
+ * This function goes over the commands decoded by the first pass, without reading the source again,
+ * and completes the command code with the addresses of the symbols of their operands. It also records
+ * the uses of external symbols in the symbols table. Writing the output files is left to the caller.
  * 
- * @param filename The name of the source file (without extension).
- * @param symbols_table Pointer to the symbol table array.
- * @param symbols_table_size The size of the symbol table array.
- * @param cmd_code Pointer to the command code array.
- * @param data_code Pointer to the data code array.
- * @param ICF The final value of the instruction counter after the first pass.
- * @param DCF The final value of the data counter after the first pass.
+ * @param ctx The context of the file after a successful first pass (decoded commands, symbols table,
+ *            code arrays, ICF and DCF).
  * 
- * @return TRUE (1) if the second pass is successful and output files are generated, 
+ * @return TRUE (1) if the second pass is successful and the output can be generated, 
  *         FALSE (0) otherwise.
  */
-int second_path(const char* filename, struct Symbol* symbols_table, int symbols_table_size,
-   int* cmd_code, int* data_code, int ICF, int DCF);
+int second_path(struct AssemblerContext* ctx);
+
+
+
+/**
+ * @brief Completes the command code from the fixups recorded by the first path (one-pass mode).
+ *
+ * Replaces the second path: instead of going over all the decoded commands, every label operand recorded by
+ * the first path is looked up in the symbols table, its word is filled and the uses of external
+ * symbols are collected. The output and the error messages are the same as with the second path.
+ *
+ * @param ctx The context of the file after a successful first pass in one-pass mode.
+ *
+ * @return TRUE (1) if all the fixups were resolved and the output can be generated, FALSE (0) otherwise.
+ */
+int resolve_fixups(struct AssemblerContext* ctx);
 
 
 #endif /* SECOND_PATH_H */
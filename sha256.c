@@ -0,0 +1,127 @@
+#include <string.h>
+#include "sha256.h"
+
+#define WORD(x) ((x) & 0xFFFFFFFFUL)
+#define ROTATE(x, n) WORD(((x) >> (n)) | ((x) << (32 - (n))))
+
+
+/* The round constants: the first 32 bits of the fractional parts of the cube roots of the first 64 primes */
+static const unsigned long round_constants[64] = {
+   0x428a2f98UL, 0x71374491UL, 0xb5c0fbcfUL, 0xe9b5dba5UL, 0x3956c25bUL, 0x59f111f1UL, 0x923f82a4UL, 0xab1c5ed5UL,
+   0xd807aa98UL, 0x12835b01UL, 0x243185beUL, 0x550c7dc3UL, 0x72be5d74UL, 0x80deb1feUL, 0x9bdc06a7UL, 0xc19bf174UL,
+   0xe49b69c1UL, 0xefbe4786UL, 0x0fc19dc6UL, 0x240ca1ccUL, 0x2de92c6fUL, 0x4a7484aaUL, 0x5cb0a9dcUL, 0x76f988daUL,
+   0x983e5152UL, 0xa831c66dUL, 0xb00327c8UL, 0xbf597fc7UL, 0xc6e00bf3UL, 0xd5a79147UL, 0x06ca6351UL, 0x14292967UL,
+   0x27b70a85UL, 0x2e1b2138UL, 0x4d2c6dfcUL, 0x53380d13UL, 0x650a7354UL, 0x766a0abbUL, 0x81c2c92eUL, 0x92722c85UL,
+   0xa2bfe8a1UL, 0xa81a664bUL, 0xc24b8b70UL, 0xc76c51a3UL, 0xd192e819UL, 0xd6990624UL, 0xf40e3585UL, 0x106aa070UL,
+   0x19a4c116UL, 0x1e376c08UL, 0x2748774cUL, 0x34b0bcb5UL, 0x391c0cb3UL, 0x4ed8aa4aUL, 0x5b9cca4fUL, 0x682e6ff3UL,
+   0x748f82eeUL, 0x78a5636fUL, 0x84c87814UL, 0x8cc70208UL, 0x90befffaUL, 0xa4506cebUL, 0xbef9a3f7UL, 0xc67178f2UL
+};
+
+
+/**
+ * @brief Processes a whole block of 64 bytes.
+ *
+ * @param sha The state of the digest.
+ * @param block The block.
+ */
+static void process_block(struct Sha256* sha, const unsigned char* block);
+
+
+
+
+static void process_block(struct Sha256* sha, const unsigned char* block) {
+   unsigned long w[64]; /* The message schedule */
+   unsigned long a, b, c, d, e, f, g, h, t1, t2; /* The working variables */
+   int i;
+
+   for (i = 0; i < 16; i++)
+      w[i] = ((unsigned long)block[4 * i] << 24) | ((unsigned long)block[4 * i + 1] << 16) |
+             ((unsigned long)block[4 * i + 2] << 8) | (unsigned long)block[4 * i + 3];
+   for (; i < 64; i++)
+      w[i] = WORD((ROTATE(w[i - 2], 17) ^ ROTATE(w[i - 2], 19) ^ (w[i - 2] >> 10)) + w[i - 7] +
+                  (ROTATE(w[i - 15], 7) ^ ROTATE(w[i - 15], 18) ^ (w[i - 15] >> 3)) + w[i - 16]);
+
+   a = sha->state[0], b = sha->state[1], c = sha->state[2], d = sha->state[3];
+   e = sha->state[4], f = sha->state[5], g = sha->state[6], h = sha->state[7];
+   for (i = 0; i < 64; i++) {
+      t1 = WORD(h + (ROTATE(e, 6) ^ ROTATE(e, 11) ^ ROTATE(e, 25)) + ((e & f) ^ (~e & g)) + round_constants[i] + w[i]);
+      t2 = WORD((ROTATE(a, 2) ^ ROTATE(a, 13) ^ ROTATE(a, 22)) + ((a & b) ^ (a & c) ^ (b & c)));
+      h = g, g = f, f = e, e = WORD(d + t1);
+      d = c, c = b, b = a, a = WORD(t1 + t2);
+   }
+
+   sha->state[0] = WORD(sha->state[0] + a), sha->state[1] = WORD(sha->state[1] + b);
+   sha->state[2] = WORD(sha->state[2] + c), sha->state[3] = WORD(sha->state[3] + d);
+   sha->state[4] = WORD(sha->state[4] + e), sha->state[5] = WORD(sha->state[5] + f);
+   sha->state[6] = WORD(sha->state[6] + g), sha->state[7] = WORD(sha->state[7] + h);
+}
+
+
+
+
+void sha256_init(struct Sha256* sha) {
+   /* The first 32 bits of the fractional parts of the square roots of the first 8 primes */
+   sha->state[0] = 0x6a09e667UL, sha->state[1] = 0xbb67ae85UL, sha->state[2] = 0x3c6ef372UL, sha->state[3] = 0xa54ff53aUL;
+   sha->state[4] = 0x510e527fUL, sha->state[5] = 0x9b05688cUL, sha->state[6] = 0x1f83d9abUL, sha->state[7] = 0x5be0cd19UL;
+   sha->block_size = 0;
+   sha->length_low = 0, sha->length_high = 0;
+}
+
+
+
+
+void sha256_update(struct Sha256* sha, const void* data, size_t length) {
+   const unsigned char* bytes = (const unsigned char*)data; /* The next byte to add */
+   size_t n; /* Number of bytes copied into the block */
+
+   /* Count the bytes in 64 bits, whatever the size of size_t */
+   sha->length_low = WORD(sha->length_low + (unsigned long)(length & 0xFFFFFFFFUL));
+   if (sha->length_low < (unsigned long)(length & 0xFFFFFFFFUL))
+      sha->length_high = WORD(sha->length_high + 1);
+   if (sizeof(size_t) > 4)
+      sha->length_high = WORD(sha->length_high + (unsigned long)((length >> 16) >> 16));
+
+   if (sha->block_size > 0) { /* Complete the block started before */
+      n = SHA256_BLOCK_SIZE - sha->block_size < length ? SHA256_BLOCK_SIZE - sha->block_size : length;
+      memcpy(sha->block + sha->block_size, bytes, n);
+      sha->block_size += n, bytes += n, length -= n;
+      if (sha->block_size < SHA256_BLOCK_SIZE)
+         return;
+      process_block(sha, sha->block);
+      sha->block_size = 0;
+   }
+
+   for (; length >= SHA256_BLOCK_SIZE; bytes += SHA256_BLOCK_SIZE, length -= SHA256_BLOCK_SIZE)
+      process_block(sha, bytes); /* Whole blocks straight from the data */
+
+   memcpy(sha->block, bytes, length);
+   sha->block_size = length;
+}
+
+
+
+
+void sha256_final(struct Sha256* sha, unsigned char* digest) {
+   unsigned long high, low; /* The length of the message in bits */
+   int i;
+
+   high = WORD((sha->length_high << 3) | (sha->length_low >> 29));
+   low = WORD(sha->length_low << 3);
+
+   /* A 1 bit, zeros up to 8 bytes before the end of a block, and the length */
+   sha->block[sha->block_size++] = 0x80;
+   if (sha->block_size > SHA256_BLOCK_SIZE - 8) {
+      memset(sha->block + sha->block_size, 0, SHA256_BLOCK_SIZE - sha->block_size);
+      process_block(sha, sha->block);
+      sha->block_size = 0;
+   }
+   memset(sha->block + sha->block_size, 0, SHA256_BLOCK_SIZE - 8 - sha->block_size);
+   for (i = 0; i < 4; i++) {
+      sha->block[SHA256_BLOCK_SIZE - 8 + i] = (unsigned char)(high >> (24 - 8 * i));
+      sha->block[SHA256_BLOCK_SIZE - 4 + i] = (unsigned char)(low >> (24 - 8 * i));
+   }
+   process_block(sha, sha->block);
+
+   for (i = 0; i < SHA256_DIGEST_SIZE; i++)
+      digest[i] = (unsigned char)(sha->state[i / 4] >> (24 - 8 * (i % 4)));
+}
@@ -0,0 +1,61 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+
+#define SHA256_BLOCK_SIZE 64
+#define SHA256_DIGEST_SIZE 32
+
+
+
+/**
+ * @brief The state of a SHA-256 digest (FIPS 180-4) being computed.
+ * @struct Sha256
+ *
+ * The words are kept in unsigned long and reduced to 32 bits after every operation, so the code
+ * does not need a 32-bit type.
+ *
+ * @param state The eight words of the hash so far.
+ * @param block The bytes of the block not processed yet.
+ * @param block_size The number of bytes in `block`.
+ * @param length_low The low 32 bits of the number of bytes added.
+ * @param length_high The high 32 bits of the number of bytes added.
+ */
+struct Sha256 {
+   unsigned long state[8];
+   unsigned char block[SHA256_BLOCK_SIZE];
+   size_t block_size;
+   unsigned long length_low, length_high;
+};
+
+
+
+/**
+ * @brief Starts a digest.
+ *
+ * @param sha The state to initialize.
+ */
+void sha256_init(struct Sha256* sha);
+
+
+
+/**
+ * @brief Adds bytes to a digest.
+ *
+ * @param sha The state of the digest.
+ * @param data The bytes to add.
+ * @param length The number of bytes.
+ */
+void sha256_update(struct Sha256* sha, const void* data, size_t length);
+
+
+
+/**
+ * @brief Finishes a digest.
+ *
+ * @param sha The state of the digest (not usable afterwards without sha256_init).
+ * @param digest The buffer to fill with the digest (SHA256_DIGEST_SIZE bytes).
+ */
+void sha256_final(struct Sha256* sha, unsigned char* digest);
+
+#endif /* SHA256_H */
@@ -0,0 +1,52 @@
+#ifdef _MSC_VER
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include "word_store.h"
+
+
+
+void word_store_reserve(struct Arena* arena, struct WordStore* store, int count) {
+   int needed = (count + WORD_CHUNK_SIZE - 1) >> WORD_CHUNK_BITS; /* Chunks that hold `count` words */
+   int old_capacity = store->directory_capacity; /* Size of the directory before growing */
+
+   if (needed <= store->chunk_count)
+      return;
+
+   /* Grow the directory: only the pointers to the chunks are copied */
+   if (needed > store->directory_capacity) {
+      if (store->directory_capacity == 0)
+         store->directory_capacity = INITIAL_WORD_DIRECTORY_SIZE;
+      while (needed > store->directory_capacity)
+         store->directory_capacity *= 2;
+      store->chunks = (int**)arena_grow(arena, store->chunks, old_capacity * sizeof(int*), store->directory_capacity * sizeof(int*));
+   }
+
+   /* Add the chunks, zeroed */
+   while (store->chunk_count < needed)
+      store->chunks[store->chunk_count++] = (int*)arena_alloc(arena, WORD_CHUNK_SIZE * sizeof(int));
+}
+
+
+
+void word_store_set(struct Arena* arena, struct WordStore* store, int index, int word) {
+   if ((index >> WORD_CHUNK_BITS) >= store->chunk_count)
+      word_store_reserve(arena, store, index + 1);
+   store->chunks[index >> WORD_CHUNK_BITS][index & WORD_CHUNK_MASK] = word;
+}
+
+
+
+int word_store_get(const struct WordStore* store, int index) {
+   if ((index >> WORD_CHUNK_BITS) >= store->chunk_count)
+      return 0; /* Never stored */
+   return store->chunks[index >> WORD_CHUNK_BITS][index & WORD_CHUNK_MASK];
+}
+
+
+
+int word_store_run(const struct WordStore* store, int start, int end, const int** words) {
+   int length = WORD_CHUNK_SIZE - (start & WORD_CHUNK_MASK); /* Words left in the chunk of `start` */
+
+   *words = store->chunks[start >> WORD_CHUNK_BITS] + (start & WORD_CHUNK_MASK);
+   return end - start < length ? end - start : length;
+}
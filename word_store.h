@@ -0,0 +1,93 @@
+#ifndef WORD_STORE_H
+#define WORD_STORE_H
+
+#include "arena.h"
+
+#define WORD_CHUNK_BITS 12
+#define WORD_CHUNK_SIZE (1 << WORD_CHUNK_BITS) /* Words in a chunk */
+#define WORD_CHUNK_MASK (WORD_CHUNK_SIZE - 1)
+#define INITIAL_WORD_DIRECTORY_SIZE 8
+
+
+
+/**
+ * @brief A growable array of machine words, stored in fixed-size chunks.
+ * @struct WordStore
+ *
+ * The word at index i is in chunk i / WORD_CHUNK_SIZE, at position i % WORD_CHUNK_SIZE. Growing
+ * the store adds chunks and never moves the words already stored, so a pointer to a word stays
+ * valid and nothing is copied, however large the code or data image gets. Only the directory of
+ * chunks (one pointer per chunk) is copied when it grows.
+ *
+ * The chunks and the directory are allocated from an arena and released with it. A zeroed store
+ * is empty and ready to use.
+ *
+ * @param chunks The directory: the chunks of the store, in order.
+ * @param chunk_count The number of chunks allocated.
+ * @param directory_capacity The allocated size of `chunks`.
+ */
+struct WordStore {
+   int** chunks;
+   int chunk_count;
+   int directory_capacity;
+};
+
+
+
+/**
+ * @brief Makes sure a store has room for a number of words, adding zeroed chunks if needed.
+ *
+ * @param arena The arena the store is allocated from.
+ * @param store The store to grow.
+ * @param count The number of words (indexes 0 to count - 1) the store must hold.
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+void word_store_reserve(struct Arena* arena, struct WordStore* store, int count);
+
+
+
+/**
+ * @brief Stores a word, growing the store if the index is past its chunks.
+ *
+ * @param arena The arena the store is allocated from.
+ * @param store The store to write to.
+ * @param index The index of the word.
+ * @param word The value of the word.
+ *
+ * @note The function exits the program with an error message if memory allocation fails.
+ */
+void word_store_set(struct Arena* arena, struct WordStore* store, int index, int word);
+
+
+
+/**
+ * @brief Reads a word from a store.
+ *
+ * @param store The store to read from.
+ * @param index The index of the word.
+ * @return The value of the word, or 0 if it was never stored.
+ */
+int word_store_get(const struct WordStore* store, int index);
+
+
+
+/**
+ * @brief Finds the run of consecutive words that starts at an index, for iterating over a store chunk by chunk.
+ *
+ * The run ends at the end of the chunk of `start`, or at `end` if it comes first:
+ *
+ *    for (i = 0; i < count; i += n) {
+ *       n = word_store_run(store, i, count, &words);
+ *       ... words[0] to words[n - 1] are the words i to i + n - 1 ...
+ *    }
+ *
+ * @param store The store to read from. The words from `start` to `end` - 1 must have been reserved.
+ * @param start The index of the first word of the run.
+ * @param end The index after the last word wanted.
+ * @param words Pointer to store the address of the first word of the run.
+ * @return The number of words in the run.
+ */
+int word_store_run(const struct WordStore* store, int start, int end, const int** words);
+
+#endif /* WORD_STORE_H */